@@ -0,0 +1,207 @@
+#!/usr/bin/env python3
+
+"""
+Measures launch latency of the demo applications.
+
+Each demo app is launched repeatedly in two scenarios:
+
+* cold: with an empty Jaunch cache directory for every run, so that the
+  configurator must run in full, probing runtime installations anew.
+* warm: with a cache directory primed by a previous run, so that the
+  launch cache and installation indices apply.
+
+Every launch is traced via JAUNCH_TRACE (see doc/PERFORMANCE.md), so that
+its wall time can be split into configurator time (from the launcher's
+`run_command` or in-process `jaunch_configure`, or its launch cache lookup) and runtime boot time (from the
+end of configuration until the runtime's main entry point is reached).
+Plain `java` and `python` invocations of equivalent programs are measured
+as baselines.
+
+Results are printed as a table, and written as JSON to the output file.
+"""
+
+import json
+import os
+import platform
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+from argparse import ArgumentParser
+
+# name, command line, standard input
+APPS = [
+    ("hi",     ["./hi"],                     None),
+    ("hiss",   ["./hiss"],                   None),
+    ("paunch", ["./paunch", "-c", "print(1+2)"], None),
+    ("jy",     ["./jy", "-c", "print(1+2)"], None),
+    ("parsy",  ["./parsy"],                  b"1+2\n"),
+]
+
+
+def baselines():
+    """Plain runtime invocations of programs equivalent to the demo apps."""
+    java_home = os.environ.get("JAVA_HOME")
+    java = os.path.join(java_home, "bin", "java") if java_home else shutil.which("java")
+    python = shutil.which("python3") or shutil.which("python")
+    # name, command line, standard input, file required in the demo folder
+    result = []
+    if java:
+        result.append(("java HelloWorld", [java, "-cp", ".", "HelloWorld"], None, "HelloWorld.class"))
+    if python:
+        result.append(("python hi.py", [python, "hi.py"], None, "hi.py"))
+        result.append(("python -c", [python, "-c", "print(1+2)"], None, None))
+    return result
+
+
+def percentile(values, p):
+    """Nearest-rank percentile of the given values."""
+    if not values:
+        return None
+    ordered = sorted(values)
+    rank = max(1, -(-len(ordered) * p // 100))
+    return round(ordered[int(rank) - 1], 3)
+
+
+def summarize(values):
+    return {
+        "p50": percentile(values, 50),
+        "p90": percentile(values, 90),
+        "p99": percentile(values, 99),
+    }
+
+
+def read_trace(path):
+    """Parses a trace file written by Jaunch, which omits the closing bracket."""
+    try:
+        with open(path) as f:
+            text = f.read().strip()
+    except OSError:
+        return []
+    if not text:
+        return []
+    if not text.endswith("]"):
+        text = text.rstrip(",") + "]"
+    return [e for e in json.loads(text) if e.get("ph") == "X"]
+
+
+def split_trace(events):
+    """Splits a launch trace into configurator and runtime boot durations, in ms."""
+    def find(name):
+        return next((e for e in events if e["name"] == name and e.get("cat") != "configurator"), None)
+
+    configure = find("run_command") or find("jaunch_configure") or find("launch cache hit")
+    until_main = find("until main")
+    if configure is None:
+        return None, None
+    configure_end = configure["ts"] + configure["dur"]
+    configurator_ms = configure["dur"] / 1000
+    boot_ms = None
+    if until_main is not None:
+        boot_ms = (until_main["ts"] + until_main["dur"] - configure_end) / 1000
+    return configurator_ms, boot_ms
+
+
+def launch(command, stdin, cwd, env):
+    start = time.perf_counter()
+    proc = subprocess.run(command, cwd=cwd, env=env, input=stdin,
+                          stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+    wall_ms = (time.perf_counter() - start) * 1000
+    if proc.returncode != 0:
+        sys.stderr.write(proc.stderr.decode(errors="replace"))
+        raise RuntimeError(f"{' '.join(command)} exited with code {proc.returncode}")
+    return wall_ms
+
+
+def measure(command, stdin, cwd, runs, cold, traced):
+    walls, configurators, boots = [], [], []
+    with tempfile.TemporaryDirectory(prefix="jaunch-bench-") as work:
+        trace_path = os.path.join(work, "trace.json")
+        cache_dir = os.path.join(work, "cache")
+        env = dict(os.environ)
+        env["JAUNCH_CACHE_DIR"] = cache_dir
+        if traced:
+            env["JAUNCH_TRACE"] = trace_path
+        if not cold:
+            # Prime the caches.
+            launch(command, stdin, cwd, env)
+        for _ in range(runs):
+            if cold:
+                shutil.rmtree(cache_dir, ignore_errors=True)
+            if os.path.exists(trace_path):
+                os.remove(trace_path)
+            walls.append(launch(command, stdin, cwd, env))
+            if traced:
+                configurator_ms, boot_ms = split_trace(read_trace(trace_path))
+                if configurator_ms is not None:
+                    configurators.append(configurator_ms)
+                if boot_ms is not None:
+                    boots.append(boot_ms)
+    result = {"runs": runs, "wall_ms": summarize(walls)}
+    if traced:
+        result["configurator_ms"] = summarize(configurators)
+        result["runtime_boot_ms"] = summarize(boots)
+    return result
+
+
+def fmt(value):
+    return "-" if value is None else f"{value:.1f}"
+
+
+def main():
+    parser = ArgumentParser(description="Measure launch latency of the Jaunch demo apps.")
+    parser.add_argument("--runs", type=int, default=int(os.environ.get("BENCH_RUNS", 20)),
+                        help="number of launches per scenario (default: 20)")
+    parser.add_argument("--demo-dir", default="demo", help="folder of demo apps (default: demo)")
+    parser.add_argument("--out", default=os.path.join("demo", "bench.json"),
+                        help="JSON results file (default: demo/bench.json)")
+    parser.add_argument("apps", nargs="*", help="names of apps to measure (default: all)")
+    args = parser.parse_args()
+
+    apps = [a for a in APPS if not args.apps or a[0] in args.apps]
+    results = {
+        "jaunch": {
+            "git": subprocess.run(["git", "rev-parse", "--short", "HEAD"], capture_output=True,
+                                  text=True).stdout.strip() or None,
+        },
+        "system": {
+            "os": platform.system(),
+            "arch": platform.machine(),
+            "cpus": os.cpu_count(),
+        },
+        "runs": args.runs,
+        "apps": {},
+        "baselines": {},
+    }
+
+    header = f"{'':24} {'scenario':8} {'wall p50/p90/p99 (ms)':>24} {'configurator p50':>17} {'boot p50':>9}"
+    print(header)
+    for name, command, stdin in apps:
+        if not os.path.exists(os.path.join(args.demo_dir, command[0])):
+            print(f"{name:24} (not found; skipping)")
+            continue
+        results["apps"][name] = {}
+        for scenario in ("cold", "warm"):
+            r = measure(command, stdin, args.demo_dir, args.runs, scenario == "cold", True)
+            results["apps"][name][scenario] = r
+            w = r["wall_ms"]
+            print(f"{name:24} {scenario:8} {fmt(w['p50']):>8}/{fmt(w['p90'])}/{fmt(w['p99']):<8}"
+                  f" {fmt(r['configurator_ms']['p50']):>17} {fmt(r['runtime_boot_ms']['p50']):>9}")
+
+    for name, command, stdin, required in baselines():
+        if required and not os.path.exists(os.path.join(args.demo_dir, required)):
+            continue
+        r = measure(command, stdin, args.demo_dir, args.runs, False, False)
+        results["baselines"][name] = r
+        w = r["wall_ms"]
+        print(f"{name:24} {'baseline':8} {fmt(w['p50']):>8}/{fmt(w['p90'])}/{fmt(w['p99']):<8}")
+
+    with open(args.out, "w") as f:
+        json.dump(results, f, indent=2)
+        f.write("\n")
+    print(f"\nResults written to {args.out}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,12 @@
+#!/usr/bin/env bash
+set -e
+cd "$(dirname "$0")/.."
+echo
+echo -e "\033[1;33m[bench]\033[0m"
+
+test -d demo || { echo '[ERROR] No demo folder; please `make demo` first.' 1>&2; exit 1; }
+
+python=$(command -v python3 || command -v python) ||
+  { echo '[ERROR] Please install Python 3 to run the benchmarks.' 1>&2; exit 2; }
+
+"$python" bin/bench.py "$@"
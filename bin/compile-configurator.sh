@@ -25,11 +25,11 @@ set +e
 platform=$(uname -s)
 case "$platform" in
   Linux)
-    (set -x; ./gradlew --no-daemon linkReleaseExecutableLinuxX64 linkReleaseExecutableLinuxArm64)
+    (set -x; ./gradlew --no-daemon linkReleaseExecutableLinuxX64 linkReleaseExecutableLinuxArm64 linkReleaseSharedLinuxX64 linkReleaseSharedLinuxArm64)
     result=$?
     ;;
   Darwin)
-    (set -x; ./gradlew --no-daemon linkReleaseExecutableMacosX64 linkReleaseExecutableMacosArm64)
+    (set -x; ./gradlew --no-daemon linkReleaseExecutableMacosX64 linkReleaseExecutableMacosArm64 linkReleaseSharedMacosX64 linkReleaseSharedMacosArm64)
     result=$?
     if [ "$result" -eq 0 ]
     then
@@ -39,9 +39,17 @@ case "$platform" in
       (set -x; lipo -create -output "$outDir/jaunch.kexe" build/bin/macosArm64/releaseExecutable/jaunch.kexe build/bin/macosX64/releaseExecutable/jaunch.kexe)
       result=$?
     fi
+    if [ "$result" -eq 0 ]
+    then
+      # Likewise for the configurator library.
+      outDir=build/bin/macosUniversal/releaseShared
+      mkdir -p "$outDir"
+      (set -x; lipo -create -output "$outDir/libjaunch.dylib" build/bin/macosArm64/releaseShared/libjaunch.dylib build/bin/macosX64/releaseShared/libjaunch.dylib)
+      result=$?
+    fi
     ;;
   MINGW*|MSYS*)
-    (set -x; ./gradlew --no-daemon linkReleaseExecutableWindows)
+    (set -x; ./gradlew --no-daemon linkReleaseExecutableWindows linkReleaseSharedWindows)
     result=$?
     ;;
   *)
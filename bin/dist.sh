@@ -44,9 +44,21 @@ copyFile build/bin/macosUniversal/releaseExecutable/jaunch.kexe dist/jaunch jaun
 copyFile build/bin/windowsArm64/releaseExecutable/jaunch.exe dist/jaunch jaunch-windows-arm64.exe
 copyFile build/bin/windowsX64/releaseExecutable/jaunch.exe dist/jaunch jaunch-windows-x64.exe
 
-# Copy property extractor helper programs and TOML configuration files.
+# Copy jaunch configurator libraries, named after the corresponding executables.
+# NB: There is no windows-arm64 library, just as there is no windows-arm64
+# configurator executable built here (see doc/BUILD.md); the windows-arm64
+# launcher runs the windows-x64 executable under emulation instead.
+copyFile build/bin/linuxArm64/releaseShared/libjaunch.so dist/jaunch jaunch-linux-arm64.so
+copyFile build/bin/linuxX64/releaseShared/libjaunch.so dist/jaunch jaunch-linux-x64.so
+copyFile build/bin/macosArm64/releaseShared/libjaunch.dylib dist/jaunch jaunch-macos-arm64.dylib
+copyFile build/bin/macosX64/releaseShared/libjaunch.dylib dist/jaunch jaunch-macos-x64.dylib
+copyFile build/bin/macosUniversal/releaseShared/libjaunch.dylib dist/jaunch jaunch-macos.dylib
+copyFile build/bin/windowsX64/releaseShared/jaunch.dll dist/jaunch jaunch-windows-x64.dll
+
+# Copy property extractor and zygote helper programs and TOML configuration files.
 copyFile configs/Props.class dist/jaunch
 copyFile configs/props.py dist/jaunch
+copyFile configs/zygote.py dist/jaunch
 copyFile configs/common.toml dist/jaunch
 copyFile configs/jvm.toml dist/jaunch
 copyFile configs/python.toml dist/jaunch
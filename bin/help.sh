@@ -7,4 +7,5 @@ echo 'Available targets:
 	dist                 - generate Jaunch distribution
 	demo                 - generate example applications
 	test                 - run automated test suite
+	bench                - measure launch latency of example applications
 '
@@ -88,6 +88,14 @@ kotlin {
                 executable {
                     entryPoint = "main"
                 }
+                // The configurator as a library, for the native launcher
+                // to call in-process (see configurator.h). It is unloaded
+                // after a single use, so it must not leave a garbage collector
+                // thread behind -- and a single use needs no collection anyway.
+                sharedLib {
+                    baseName = "jaunch"
+                    binaryOptions["gc"] = "noop"
+                }
             }
         }
     }
@@ -111,3 +119,8 @@ kotlin {
         }
     }
 }
+
+// Let the unit tests see whether to run their microbenchmarks (see TestUtils.kt).
+tasks.withType<org.jetbrains.kotlin.gradle.targets.native.tasks.KotlinNativeTest>().configureEach {
+    System.getenv("JAUNCH_MICROBENCH")?.let { environment("JAUNCH_MICROBENCH", it) }
+}
@@ -7,6 +7,7 @@ installation, including the Python shared library path and other metadata.
 """
 
 import platform
+import site
 import sys
 import sysconfig
 
@@ -79,6 +80,7 @@ props = {
     "sys.executable": sys.executable,
     "sys.version": sys.version,
     "sys.prefix": sys.prefix,
+    "site.user_site": site.getusersitepackages() if site.ENABLE_USER_SITE else None,
 }
 props.update({f"paths.{k}": v for k, v in sysconfig.get_paths().items()})
 props.update({f"cvars.{k}": v for k, v in sysconfig.get_config_vars().items()})
@@ -0,0 +1,200 @@
+"""
+Python zygote for Jaunch.
+
+The launcher runs this script via `python -c`, with the arguments: the
+listening socket's file descriptor, the idle timeout in seconds, and the
+modules to preload (see serve_python in python.h).
+
+For each request accepted (see server.h for the protocol), it forks a
+child, which takes on the client's stdio streams, working directory and
+environment, then runs the script -- or `-c` command, or `-m` module --
+the way the python executable would. Signals the client forwards go to the
+child, as does a SIGHUP if the client dies. When the child exits, the
+zygote replies with its exit code. Requests are served concurrently, each
+in its own process. Requests whose PYTHON* variables differ from those of
+the zygote are refused, since they shape the interpreter before any script
+runs.
+"""
+
+import array, os, select, signal, socket, struct, sys, time, traceback
+server = socket.socket(fileno=int(sys.argv[1]))
+timeout = int(sys.argv[2])
+for name in sys.argv[3:]:
+    try:
+        __import__(name)
+    except Exception:
+        print('[WARNING] Failed to preload module ' + name, file=sys.stderr)
+        traceback.print_exc()
+settings = {k: v for k, v in os.environ.items() if k.startswith('PYTHON')}
+children = {}
+hung_up = set()
+wakeup_r, wakeup_w = os.pipe()
+
+def peer_uid(conn):
+    if hasattr(socket, 'SO_PEERCRED'):
+        return struct.unpack('3i', conn.getsockopt(socket.SOL_SOCKET, socket.SO_PEERCRED, 12))[1]
+    import ctypes
+    uid, gid = ctypes.c_uint32(), ctypes.c_uint32()
+    ok = ctypes.CDLL(None).getpeereid(conn.fileno(), ctypes.byref(uid), ctypes.byref(gid)) == 0
+    return uid.value if ok else -1
+
+def recv_exactly(conn, size, data=b''):
+    data = bytearray(data)
+    while len(data) < size:
+        chunk = conn.recv(min(size - len(data), 1 << 20))
+        if not chunk:
+            raise EOFError
+        data += chunk
+    return bytes(data)
+
+def receive(conn, fds):
+    data, ancillary, _, _ = conn.recvmsg(4, socket.CMSG_SPACE(3 * fds.itemsize))
+    for level, kind, payload in ancillary:
+        if level == socket.SOL_SOCKET and kind == socket.SCM_RIGHTS:
+            fds.frombytes(payload[:len(payload) - len(payload) % fds.itemsize])
+    request = recv_exactly(conn, struct.unpack('<I', recv_exactly(conn, 4, data))[0])
+    if request[:8] != b'\x00JAUNCH2':
+        raise ValueError('malformed request')
+    count, pos, records = struct.unpack_from('<I', request, 8)[0], 12, []
+    for _ in range(count):
+        size = struct.unpack_from('<I', request, pos)[0]
+        records.append(os.fsdecode(request[pos + 4:pos + 4 + size]))
+        pos += 4 + size
+    if pos != len(request):
+        raise ValueError('malformed request')
+    return records
+
+def set_path0(entry):
+    if not (sys.flags.isolated or getattr(sys.flags, 'safe_path', False)):
+        sys.path[0] = entry
+
+def run(conn, fds, cwd, env, argv):
+    code = 1
+    try:
+        server.close()
+        conn.close()
+        signal.set_wakeup_fd(-1)
+        signal.signal(signal.SIGCHLD, signal.SIG_DFL)
+        # NB: Take forwarded signals as python would, even if the zygote ignores them.
+        signal.signal(signal.SIGINT, signal.default_int_handler)
+        signal.signal(signal.SIGTERM, signal.SIG_DFL)
+        signal.signal(signal.SIGHUP, signal.SIG_DFL)
+        os.close(wakeup_r)
+        os.close(wakeup_w)
+        for i, fd in enumerate(fds):
+            os.dup2(fd, i)
+        for fd in fds:
+            if fd > 2:
+                os.close(fd)
+        os.chdir(cwd)
+        os.environ.clear()
+        os.environ.update(env)
+        import runpy
+        if argv[0] == '-c':
+            sys.argv = ['-c'] + argv[2:]
+            set_path0('')
+            exec(compile(argv[1], '<string>', 'exec'), {'__name__': '__main__', '__builtins__': __builtins__})
+        elif argv[0] == '-m':
+            sys.argv = argv[1:]
+            set_path0(os.getcwd())
+            runpy.run_module(argv[1], run_name='__main__', alter_sys=True)
+        else:
+            sys.argv = argv
+            set_path0(os.path.dirname(os.path.abspath(argv[0])))
+            runpy.run_path(argv[0], run_name='__main__')
+        code = 0
+    except SystemExit as e:
+        if e.code is None:
+            code = 0
+        elif isinstance(e.code, int):
+            code = e.code
+        else:
+            print(e.code, file=sys.stderr)
+    except BaseException as e:
+        # NB: Omit the frames of the zygote and runpy, as python itself would.
+        tb = e.__traceback__
+        while tb is not None and (tb.tb_frame.f_globals is globals() or tb.tb_frame.f_globals.get('__name__') == 'runpy'):
+            tb = tb.tb_next
+        traceback.print_exception(type(e), e, tb)
+        # NB: Like python, end by SIGINT after a KeyboardInterrupt.
+        if isinstance(e, KeyboardInterrupt):
+            code = -signal.SIGINT
+    try:
+        import atexit
+        atexit._run_exitfuncs()
+        sys.stdout.flush()
+        sys.stderr.flush()
+    finally:
+        if code == -signal.SIGINT:
+            signal.signal(signal.SIGINT, signal.SIG_DFL)
+            os.kill(os.getpid(), signal.SIGINT)
+        os._exit(code & 0xff)
+
+def handle(conn):
+    fds = array.array('i')
+    try:
+        if peer_uid(conn) != os.getuid():
+            return False
+        request = receive(conn, fds)
+        cwd, count = request[0], int(request[1])
+        env = dict(var.split('=', 1) for var in request[2:2 + count])
+        argv = request[2 + count:]
+        runnable = argv != [] and (argv[0] in ('-c', '-m') or not argv[0].startswith('-'))
+        python_env = {k: v for k, v in env.items() if k.startswith('PYTHON')}
+        accept = len(fds) == 3 and runnable and python_env == settings
+        conn.sendall(b'A' if accept else b'R')
+        if not accept:
+            return False
+        sys.stdout.flush()
+        sys.stderr.flush()
+        pid = os.fork()
+        if pid == 0:
+            run(conn, fds, cwd, env, argv)
+        children[pid] = conn
+        return True
+    except Exception:
+        return False
+    finally:
+        for fd in fds:
+            os.close(fd)
+
+os.set_blocking(wakeup_w, False)
+signal.set_wakeup_fd(wakeup_w)
+signal.signal(signal.SIGCHLD, lambda signum, frame: None)
+deadline = time.monotonic() + timeout
+while children or time.monotonic() < deadline:
+    wait = None if children else max(0, deadline - time.monotonic())
+    watched = [conn for conn in children.values() if conn not in hung_up]
+    ready = select.select([server, wakeup_r] + watched, [], [], wait)[0]
+    if server in ready:
+        conn = server.accept()[0]
+        if not handle(conn):
+            conn.close()
+    if wakeup_r in ready:
+        os.read(wakeup_r, 512)
+    for pid, conn in list(children.items()):
+        if conn in ready:
+            # A signal number forwarded by the client, or nothing if it died.
+            data = conn.recv(4)
+            if len(data) < 4:
+                hung_up.add(conn)
+            signum = struct.unpack('<I', data)[0] if len(data) == 4 else signal.SIGHUP
+            if signum in (signal.SIGINT, signal.SIGTERM, signal.SIGHUP):
+                try:
+                    os.kill(pid, signum)
+                except OSError:
+                    pass
+    for pid in list(children):
+        done, status = os.waitpid(pid, os.WNOHANG)
+        if done == 0:
+            continue
+        conn = children.pop(pid)
+        hung_up.discard(conn)
+        code = os.WEXITSTATUS(status) if os.WIFEXITED(status) else 128 + os.WTERMSIG(status)
+        try:
+            conn.sendall(struct.pack('<I', code))
+        except OSError:
+            pass
+        conn.close()
+    if ready:
+        deadline = time.monotonic() + timeout
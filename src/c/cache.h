@@ -0,0 +1,179 @@
+#ifndef _JAUNCH_CACHE_H
+#define _JAUNCH_CACHE_H
+
+#include <stdio.h>    // for FILE, fopen, fread, fclose, snprintf
+#include <stdlib.h>   // for NULL, size_t, atoi, free, getenv
+#include <string.h>   // for memcpy, memmove, strchr, strcmp, strlen, strncmp
+#include <unistd.h>   // for getcwd
+
+#include "logging.h"
+#include "common.h"
+
+/*
+ * This is the logic implementing Jaunch's launch cache.
+ *
+ * When given a --jaunch-cache=<file> argument, the configurator records its
+ * emitted directives into that file, along with everything those directives
+ * depended upon: the input arguments, the working directory, the environment
+ * variables it consulted, and stamps (mtime, size, inode) of the config files,
+ * .cfg files, and runtime directories it examined. The file looks like:
+ *
+ *     JAUNCH-CACHE-1
+ *     <working directory>
+ *     <number of input arguments>
+ *     <input arguments, one per line>
+ *     <number of environment variables>
+ *     <NAME=value, or just NAME if unset, one per line>
+ *     <number of file stamps>
+ *     <path, then its stamp, on two lines per file>
+ *     <number of output lines>
+ *     <output lines, exactly as the configurator emitted them>
+ *
+ * On subsequent launches, the native launcher validates all of these inputs
+ * itself, and if nothing has changed, it executes the cached directives
+ * directly, without spawning the configurator program at all.
+ */
+
+#define LAUNCH_CACHE_HEADER "JAUNCH-CACHE-1"
+#define LAUNCH_CACHE_FLAG "--jaunch-cache="
+#define LAUNCH_CACHE_SKIP_FLAG "--jaunch-no-cache"
+#define LAUNCH_CACHE_STAMP_MAX 64
+
+/*
+ * Compute the path to the launch cache file for the given configurator input.
+ * Returns a newly allocated string, or NULL if no cache directory is known.
+ */
+char *launch_cache_path(size_t argc, const char **argv) {
+    char *dir = cache_dir();
+    if (dir == NULL) return NULL;
+
+    unsigned long long hash = 14695981039346656037ULL;
+    char *cwd = getcwd(NULL, 0);
+    if (cwd != NULL) hash = fnv1a(hash, cwd);
+    free(cwd);
+    for (size_t i = 0; i < argc; i++) {
+        hash = fnv1a(hash, "\n");
+        hash = fnv1a(hash, argv[i] == NULL ? "" : argv[i]);
+    }
+
+    size_t path_len = strlen(dir) + 32;
+    char *path = (char *)malloc_or_die(path_len, "launch cache path");
+    snprintf(path, path_len, "%s" SLASH "launch-%016llx.txt", dir, hash);
+    free(dir);
+    return path;
+}
+
+/*
+ * Check whether the cached line at the given index matches the expected value,
+ * advancing the index if so. A line count that runs out of bounds never matches.
+ */
+static int cache_line_is(size_t *index, size_t count, char **lines, const char *expected) {
+    if (*index >= count || expected == NULL || strcmp(lines[*index], expected) != 0) return 0;
+    (*index)++;
+    return 1;
+}
+
+/* Parse a cached count line, advancing the index. Returns -1 if invalid. */
+static long cache_count(size_t *index, size_t count, char **lines) {
+    if (*index >= count) return -1;
+    char *end;
+    long value = strtol(lines[(*index)++], &end, 10);
+    return *end == '\0' && value >= 0 ? value : -1;
+}
+
+/* Check whether a cached NAME=value (or NAME if unset) line matches the environment. */
+static int cache_env_matches(const char *line) {
+    const char *equals = strchr(line, '=');
+    if (equals == NULL) return getenv(line) == NULL;
+
+    size_t name_len = (size_t)(equals - line);
+    char *name = (char *)malloc_or_die(name_len + 1, "cached env name");
+    memcpy(name, line, name_len);
+    name[name_len] = '\0';
+    const char *value = getenv(name);
+    free(name);
+    return value != NULL && strcmp(value, equals + 1) == 0;
+}
+
+/*
+ * Load the cached directives for the given configurator input, if still valid.
+ *
+ * Returns 1 on a cache hit, in which case out_argc and out_argv are populated
+ * exactly as run_command would have populated them. Returns 0 on a cache miss.
+ */
+int launch_cache_load(const char *cache_path,
+    size_t argc, const char **argv,
+    size_t *out_argc, char ***out_argv)
+{
+    size_t length;
+    char *contents = read_file(cache_path, &length);
+    if (contents == NULL) {
+        LOG_DEBUG("CACHE", "No launch cache at %s", cache_path);
+        return 0;
+    }
+
+    size_t count = 0;
+    char **lines = parse_output(contents, length, &count);
+
+    const char *reason = NULL;
+    size_t index = 0;
+    char *cwd = getcwd(NULL, 0);
+    char stamp[LAUNCH_CACHE_STAMP_MAX];
+    long n;
+
+    if (!cache_line_is(&index, count, lines, LAUNCH_CACHE_HEADER)) {
+        reason = "unknown format";
+    }
+    else if (!cache_line_is(&index, count, lines, cwd)) {
+        reason = "working directory differs";
+    }
+    else if ((n = cache_count(&index, count, lines)) != (long)argc) {
+        reason = "argument count differs";
+    }
+    else {
+        for (size_t i = 0; i < argc && reason == NULL; i++) {
+            if (!cache_line_is(&index, count, lines, argv[i])) reason = "arguments differ";
+        }
+    }
+    if (reason == NULL) {
+        n = cache_count(&index, count, lines);
+        if (n < 0 || index + (size_t)n > count) reason = "invalid environment block";
+        for (long i = 0; i < n && reason == NULL; i++) {
+            if (!cache_env_matches(lines[index++])) reason = "environment differs";
+        }
+    }
+    if (reason == NULL) {
+        n = cache_count(&index, count, lines);
+        if (n < 0 || index + 2 * (size_t)n > count) reason = "invalid stamps block";
+        for (long i = 0; i < n && reason == NULL; i++) {
+            const char *path = lines[index++];
+            file_stamp(path, stamp, sizeof(stamp));
+            if (!cache_line_is(&index, count, lines, stamp)) {
+                LOG_DEBUG("CACHE", "Stale: %s [%s]", path, stamp);
+                reason = "files changed";
+            }
+        }
+    }
+    if (reason == NULL) {
+        n = cache_count(&index, count, lines);
+        if (n < 1 || index + (size_t)n != count) reason = "invalid output block";
+    }
+    free(cwd);
+
+    if (reason != NULL) {
+        LOG_INFO("CACHE", "Ignoring launch cache %s: %s", cache_path, reason);
+        free(lines);
+        return 0;
+    }
+
+    // Hand over the output lines, dropping the bookkeeping ones from the array.
+    // The arena is kept whole, so that it is still released with a single free.
+    *out_argc = (size_t)n;
+    memmove(lines, lines + index, n * sizeof(char *));
+    *out_argv = lines;
+
+    LOG_INFO("CACHE", "Using cached launch directives from %s", cache_path);
+    return 1;
+}
+
+#endif
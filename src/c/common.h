@@ -1,8 +1,10 @@
 #ifndef _JAUNCH_COMMON_H
 #define _JAUNCH_COMMON_H
 
+#include <stdint.h>   // for SIZE_MAX, uint32_t
+#include <stdio.h>    // for FILE, fopen, fread, fclose
 #include <stdlib.h>   // for NULL, size_t
-#include <string.h>   // for strcat, strdup, strlen, strtok
+#include <string.h>   // for memcmp, memcpy, memmove, strcat, strlen
 #include <signal.h>   // for signal
 
 
@@ -28,6 +30,8 @@
 #define ERROR_MISSING_FUNCTION 18
 #define ERROR_BAD_LOCKING 19
 #define ERROR_RUNTIME_CRASH 20
+#define ERROR_SERVER 21
+#define ERROR_THREAD_CREATE 22
 
 // ===========================================================
 //           PLATFORM-SPECIFIC FUNCTION DECLARATIONS
@@ -36,17 +40,25 @@
 
 // Implementations in posix.h, win32.h
 void *lib_open(const char *path);
+void *lib_open_local(const char *path);
 void *lib_sym(void *library, const char *symbol);
 void lib_close(void *library);
 char *lib_error();
 char *canonical_path(const char *path);
+void file_stamp(const char *path, char *stamp, size_t len);
+void file_prefetch(const char *path);
+void file_mark_used(const char *path);
+long long monotonic_micros();
 void run_command(const char *command,
     size_t numInput, const char *input[],
     size_t *numOutput, char ***output);
+void run_command_wait();
+int run_process(const char *command, const char *argv[]);
 
 // Implementations in linux.h, macos.h, win32.h
 void setup(const int argc, const char *argv[]);
 void teardown();
+char *cache_dir();
 void runloop_config(const char *directive);
 void runloop_run(const char *mode);
 void runloop_stop();
@@ -56,6 +68,12 @@ typedef int (*LaunchFunc)(const size_t, const char **);
 int launch(const LaunchFunc launch_func,                 // JVM, PYTHON
     const size_t argc, const char **argv);
 
+// Implementations in preload.h, prefetch.h
+void *runtime_lib_open(const char *path);
+void preload_wait();
+void prefetch_jvm(const char *libjvm_path, size_t jvm_argc, const char **jvm_argv);
+void prefetch_record();
+
 // ===========================================================
 //                      UTILITY FUNCTIONS
 // ===========================================================
@@ -64,8 +82,8 @@ int launch(const LaunchFunc launch_func,                 // JVM, PYTHON
     LOG_DEBUG(component, "%s_argc = %zu", (name), (argc)); \
     if ((argc) < (min) || (argc) > (max)) \
         DIE(ERROR_ARGC_OUT_OF_BOUNDS, \
-            "Error: %s_argc value %d is out of bounds [%d, %d]", \
-            (name), (argc), (min), (max)); \
+            "Error: %s_argc value %zu is out of bounds [%zu, %zu]", \
+            (name), (size_t)(argc), (size_t)(min), (size_t)(max)); \
     for (size_t a = 0; a < (argc); a++) \
         LOG_DEBUG(component, "%s_argv[%zu] = %s", (name), a, (argv)[a]); \
 } while (0)
@@ -76,38 +94,69 @@ void *malloc_or_die(size_t length, const char *where) {
     return result;
 }
 
+/* Ensures that a dynamically growing buffer has room for the given number of additional bytes. */
+void reserve_buffer(char **buffer, size_t *bufferSize, size_t totalBytes, size_t dataSize) {
+    if (totalBytes + dataSize < *bufferSize) return;
+    size_t newSize = *bufferSize;
+    while (totalBytes + dataSize >= newSize) newSize *= 2;
+    *buffer = realloc(*buffer, newSize);
+    if (*buffer == NULL) {
+        DIE(ERROR_REALLOC, "Failed to reallocate memory (reserve_buffer)");
+    }
+    *bufferSize = newSize;
+}
+
 /* Appends data to a dynamically growing buffer, reallocating as needed. */
 void append_to_buffer(char **buffer, size_t *bufferSize, size_t *totalBytes,
     const char *data, size_t dataSize)
 {
-    if (*totalBytes + dataSize >= *bufferSize) {
-        *bufferSize *= 2;
-        *buffer = realloc(*buffer, *bufferSize);
-        if (*buffer == NULL) {
-            DIE(ERROR_REALLOC, "Failed to reallocate memory (append_to_buffer)");
-        }
-    }
+    reserve_buffer(buffer, bufferSize, *totalBytes, dataSize);
     memcpy(*buffer + *totalBytes, data, dataSize);
     *totalBytes += dataSize;
 }
 
-/* Splits an output buffer into lines. */
-void split_lines(char *buffer, char *delim, char ***output, size_t *numOutput) {
-    size_t lineCount = 0;
-    char *token = strtok(buffer, delim);
-    while (token != NULL) {
-        *output = realloc(*output, (lineCount + 1) * sizeof(char *));
-        if (*output == NULL) {
-            DIE(ERROR_REALLOC, "Failed to reallocate memory (split lines)");
-        }
-        (*output)[lineCount] = strdup(token);
-        if ((*output)[lineCount] == NULL) {
-            DIE(ERROR_STRDUP, "Failed to duplicate string");
-        }
-        lineCount++;
-        token = strtok(NULL, delim);
+/*
+ * Reads the given file fully into a newly allocated, null-terminated buffer,
+ * storing the number of bytes read into *length.
+ */
+static char *read_file(const char *path, size_t *length) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) return NULL;
+
+    char buffer[4096];
+    size_t bytesRead;
+    size_t totalBytesRead = 0;
+    size_t bufferSize = sizeof(buffer);
+    char *contents = malloc_or_die(bufferSize, "read_file");
+    while ((bytesRead = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        append_to_buffer(&contents, &bufferSize, &totalBytesRead, buffer, bytesRead);
+    }
+    fclose(fp);
+    contents[totalBytesRead] = '\0';
+    *length = totalBytesRead;
+    return contents;
+}
+
+/*
+ * Gets the cache directory named by the JAUNCH_CACHE_DIR environment variable,
+ * which overrides the platform's default (see cache_dir), or NULL if unset.
+ * Returns a newly allocated string.
+ */
+static char *cache_dir_override() {
+    const char *dir = getenv("JAUNCH_CACHE_DIR");
+    if (dir == NULL || dir[0] == '\0') return NULL;
+    char *copy = malloc_or_die(strlen(dir) + 1, "cache dir");
+    strcpy(copy, dir);
+    return copy;
+}
+
+/* Folds the given string into a 64-bit FNV-1a hash. */
+static unsigned long long fnv1a(unsigned long long hash, const char *s) {
+    for (; *s != '\0'; s++) {
+        hash ^= (unsigned char)*s;
+        hash *= 1099511628211ULL;
     }
-    *numOutput = lineCount;
+    return hash;
 }
 
 /* Joins strings with the given delimiter. Returns newly allocated string. */
@@ -134,6 +183,169 @@ char *join_strings(const char **strings, size_t count, const char *delim) {
     return result;
 }
 
+// ===========================================================
+//               LAUNCHER/CONFIGURATOR PROTOCOL
+// ===========================================================
+
+/*
+ * The native launcher passes its input arguments to the configurator on
+ * stdin, and receives the configurator's output on stdout. In the original
+ * text protocol, the input is the number of arguments followed by one
+ * argument per line, and the output is one string per line -- so that no
+ * string can contain a newline, nor be empty.
+ *
+ * When the configurator is invoked with PROTOCOL_FLAG after its `-` argument,
+ * it uses length-prefixed binary records in both directions instead:
+ *
+ *     input:  PROTOCOL_HEADER <u32 record count> <records>
+ *     output: PROTOCOL_HEADER <records, until the end of the stream
+ *                              or a PROTOCOL_FINAL record>
+ *
+ * where each record is a u32 byte length followed by that many bytes of
+ * UTF-8 (with no terminator), and each u32 is little-endian. The launcher
+ * recognizes binary output by its header, and otherwise parses it as text.
+ *
+ * The PROTOCOL_FINAL record -- which, containing a NUL, is no valid string --
+ * declares the output complete before the configurator exits, so that the
+ * launcher can begin executing directives while the configurator finishes up.
+ */
+
+#define PROTOCOL_FLAG "--jaunch-protocol=2"
+#define PROTOCOL_HEADER "\0JAUNCH2"
+#define PROTOCOL_HEADER_LEN 8
+#define PROTOCOL_FINAL "\0FINAL"
+#define PROTOCOL_FINAL_LEN 6
+
+static uint32_t read_u32(const char *p) {
+    const unsigned char *b = (const unsigned char *)p;
+    return (uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24;
+}
+
+static char *write_u32(char *p, uint32_t value) {
+    for (int i = 0; i < 4; i++) p[i] = (char)((value >> (8 * i)) & 0xff);
+    return p + 4;
+}
+
+/*
+ * Encodes the given strings as binary protocol input for the configurator.
+ * Returns a newly allocated buffer, whose size is stored into *length.
+ */
+char *encode_records(size_t count, const char **records, size_t *length) {
+    size_t total = PROTOCOL_HEADER_LEN + 4;
+    for (size_t i = 0; i < count; i++) total += 4 + strlen(records[i]);
+
+    char *buffer = (char *)malloc_or_die(total, "encoded records");
+    memcpy(buffer, PROTOCOL_HEADER, PROTOCOL_HEADER_LEN);
+    char *p = write_u32(buffer + PROTOCOL_HEADER_LEN, (uint32_t)count);
+    for (size_t i = 0; i < count; i++) {
+        size_t len = strlen(records[i]);
+        p = write_u32(p, (uint32_t)len);
+        memcpy(p, records[i], len);
+        p += len;
+    }
+    *length = total;
+    return buffer;
+}
+
+/*
+ * Scans the complete records of the given binary configurator output, from
+ * offset *scanned onward, for the PROTOCOL_FINAL record, advancing *scanned
+ * past the records checked. Returns the offset of the final record, or 0 if
+ * there is none yet (or the output is not binary).
+ */
+static size_t find_final_record(const char *buffer, size_t length, size_t *scanned) {
+    if (length < PROTOCOL_HEADER_LEN || memcmp(buffer, PROTOCOL_HEADER, PROTOCOL_HEADER_LEN) != 0) return 0;
+    size_t pos = *scanned < PROTOCOL_HEADER_LEN ? PROTOCOL_HEADER_LEN : *scanned;
+    while (length - pos >= 4 && read_u32(buffer + pos) <= length - pos - 4) {
+        size_t len = read_u32(buffer + pos);
+        if (len == PROTOCOL_FINAL_LEN && memcmp(buffer + pos + 4, PROTOCOL_FINAL, len) == 0) return pos;
+        pos += 4 + len;
+    }
+    *scanned = pos;
+    return 0;
+}
+
+static int is_line_break(char c) { return c == '\n' || c == '\r'; }
+
+/*
+ * Parses configurator output -- binary records or text lines -- into an array of strings.
+ *
+ * The given buffer, which must have room for at least length + 1 bytes, becomes
+ * an arena holding both the array and the strings: it is reallocated with the
+ * array of string pointers at its front, and the strings are terminated in
+ * place, with nothing copied individually. The result must be released with
+ * a single call to free. Returns NULL if there are no strings at all, in which
+ * case the buffer is freed already.
+ */
+char **parse_output(char *buffer, size_t length, size_t *count) {
+    const int binary = length >= PROTOCOL_HEADER_LEN &&
+        memcmp(buffer, PROTOCOL_HEADER, PROTOCOL_HEADER_LEN) == 0;
+    const size_t start = binary ? PROTOCOL_HEADER_LEN : 0;
+
+    // First pass: count the strings.
+    size_t n = 0;
+    if (binary) {
+        // NB: Anything after a final record is no longer part of the launch.
+        size_t scanned = 0, final = find_final_record(buffer, length, &scanned);
+        if (final > 0) length = final;
+        size_t pos = start;
+        while (length - pos >= 4 && read_u32(buffer + pos) <= length - pos - 4) {
+            pos += 4 + read_u32(buffer + pos);
+            n++;
+        }
+        if (pos != length) {
+            LOG_ERROR("Ignoring %zu bytes of truncated configurator output.", length - pos);
+            length = pos;
+        }
+    }
+    else {
+        for (size_t i = 0; i < length; i++) {
+            if (is_line_break(buffer[i])) continue;
+            n++;
+            while (i + 1 < length && !is_line_break(buffer[i + 1])) i++;
+        }
+    }
+    *count = n;
+    if (n == 0) {
+        free(buffer);
+        return NULL;
+    }
+
+    // Make room for the string pointers at the front of the arena.
+    const size_t array_size = n * sizeof(char *);
+    char *arena = realloc(buffer, array_size + length + 1);
+    if (arena == NULL) DIE(ERROR_REALLOC, "Failed to reallocate memory (parse_output)");
+    memmove(arena + array_size, arena, length);
+    char **strings = (char **)arena;
+    char *data = arena + array_size;
+    data[length] = '\0';
+
+    // Second pass: point at the strings, terminating each one in place.
+    size_t index = 0;
+    if (binary) {
+        // NB: Each string's terminator overwrites the first byte of the
+        // following length prefix, so that length must be read beforehand.
+        size_t pos = start;
+        size_t len = read_u32(data + pos);
+        for (; index < n; index++) {
+            strings[index] = data + pos + 4;
+            const size_t next = pos + 4 + len;
+            const size_t next_len = index + 1 < n ? read_u32(data + next) : 0;
+            data[next] = '\0';
+            pos = next;
+            len = next_len;
+        }
+    }
+    else {
+        for (size_t i = 0; i < length; i++) {
+            if (is_line_break(data[i])) { data[i] = '\0'; continue; }
+            strings[index++] = data + i;
+            while (i + 1 < length && !is_line_break(data[i + 1])) i++;
+        }
+    }
+    return strings;
+}
+
 // ===========================================================
 //                       CRASH HANDLING
 // ===========================================================
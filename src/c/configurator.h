@@ -0,0 +1,109 @@
+#ifndef _JAUNCH_CONFIGURATOR_H
+#define _JAUNCH_CONFIGURATOR_H
+
+#include <stdlib.h>   // for NULL, size_t, free
+#include <string.h>   // for memcpy, strcmp, strcpy, strlen
+
+#include "logging.h"
+#include "common.h"
+#include "trace.h"
+
+/*
+ * This is the logic for running the configurator in-process.
+ *
+ * Besides its executable, the configurator can be built as a shared library
+ * (see bin/compile-configurator.sh), named like the executable but with the
+ * platform's library suffix, e.g. jaunch-linux-x64.so beside jaunch-linux-x64.
+ * The library exports a single entry point:
+ *
+ *     int jaunch_configure(size_t argc, const char **argv,
+ *         size_t *out_argc, char ***out_argv)
+ *
+ * which accepts the same arguments as the configurator executable receives on
+ * its stdin, and yields the same lines as it would emit on its stdout, in one
+ * arena as parse_output yields them (see common.h).
+ *
+ * Calling the library is opt-in, via the --jaunch-library flag: once called,
+ * the library stays loaded for the life of the process -- the Kotlin Native
+ * runtime does not support being unloaded, and the threads it started for the
+ * configurator may still be tearing down after the call -- so it lingers in
+ * the JVM or Python process that the launcher goes on to become. By default,
+ * the launcher therefore spawns the executable. With the flag, the launcher
+ * calls the library instead, falling back to spawning the executable if the
+ * library is missing or unusable.
+ */
+
+#define CONFIGURATOR_ENTRY "jaunch_configure"
+#define CONFIGURATOR_LIB_FLAG "--jaunch-library"
+
+typedef int (*ConfigureFunc)(size_t, const char **, size_t *, char ***);
+
+/*
+ * Compute the path to the configurator library corresponding to the
+ * given configurator executable. Returns a newly allocated string.
+ */
+char *configurator_library_path(const char *command) {
+    size_t base_len = strlen(command);
+    size_t suffix_len = strlen(EXE_SUFFIX);
+    if (base_len >= suffix_len && strcmp(command + base_len - suffix_len, EXE_SUFFIX) == 0) {
+        base_len -= suffix_len;
+    }
+    char *lib_path = (char *)malloc_or_die(base_len + strlen(LIB_SUFFIX) + 1, "configurator library path");
+    memcpy(lib_path, command, base_len);
+    strcpy(lib_path + base_len, LIB_SUFFIX);
+    return lib_path;
+}
+
+/*
+ * Run the configurator in-process, via its shared library, if available.
+ *
+ * Returns 1 on success, in which case out_argc and out_argv are populated
+ * exactly as run_command would have populated them. Returns 0 if there is
+ * no usable library, in which case the configurator must be run as usual.
+ */
+int configure_in_process(const char *command,
+    size_t argc, const char **argv,
+    size_t *out_argc, char ***out_argv)
+{
+    char *lib_path = configurator_library_path(command);
+    if (!file_exists(lib_path)) {
+        LOG_DEBUG("CONFIG", "No configurator library at %s", lib_path);
+        free(lib_path);
+        return 0;
+    }
+
+    long long trace_start = trace_now();
+    void *library = lib_open(lib_path);
+    trace_span("launcher", "lib_open", trace_start, lib_path);
+    if (library == NULL) {
+        LOG_INFO("CONFIG", "Failed to load configurator library %s: %s", lib_path, lib_error());
+        free(lib_path);
+        return 0;
+    }
+    ConfigureFunc configure = (ConfigureFunc)lib_sym(library, CONFIGURATOR_ENTRY);
+    if (configure == NULL) {
+        LOG_INFO("CONFIG", "No %s function in configurator library %s", CONFIGURATOR_ENTRY, lib_path);
+        lib_close(library);
+        free(lib_path);
+        return 0;
+    }
+
+    LOG_INFO("CONFIG", "Running configurator in-process from %s", lib_path);
+    trace_start = trace_now();
+    *out_argc = 0;
+    *out_argv = NULL;
+    int result = configure(argc, argv, out_argc, out_argv);
+    trace_span("launcher", "jaunch_configure", trace_start, lib_path);
+
+    // NB: The library is deliberately left loaded; see the top of this file.
+    free(lib_path);
+
+    if (result != 0) {
+        LOG_INFO("CONFIG", "In-process configurator failed with code %d", result);
+        free(*out_argv);
+        return 0;
+    }
+    return 1;
+}
+
+#endif
@@ -45,12 +45,13 @@
 
 #include <pthread.h>  // for pthread_create, pthread_join, etc.
 #include <stdlib.h>   // for NULL, size_t, atoi, free
-#include <string.h>   // for strcat, strcmp, strlen, strncpy, strrchr
+#include <string.h>   // for strcat, strcmp, strcpy, strlen, strncpy, strrchr
 #include <unistd.h>   // for chdir
 
 #include "logging.h"
 #include "common.h"
 #include "thread.h"
+#include "trace.h"
 
 // -- RUNTIMES --
 
@@ -77,12 +78,22 @@
     #define OS_ARCH "arm64"
 #endif
 
+// -- FEATURES --
+
+#include "cache.h"
+#include "configurator.h"
+#include "prefetch.h"
+#include "preload.h"
+
 // -- GLOBAL STATE DEFINITIONS --
 
 int log_level = 0;             // see logging.h
 int headless_mode = 0;         // see logging.h
 int do_console_check = 1;      // see logging.h, win32.h
 ThreadContext *context = NULL; // see thread.h
+FILE *trace_file = NULL;       // see trace.h
+long long trace_origin = 0;    // see trace.h
+int server_timeout = 0;        // see server.h
 
 // -- CONSTANTS --
 
@@ -187,9 +198,24 @@ int execute_directive(const char *directive, size_t dir_argc, const char **dir_a
     FAIL(ERROR_UNKNOWN_DIRECTIVE, "Unknown directive: %s", directive);
 }
 
+/*
+ * Check whether the given directive may run on a worker thread, concurrently
+ * with the directives after it. Runtime launches may, unless the runloop mode
+ * binds them to the main thread.
+ */
+static int async_capable(const char *directive) {
+    if (strcmp(directive, "JVM") != 0 && strcmp(directive, "PYTHON") != 0) return 0;
+    const char *mode = ctx_get_runloop_mode();
+    return mode == NULL || strcmp(mode, "park") == 0;
+}
+
 /*
  * Process all directives in sequence. This function runs on a separate thread and
  * coordinates with the main thread for runloop management and directive execution.
+ *
+ * A directive whose name ends in ASYNC_MARKER (e.g. JVM&) is instead queued
+ * for a worker thread, to run concurrently with the directives after it,
+ * until a WAIT directive -- or the end of the directives -- waits for it.
  */
 void *process_directives(void *unused) {
     // Save directives thread ID for thread detection.
@@ -198,6 +224,7 @@ void *process_directives(void *unused) {
     ctx_unlock();
 
     int exit_code = SUCCESS;
+    const char *last_directive = NULL;
 
     size_t index = 0;
     ctx_lock();
@@ -207,7 +234,7 @@ void *process_directives(void *unused) {
 
     while (index < out_argc) {
         // Prepare the (argc, argv) for the next directive.
-        const char *directive = out_argv[index];
+        char *directive = out_argv[index];
 
         // Honor the special ABORT directive immediately (no further parsing).
         if (strcmp(directive, "ABORT") == 0) {
@@ -221,9 +248,21 @@ void *process_directives(void *unused) {
         }
         const size_t dir_argc = atoi(out_argv[index + 1]);
         const char **dir_argv = (const char **)(out_argv + index + 2);
-        CHECK_ARGS("JAUNCH", "dir", dir_argc, 0, out_argc - index, dir_argv);
+        CHECK_ARGS("JAUNCH", "dir", dir_argc, 0, out_argc - index - 2, dir_argv);
         index += 2 + dir_argc; // Advance index past this directive block.
 
+        // Strip the marker of an asynchronous directive.
+        size_t name_len = strlen(directive);
+        int async = name_len > 1 && directive[name_len - 1] == ASYNC_MARKER;
+        if (async) directive[name_len - 1] = '\0';
+
+        // Honor the WAIT directive: a barrier for all asynchronous directives before it.
+        if (strcmp(directive, "WAIT") == 0) {
+            LOG_INFO("JAUNCH", "Waiting for asynchronous directives");
+            exit_code |= ctx_await_async();
+            continue;
+        }
+
         // If no runloop mode is set, give the platform a chance to set one.
         if (ctx_get_runloop_mode() == NULL) {
             runloop_config(directive);
@@ -243,6 +282,14 @@ void *process_directives(void *unused) {
 
         // Determine execution context and execute directive.
         int error_code;
+        if (async && async_capable(directive)) {
+            // Queue the directive for a worker thread; ctx_await_async reports its result.
+            LOG_INFO("JAUNCH", "Queuing %s directive for a worker thread", directive);
+            ctx_submit_async(execute_directive, directive, dir_argc, dir_argv);
+            last_directive = directive;
+            continue;
+        }
+        if (async) LOG_INFO("JAUNCH", "Executing %s directive synchronously, as it cannot run on a worker thread", directive);
         if (ctx_main_thread_available()) {
             // Main thread is available for directive execution.
             LOG_INFO("JAUNCH", "Executing %s directive on main thread", directive);
@@ -261,12 +308,24 @@ void *process_directives(void *unused) {
             LOG_INFO("JAUNCH", "%s directive failed with code %d, continuing with remaining directives", directive, error_code);
             exit_code |= error_code; // Remember non-zero error code bits.
         }
+        last_directive = directive;
     }
 
+    // Wait for any asynchronous directives still running.
+    exit_code |= ctx_await_async();
+
+    // Finalize Python first, since a fast exit of the JVM would skip its atexit handlers.
+    cleanup_python();
+
+    // Let the configurator finish up, before the process may exit.
+    run_command_wait();
+
+    // After a final JVM directive, the JVM may be set to exit the process directly.
+    if (last_directive != NULL && strcmp(last_directive, "JVM") == 0) exit_jvm_fast(exit_code);
+
     // Cleanup all runtime instances after processing all directives.
     LOG_INFO("JAUNCH", "All directives processed, cleaning up runtimes");
     cleanup_jvm();
-    cleanup_python();
 
     // Stop any active runloop.
     runloop_stop();
@@ -309,6 +368,7 @@ int main(const int argc, const char *argv[]) {
     LOG_SET_LEVEL(argc, argv);
 
     ctx_create();
+    trace_init();
 
     // Install crash handler early to catch any runtime aborts.
     install_crash_handler();
@@ -321,7 +381,11 @@ int main(const int argc, const char *argv[]) {
     // Resolve argv[0] to canonical path (following symlinks).
     char *exe_path = argc == 0 ? NULL : canonical_path(argv[0]);
 
+    // Load the runtime library of the previous launch while we configure.
+    preload_start(exe_path);
+
     // Walk up directory tree looking for the configurator.
+    long long trace_start = trace_now();
     char *command = NULL;
     char *current_path = exe_path;
     const int max_levels = 10;
@@ -399,15 +463,18 @@ int main(const int argc, const char *argv[]) {
         DIE(ERROR_COMMAND_PATH, "Failed to locate jaunch configurator program.");
     }
     LOG_INFO("JAUNCH", "Configurator command: %s", command);
+    trace_span("launcher", "find configurator", trace_start, command);
 
     // Prepend original arguments with needed internal arguments:
     // 1. Configurator path (so the configurator knows where it lives,
     //    enabling it to find the config directory relative to itself).
     // 2. Target architecture override (for macos-arm64 and windows-arm64
     //    to launch in emulated x86-64 mode as appropriate).
+    // And append one more, if available:
+    // 3. Launch cache path (so the configurator can record its output
+    //    for reuse by subsequent launches; see cache.h).
     const int internal_argc = 2;
-    const int extended_argc = internal_argc + argc;
-    const char **extended_argv = malloc_or_die(extended_argc * sizeof(char *), "extended argv");
+    const char **extended_argv = malloc_or_die((internal_argc + argc + 1) * sizeof(char *), "extended argv");
 
     // Build --jaunch-configurator=<path> argument.
     size_t configurator_arg_len = strlen("--jaunch-configurator=") + strlen(command) + 1;
@@ -415,28 +482,60 @@ int main(const int argc, const char *argv[]) {
     strcpy(configurator_arg, "--jaunch-configurator=");
     strcat(configurator_arg, command);
 
-    extended_argv[0] = exe_path;
-    extended_argv[1] = configurator_arg;
-    extended_argv[2] = "--jaunch-target-arch=" OS_ARCH;
+    size_t extended_argc = 0;
+    extended_argv[extended_argc++] = exe_path;
+    extended_argv[extended_argc++] = configurator_arg;
+    extended_argv[extended_argc++] = "--jaunch-target-arch=" OS_ARCH;
+    int use_cache = exe_path != NULL;
+    int use_library = 0;
     for (int i = 1; i < argc; i++) {
-        extended_argv[internal_argc + i] = argv[i];
+        // The --jaunch-no-cache, --jaunch-library and --jaunch-server
+        // flags are for us, not for the configurator.
+        if (strcmp(argv[i], LAUNCH_CACHE_SKIP_FLAG) == 0) use_cache = 0;
+        else if (strcmp(argv[i], CONFIGURATOR_LIB_FLAG) == 0) use_library = 1;
+        else if (server_parse_flag(argv[i])) continue;
+        else extended_argv[extended_argc++] = argv[i];
     }
 
-    // Run external command to process the command line arguments.
+    // Reuse the directives of a previous identical launch, if still valid.
+    // Otherwise, run external command to process the command line arguments.
     size_t out_argc;
     char **out_argv;
-    run_command((const char *)command, extended_argc, extended_argv, &out_argc, &out_argv);
+    trace_start = trace_now();
+    char *cache_path = exe_path == NULL ? NULL : launch_cache_path(extended_argc, extended_argv);
+    if (use_cache && cache_path != NULL &&
+        launch_cache_load(cache_path, extended_argc, extended_argv, &out_argc, &out_argv))
+    {
+        LOG_INFO("JAUNCH", "Skipping configurator thanks to launch cache");
+        trace_span("launcher", "launch cache hit", trace_start, cache_path);
+    }
+    else {
+        char *cache_arg = NULL;
+        if (cache_path != NULL) {
+            cache_arg = (char *)malloc_or_die(strlen(LAUNCH_CACHE_FLAG) + strlen(cache_path) + 1, "cache arg");
+            strcpy(cache_arg, LAUNCH_CACHE_FLAG);
+            strcat(cache_arg, cache_path);
+            extended_argv[extended_argc++] = cache_arg;
+        }
+        trace_span("launcher", "launch cache miss", trace_start, cache_path);
+        if (!use_library || !configure_in_process(command, extended_argc, extended_argv, &out_argc, &out_argv)) {
+            trace_start = trace_now();
+            run_command((const char *)command, extended_argc, extended_argv, &out_argc, &out_argv);
+            trace_span("launcher", "run_command", trace_start, command);
+        }
+        if (cache_arg != NULL) free(cache_arg);
+    }
+    if (cache_path != NULL) free(cache_path);
     if (exe_path != NULL) free(exe_path);
     free(configurator_arg);
     free(extended_argv);
     free(command);
 
-    CHECK_ARGS("JAUNCH", "out", out_argc, 1, 99999, out_argv);
-    // Maximum # of lines to treat as valid. ^^^^^
-    // We could of course leave this unbounded, but pragmatically, the value
-    // will probably never exceed this size -- it is more likely that a
-    // programming error in the configurator yields a much-too-large argc
-    // value, and it is better to fail fast than to access invalid memory.
+    CHECK_ARGS("JAUNCH", "out", out_argc, 1, SIZE_MAX, out_argv);
+    // NB: The output is unbounded, since huge classpaths and argument lists
+    // are legitimate. A bogus argc value from the configurator cannot lead to
+    // invalid memory access, since process_directives bounds each directive's
+    // argument count by the number of output lines remaining.
 
     ctx_lock();
     ctx()->out_argc = out_argc;
@@ -509,15 +608,17 @@ int main(const int argc, const char *argv[]) {
     int exit_code = ctx()->exit_code; // Thread-safe: directive thread joined.
     LOG_INFO("JAUNCH", "Directives processing complete");
 
-    // Clean up.
-    for (size_t i = 0; i < out_argc; i++) {
-        free(out_argv[i]);
-    }
+    // Clean up. The output strings share one arena with their array.
     free(out_argv);
+    preload_finish();
+    run_command_wait();
 
     // Clean up thread context.
     ctx_destroy();
 
+    trace_span("launcher", "jaunch", trace_origin, NULL);
+    trace_close();
+
     // Do any final platform-specific cleanup.
     teardown();
 
@@ -1,16 +1,156 @@
 #ifndef _JAUNCH_JVM_H
 #define _JAUNCH_JVM_H
 
-#include <stdlib.h>   // for NULL, size_t, atoi
+#include <stdio.h>    // for fflush
+#include <stdlib.h>   // for NULL, size_t, atoi, strtoull, _Exit
+#include <string.h>   // for strcmp, strlen, strncmp
 
 #include "jni.h"      // for JavaVM, JNIEnv, JNI_CreateJavaVM, JNI_* constants
 
 #include "logging.h"
 #include "common.h"
+#include "server.h"
+#include "thread.h"
+#include "trace.h"
 
 // Global JVM state for reuse across multiple directives.
+// NB: Directives running concurrently (see thread.h) hold the lock
+// while creating the JVM, so that only the first of them does so.
 static JavaVM *cached_jvm = NULL;
 static void *cached_jvm_library = NULL;
+static pthread_mutex_t cached_jvm_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// JVM arguments through which the configurator passes the jvm.main-stack-size
+// and jvm.exit-mode settings. They are for the launcher only, and not passed on
+// to the JVM (see jvm_launcher_arg).
+#define JVM_MAIN_STACK_SIZE_ARG "-Djaunch.main-stack-size="
+#define JVM_EXIT_MODE_ARG "-Djaunch.exit-mode="
+
+// Whether to exit straight away after a final JVM directive (see exit_jvm_fast),
+// and the exit status of the Java side: 1 if the main method threw an exception.
+static int jvm_exit_fast = 0;
+static int jvm_main_status = SUCCESS;
+
+/* Checks whether the given JVM argument is one meant for the launcher. */
+static int jvm_launcher_arg(const char *arg) {
+    return strncmp(arg, JVM_MAIN_STACK_SIZE_ARG, strlen(JVM_MAIN_STACK_SIZE_ARG)) == 0 ||
+        strncmp(arg, JVM_EXIT_MODE_ARG, strlen(JVM_EXIT_MODE_ARG)) == 0;
+}
+
+/*
+ * Parse a Java-style memory size, such as 512k or 8m, into bytes.
+ * Returns 0 if the size is malformed.
+ */
+static size_t jvm_parse_size(const char *value) {
+    char *end;
+    unsigned long long size = strtoull(value, &end, 10);
+    if (end == value) return 0;
+    switch (*end) {
+        case 'k': case 'K': size <<= 10; end++; break;
+        case 'm': case 'M': size <<= 20; end++; break;
+        case 'g': case 'G': size <<= 30; end++; break;
+    }
+    return *end == '\0' ? (size_t)size : 0;
+}
+
+/*
+ * Determine the stack size of the thread to run the main method on, in bytes:
+ * that of the last -Xss argument, as with the java command, or else that of
+ * the jvm.main-stack-size setting. Returns 0 if neither is given, in which
+ * case the JVM runs on the thread executing the directive.
+ */
+static size_t jvm_main_stack_size(const size_t jvm_argc, const char **jvm_argv) {
+    const char *xss = NULL, *configured = NULL;
+    for (size_t i = 0; i < jvm_argc; i++) {
+        if (strncmp(jvm_argv[i], "-Xss", 4) == 0) xss = jvm_argv[i] + 4;
+        else if (strncmp(jvm_argv[i], JVM_MAIN_STACK_SIZE_ARG, strlen(JVM_MAIN_STACK_SIZE_ARG)) == 0) {
+            configured = jvm_argv[i] + strlen(JVM_MAIN_STACK_SIZE_ARG);
+        }
+    }
+    const char *value = xss != NULL ? xss : configured;
+    if (value == NULL) return 0;
+    size_t stack_size = jvm_parse_size(value);
+    if (stack_size == 0) LOG_INFO("JVM", "Using the default main thread stack for size '%s'", value);
+    return stack_size;
+}
+
+/*
+ * Exit hook of the JVM, called when the application calls System.exit, or
+ * exit_jvm_fast calls Runtime.exit: notes the files the launch has touched,
+ * and forwards the exit code to the client being served, if any.
+ */
+static void JNICALL jvm_exit_hook(jint code) {
+    prefetch_record();
+    server_exit_hook(code);
+}
+
+/*
+ * Create the JVM of the first JVM directive, attached to the current thread,
+ * and cache it for reuse. Caller must hold cached_jvm_lock.
+ */
+static int create_jvm(const char *libjvm_path, const size_t jvm_argc, const char **jvm_argv, JNIEnv **env) {
+    JavaVM *jvm;
+    void *jvm_library;
+
+    // Warm up the page cache with the files the JVM will read, while it loads.
+    prefetch_jvm(libjvm_path, jvm_argc, jvm_argv);
+    LOG_INFO("JVM", "Loading libjvm (first time)");
+    long long trace_start = trace_now();
+    jvm_library = runtime_lib_open(libjvm_path);
+    if (jvm_library == NULL) {
+        FAIL(ERROR_DLOPEN, "Failed to load libjvm: %s", lib_error());
+    }
+    trace_span("JVM", "lib_open", trace_start, libjvm_path);
+
+    // Load JNI_CreateJavaVM function.
+    LOG_DEBUG("JVM", "Loading JNI_CreateJavaVM");
+    static jint (*JNI_CreateJavaVM)(JavaVM **pvm, void **penv, void *args);
+    JNI_CreateJavaVM = lib_sym(jvm_library, "JNI_CreateJavaVM");
+    if (JNI_CreateJavaVM == NULL) {
+        LOG_ERROR("Failed to locate JNI_CreateJavaVM function: %s", lib_error());
+        lib_close(jvm_library);
+        return ERROR_DLSYM;
+    }
+
+    // Populate VM options.
+    LOG_DEBUG("JVM", "Populating VM options");
+    JavaVMOption vmOptions[jvm_argc + 2];
+    size_t nOptions = 0;
+    for (size_t i = 0; i < jvm_argc; i++) {
+        if (jvm_launcher_arg(jvm_argv[i])) {
+            if (strcmp(jvm_argv[i], JVM_EXIT_MODE_ARG "fast") == 0) jvm_exit_fast = 1;
+            continue;
+        }
+        vmOptions[nOptions++].optionString = (char *)jvm_argv[i];
+    }
+    vmOptions[nOptions].optionString = "exit";
+    vmOptions[nOptions++].extraInfo = (void *)jvm_exit_hook;
+    vmOptions[nOptions].optionString = NULL;
+
+    // Populate VM init args.
+    LOG_DEBUG("JVM", "Populating VM init args");
+    JavaVMInitArgs vmInitArgs;
+    vmInitArgs.version = JNI_VERSION_1_8;
+    vmInitArgs.options = vmOptions;
+    vmInitArgs.nOptions = nOptions;
+    vmInitArgs.ignoreUnrecognized = JNI_FALSE;
+
+    // Create the JVM.
+    LOG_DEBUG("JVM", "Creating JVM");
+    trace_start = trace_now();
+    if (JNI_CreateJavaVM(&jvm, (void **)env, &vmInitArgs) != JNI_OK) {
+        LOG_ERROR("Failed to create the Java Virtual Machine");
+        lib_close(jvm_library);
+        return ERROR_CREATE_JAVA_VM;
+    }
+    trace_span("JVM", "JNI_CreateJavaVM", trace_start, NULL);
+
+    // Cache the JVM instance for reuse.
+    cached_jvm = jvm;
+    cached_jvm_library = jvm_library;
+    LOG_INFO("JVM", "JVM created and cached for reuse");
+    return SUCCESS;
+}
 
 /*
  * This is the logic implementing Jaunch's JVM directive.
@@ -21,8 +161,13 @@ static void *cached_jvm_library = NULL;
  *
  * For multiple JVM directives, the JVM instance is cached and reused.
  * The JVM is only destroyed when cleanup_jvm() is called at the end of all directives.
+ *
+ * If a JVM server with the same signature is running, the main class runs there
+ * instead; and in server mode, the JVM serves other launches. See server.h.
+ *
+ * See launch_jvm for the thread on which this happens.
  */
-static int launch_jvm(const size_t argc, const char **argv) {
+static int run_jvm(const size_t argc, const char **argv) {
     // =======================================================================
     // Parse the arguments, which must conform to the following structure:
     //
@@ -65,57 +210,33 @@ static int launch_jvm(const size_t argc, const char **argv) {
     JNIEnv *env;
     void *jvm_library;
 
-    if (cached_jvm == NULL) {
-        // First JVM directive - create new JVM instance.
-        LOG_INFO("JVM", "Loading libjvm (first time)");
-        jvm_library = lib_open(libjvm_path);
-        if (jvm_library == NULL) {
-            FAIL(ERROR_DLOPEN, "Failed to load libjvm: %s", lib_error());
-        }
-
-        // Load JNI_CreateJavaVM function.
-        LOG_DEBUG("JVM", "Loading JNI_CreateJavaVM");
-        static jint (*JNI_CreateJavaVM)(JavaVM **pvm, void **penv, void *args);
-        JNI_CreateJavaVM = lib_sym(jvm_library, "JNI_CreateJavaVM");
-        if (JNI_CreateJavaVM == NULL) {
-            LOG_ERROR("Failed to locate JNI_CreateJavaVM function: %s", lib_error());
-            lib_close(jvm_library);
-            return ERROR_DLSYM;
+    if (cached_jvm == NULL && server_timeout == 0) {
+        // Let a warm JVM of a running server do the work, if there is one.
+        // NB: The main class precedes the main arguments, as one main program.
+        int exit_code;
+        if (server_launch("JVM", libjvm_path, jvm_argc, jvm_argv, main_argc + 1, main_argv - 1, &exit_code)) {
+            return exit_code;
         }
+    }
 
-        // Populate VM options.
-        LOG_DEBUG("JVM", "Populating VM options");
-        JavaVMOption vmOptions[jvm_argc + 1];
-        for (size_t i = 0; i < jvm_argc; i++) {
-            vmOptions[i].optionString = (char *)jvm_argv[i];
-        }
-        vmOptions[jvm_argc].optionString = NULL;
-
-        // Populate VM init args.
-        LOG_DEBUG("JVM", "Populating VM init args");
-        JavaVMInitArgs vmInitArgs;
-        vmInitArgs.version = JNI_VERSION_1_8;
-        vmInitArgs.options = vmOptions;
-        vmInitArgs.nOptions = jvm_argc;
-        vmInitArgs.ignoreUnrecognized = JNI_FALSE;
-
-        // Create the JVM.
-        LOG_DEBUG("JVM", "Creating JVM");
-        if (JNI_CreateJavaVM(&jvm, (void **)&env, &vmInitArgs) != JNI_OK) {
-            LOG_ERROR("Failed to create the Java Virtual Machine");
-            lib_close(jvm_library);
-            return ERROR_CREATE_JAVA_VM;
-        }
+    // NB: Concurrent directives may race to be first; only one creates the JVM.
+    pthread_mutex_lock(&cached_jvm_lock);
+    int first = cached_jvm == NULL;
+    int result = first ? create_jvm(libjvm_path, jvm_argc, jvm_argv, &env) : SUCCESS;
+    pthread_mutex_unlock(&cached_jvm_lock);
+    if (result != SUCCESS) return result;
+    jvm = cached_jvm;
+    jvm_library = cached_jvm_library;
 
-        // Cache the JVM instance for reuse.
-        cached_jvm = jvm;
-        cached_jvm_library = jvm_library;
-        LOG_INFO("JVM", "JVM created and cached for reuse");
-    } else {
+    if (first && server_timeout > 0) {
+        // Serve other launches, rather than running the main class here.
+        result = serve_jvm(jvm, libjvm_path, jvm_argc, jvm_argv);
+        if ((*jvm)->DetachCurrentThread(jvm)) LOG_ERROR("Could not detach current thread from JVM");
+        return result;
+    }
+    if (!first) {
         // Subsequent JVM directive - reuse cached instance.
         LOG_INFO("JVM", "Reusing cached JVM");
-        jvm = cached_jvm;
-        jvm_library = cached_jvm_library;
 
         // Attach current thread to existing JVM.
         if ((*jvm)->AttachCurrentThread(jvm, (void **)&env, NULL) != JNI_OK) {
@@ -130,7 +251,9 @@ static int launch_jvm(const size_t argc, const char **argv) {
 
     // Find the main class.
     LOG_DEBUG("JVM", "Finding main class");
+    long long trace_start = trace_now();
     jclass mainClass = (*env)->FindClass(env, main_class_name);
+    trace_span("JVM", "FindClass", trace_start, main_class_name);
     if (mainClass == NULL) {
         LOG_ERROR("Failed to locate class %s", main_class_name);
         (*jvm)->DestroyJavaVM(jvm);
@@ -157,7 +280,15 @@ static int launch_jvm(const size_t argc, const char **argv) {
 
     // Invoke the main method.
     LOG_DEBUG("JVM", "Invoking main method");
+    trace_span("JVM", "until main", trace_origin, main_class_name);
+    trace_start = trace_now();
     (*env)->CallStaticVoidMethodA(env, mainClass, mainMethod, (jvalue *)&javaArgs);
+    trace_span("JVM", "main", trace_start, main_class_name);
+    prefetch_record();
+
+    // Remember whether main threw, for the exit status of a fast exit.
+    // NB: Detaching the thread reports the exception, as usual.
+    jvm_main_status = (*env)->ExceptionCheck(env) ? 1 : SUCCESS;
 
     LOG_DEBUG("JVM", "Detaching current thread");
     if ((*jvm)->DetachCurrentThread(jvm)) {
@@ -174,6 +305,55 @@ static int launch_jvm(const size_t argc, const char **argv) {
     return SUCCESS;
 }
 
+/*
+ * Launch the JVM directive with the given arguments (see run_jvm).
+ *
+ * Like the java command, if the stack size of the main thread is specified
+ * (see jvm_main_stack_size), the JVM is created and the main method invoked
+ * on a dedicated runtime thread with that stack size (see thread.h), since
+ * the stack of the thread executing the directive is beyond our control.
+ */
+static int launch_jvm(const size_t argc, const char **argv) {
+    // NB: run_jvm validates the arguments; here, we only peek at the JVM arguments.
+    size_t jvm_argc = argc < 3 ? 0 : (size_t)atoi(argv[1]);
+    if (jvm_argc > argc - 3) jvm_argc = 0;
+    size_t stack_size = jvm_main_stack_size(jvm_argc, argv + 2);
+    if (stack_size == 0) return run_jvm(argc, argv);
+
+    // NB: The main runloop mode demands the main method run on the main thread.
+    const char *runloop_mode = ctx_get_runloop_mode();
+    int main_mode = runloop_mode != NULL && strcmp(runloop_mode, "main") == 0 &&
+        pthread_equal(pthread_self(), ctx()->thread_id_main);
+    if (main_mode) {
+        LOG_INFO("JVM", "Ignoring main thread stack size in main runloop mode");
+        return run_jvm(argc, argv);
+    }
+    return ctx_run_runtime_thread(run_jvm, stack_size, argc, argv);
+}
+
+/*
+ * In fast exit mode (jvm.exit-mode = fast), exit the process straight away
+ * after a final JVM directive, rather than have cleanup_jvm wait in
+ * DestroyJavaVM for all non-daemon threads, shut down the VM and unload
+ * libjvm. Shutdown hooks still run, via Runtime.exit, with the given exit
+ * code of the directives, or else 1 if the main method threw an exception,
+ * like the java command. Returns only when not in fast exit mode.
+ */
+static void exit_jvm_fast(int exit_code) {
+    // NB: A JVM server hands its exit code to the client being served instead.
+    if (cached_jvm == NULL || !jvm_exit_fast || server_timeout > 0) return;
+
+    int status = exit_code != SUCCESS ? exit_code : jvm_main_status;
+    LOG_INFO("JVM", "Exiting fast with status %d", status);
+    trace_span("launcher", "jaunch", trace_origin, NULL);
+    trace_close();
+
+    runtime_exit(cached_jvm, status);
+    LOG_ERROR("Runtime.exit failed; exiting without running shutdown hooks");
+    fflush(NULL);
+    _Exit(status);
+}
+
 /*
  * Cleanup function to destroy the cached JVM instance when all directives are complete.
  * This should be called at the end of the directive processing loop.
@@ -181,7 +361,11 @@ static int launch_jvm(const size_t argc, const char **argv) {
 static void cleanup_jvm() {
     if (cached_jvm != NULL) {
         LOG_DEBUG("JVM", "Awaiting JVM destruction");
+        long long trace_start = trace_now();
         (*cached_jvm)->DestroyJavaVM(cached_jvm);
+        trace_span("JVM", "DestroyJavaVM", trace_start, NULL);
+        // NB: The JVM leaves its files mapped and open, until the process exits.
+        prefetch_record();
         LOG_DEBUG("JVM", "Closing libjvm");
         lib_close(cached_jvm_library);
         cached_jvm = NULL;
@@ -8,6 +8,7 @@
 #include "common.h"
 
 #define OS_NAME "linux"
+#define LIB_SUFFIX ".so"
 
 int is_command_available(const char *command) {
     return access(command, X_OK) == 0;
@@ -41,6 +42,24 @@ int find_executable(const char *name, char *path_buf, size_t buf_size) {
 void setup(const int argc, const char *argv[]) {}
 void teardown() {}
 
+/*
+ * The Linux way of locating the per-user cache directory:
+ * $XDG_CACHE_HOME/jaunch, falling back to ~/.cache/jaunch.
+ */
+char *cache_dir() {
+    char *override = cache_dir_override();
+    if (override != NULL) return override;
+    const char *xdg_cache = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+    const char *base = xdg_cache != NULL && xdg_cache[0] == '/' ? xdg_cache : home;
+    if (base == NULL) return NULL;
+    const char *subdir = base == home ? "/.cache/jaunch" : "/jaunch";
+    char *dir = malloc_or_die(strlen(base) + strlen(subdir) + 1, "cache dir");
+    strcpy(dir, base);
+    strcat(dir, subdir);
+    return dir;
+}
+
 void runloop_config(const char *directive) {}
 void runloop_run(const char *mode) {}
 void runloop_stop() {}
@@ -2,7 +2,7 @@
 #include <spawn.h>
 #include <stdio.h>    // for snprintf
 #include <stdlib.h>   // for NULL, size_t, free
-#include <string.h>   // for strcmp, strerror, strlen
+#include <string.h>   // for strcat, strcmp, strcpy, strerror, strlen
 #include <unistd.h>   // for usleep, exit
 
 #include <CoreFoundation/CoreFoundation.h>
@@ -15,6 +15,7 @@
 #include "thread.h"
 
 #define OS_NAME "macos"
+#define LIB_SUFFIX ".dylib"
 
 // Declare needed AppKit function without including AppKit,
 // to avoid difficulties with Objective-C versus pure C.
@@ -199,6 +200,19 @@ void setup(const int argc, const char *argv[]) {
 }
 void teardown() {}
 
+/* The macOS way of locating the per-user cache directory: ~/Library/Caches/jaunch. */
+char *cache_dir() {
+    char *override = cache_dir_override();
+    if (override != NULL) return override;
+    const char *home = getenv("HOME");
+    if (home == NULL) return NULL;
+    const char *subdir = "/Library/Caches/jaunch";
+    char *dir = malloc_or_die(strlen(home) + strlen(subdir) + 1, "cache dir");
+    strcpy(dir, home);
+    strcat(dir, subdir);
+    return dir;
+}
+
 void runloop_config(const char *directive) {
     if (directive && strcmp(directive, "JVM") == 0) {
         // JVM default: park main thread in event loop.
@@ -1,12 +1,26 @@
 #include <dlfcn.h>    // for dlclose, dlopen, dlsym
+#include <errno.h>    // for errno, EINTR
+#include <fcntl.h>    // for open, posix_fadvise, AT_FDCWD, F_RDADVISE
 #include <limits.h>   // for PATH_MAX
-#include <stdio.h>    // for dprintf
+#include <pthread.h>  // for pthread_create, pthread_detach
+#include <stdio.h>    // for snprintf
 #include <stdlib.h>   // for NULL, size_t, free
-#include <string.h>   // for strdup
-#include <unistd.h>   // for access
+#include <string.h>   // for strdup, strerror
+#include <unistd.h>   // for access, read, write
 
+#include <time.h>     // for clock_gettime, CLOCK_MONOTONIC
+
+#include <sys/stat.h>  // for stat, utimensat, S_ISDIR, UTIME_NOW, UTIME_OMIT
 #include <sys/wait.h>
 
+// posix_spawn avoids duplicating the launcher's address space, as fork does.
+// It is available nearly everywhere; elsewhere, we fall back to fork + execv.
+#if defined(__linux__) || defined(__APPLE__) || (defined(_POSIX_SPAWN) && _POSIX_SPAWN > 0)
+    #define HAVE_POSIX_SPAWN
+    #include <spawn.h>  // for posix_spawn, posix_spawn_file_actions_*
+    extern char **environ;
+#endif
+
 #include "logging.h"
 #include "common.h"
 
@@ -30,6 +44,11 @@ void *lib_open(const char *path) {
     // - Runtimes need their symbols globally available for plugins (RTLD_GLOBAL).
     return dlopen(path, RTLD_NOW | RTLD_GLOBAL);
 }
+void *lib_open_local(const char *path) {
+    // Unlike lib_open, keep the library's symbols to itself (RTLD_LOCAL),
+    // so that loading it does not affect how other libraries are linked.
+    return dlopen(path, RTLD_NOW | RTLD_LOCAL);
+}
 void *lib_sym(void *library, const char *symbol) { return dlsym(library, symbol); }
 void lib_close(void *library) { dlclose(library); }
 char *lib_error() { return dlerror(); }
@@ -51,12 +70,165 @@ char *canonical_path(const char *path) {
     return resolved;
 }
 
+/*
+ * Describe the given file's identity as "<mtime>:<size>:<inode>", or "-" if it
+ * does not exist, with the mtime in nanoseconds since the epoch, so that two
+ * modifications within the same second are told apart. Sizes of directories
+ * are reported as 0. The configurator's stamps (see cache.kt) must be
+ * formatted identically.
+ */
+void file_stamp(const char *path, char *stamp, size_t len) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        snprintf(stamp, len, "-");
+        return;
+    }
+#ifdef __APPLE__
+    struct timespec mtime = st.st_mtimespec;
+#else
+    struct timespec mtime = st.st_mtim;
+#endif
+    snprintf(stamp, len, "%lld:%lld:%lld",
+        (long long)mtime.tv_sec * 1000000000LL + mtime.tv_nsec,
+        S_ISDIR(st.st_mode) ? 0LL : (long long)st.st_size,
+        (long long)st.st_ino);
+}
+
+/*
+ * Sets the access time of the given file to now, leaving its modification
+ * time (and thus its stamp; see file_stamp) alone.
+ */
+void file_mark_used(const char *path) {
+    const struct timespec times[2] = { { 0, UTIME_NOW }, { 0, UTIME_OMIT } };
+    utimensat(AT_FDCWD, path, times, 0);
+}
+
+/* Asks the kernel to read the given file into the page cache, without waiting for it. */
+void file_prefetch(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+#ifdef __APPLE__
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        struct radvisory advice = { 0, st.st_size > INT_MAX ? INT_MAX : (int)st.st_size };
+        fcntl(fd, F_RDADVISE, &advice);
+    }
+#else
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+    close(fd);
+}
+
+/* Microseconds since an arbitrary, but system-wide, point in time. */
+long long monotonic_micros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+/*
+ * Starts the configurator, with the given pipes as its stdin and stdout.
+ * Stores the name of the mechanism used into *method, for tracing.
+ */
+static pid_t spawn_configurator(const char *command,
+    int stdinPipe[2], int stdoutPipe[2], const char **method)
+{
+    // NB: We pass a "-" argument to indicate to the jaunch configurator
+    // that it should harvest the actual input arguments from the stdin
+    // stream, in the binary protocol. We do this to avoid issues with quoting.
+    // And since the command is already a full path, there is no PATH search.
+    char *const argv[] = { (char *)command, "-", PROTOCOL_FLAG, NULL };
+
+#ifdef HAVE_POSIX_SPAWN
+    posix_spawn_file_actions_t actions;
+    if (posix_spawn_file_actions_init(&actions) == 0) {
+        // Close unused ends of the pipes, and redirect stdin and stdout.
+        posix_spawn_file_actions_addclose(&actions, stdinPipe[1]);
+        posix_spawn_file_actions_addclose(&actions, stdoutPipe[0]);
+        posix_spawn_file_actions_adddup2(&actions, stdinPipe[0], STDIN_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, stdoutPipe[1], STDOUT_FILENO);
+        if (stdinPipe[0] != STDIN_FILENO) posix_spawn_file_actions_addclose(&actions, stdinPipe[0]);
+        if (stdoutPipe[1] != STDOUT_FILENO) posix_spawn_file_actions_addclose(&actions, stdoutPipe[1]);
+
+        pid_t pid;
+        int result = posix_spawn(&pid, command, &actions, NULL, argv, environ);
+        posix_spawn_file_actions_destroy(&actions);
+        if (result == 0) {
+            *method = "posix_spawn";
+            return pid;
+        }
+        LOG_INFO("POSIX", "posix_spawn failed: %s; falling back to fork", strerror(result));
+    }
+#endif
+
+    // Fork to create a child process. Since the child of a multithreaded
+    // process may only call async-signal-safe functions, and other threads
+    // might hold locks the child then needs, let the helper threads finish first.
+    preload_wait();
+    *method = "fork";
+    pid_t pid = fork();
+    if (pid == -1) DIE(ERROR_FORK, "Failed to fork the process");
+    if (pid != 0) return pid; // Parent process
+
+    // Child process: close unused ends of the pipes.
+    close(stdinPipe[1]);
+    close(stdoutPipe[0]);
+
+    // Redirect stdin and stdout.
+    dup2(stdinPipe[0], STDIN_FILENO);
+    dup2(stdoutPipe[1], STDOUT_FILENO);
+
+    // Close duplicated ends.
+    close(stdinPipe[0]);
+    close(stdoutPipe[1]);
+
+    // Execute the command.
+    execv(command, argv);
+
+    // Note: If we reach this point, execv has failed.
+    // NB: Only async-signal-safe functions here, so no logging.
+    const char *message = "[ERROR] Failed to execute the jaunch configurator\n";
+    write(STDERR_FILENO, message, strlen(message));
+    _exit(ERROR_EXEC);
+}
+
 /*
  * POSIX-style function to launch a command in a separate process,
  * and harvest its output from the standard output stream.
  *
  * As opposed to the Windows implementation in win32.h.
  */
+typedef struct {
+    int fd;
+    pid_t pid;
+} ConfiguratorReaper;
+
+// The thread finishing up with the configurator, if any; see run_command_wait.
+static pthread_t reaper_thread;
+static int reaper_running = 0;
+
+/*
+ * Drains the rest of the configurator's output, once it has declared its
+ * output final, and reaps the configurator process when it exits.
+ */
+static void *reap_configurator(void *arg) {
+    ConfiguratorReaper *reaper = (ConfiguratorReaper *)arg;
+    char discard[4096];
+    size_t ignored = 0;
+    while (1) {
+        ssize_t bytesRead = read(reaper->fd, discard, sizeof(discard));
+        if (bytesRead == -1 && errno == EINTR) continue;
+        if (bytesRead <= 0) break;
+        ignored += (size_t)bytesRead;
+    }
+    close(reaper->fd);
+    if (ignored > 0) LOG_INFO("POSIX", "Ignored %zu bytes of configurator output after final record", ignored);
+    while (waitpid(reaper->pid, NULL, 0) == -1 && errno == EINTR) {}
+    LOG_DEBUG("POSIX", "Configurator process %d finished", (int)reaper->pid);
+    free(reaper);
+    return NULL;
+}
+
 void run_command(const char *command,
     size_t numInput, const char *input[],
     size_t *numOutput, char ***output)
@@ -70,80 +242,135 @@ void run_command(const char *command,
         DIE(ERROR_PIPE, "Failed to open pipes to/from configurator");
     }
 
-    // Fork to create a child process.
-    pid_t pid = fork();
+    // Start the configurator process.
+    long long trace_start = trace_now();
+    const char *method;
+    pid_t pid = spawn_configurator(command, stdinPipe, stdoutPipe, &method);
+    trace_span("launcher", "spawn", trace_start, method);
 
-    if (pid == -1) DIE(ERROR_FORK, "Failed to fork the process");
+    // Close unused ends of the pipes.
+    close(stdinPipe[0]);
+    close(stdoutPipe[1]);
 
-    if (pid == 0) { // Child process
-        // Close unused ends of the pipes.
-        close(stdinPipe[1]);
-        close(stdoutPipe[0]);
-
-        // Redirect stdin and stdout.
-        dup2(stdinPipe[0], STDIN_FILENO);
-        dup2(stdoutPipe[1], STDOUT_FILENO);
-
-        // Close duplicated ends.
-        close(stdinPipe[0]);
-        close(stdoutPipe[1]);
-
-        // Execute the command.
-        // NB: We pass a single "-" argument to indicate to the jaunch
-        // configurator that it should harvest the actual input arguments
-        // from the stdin stream. We do this to avoid issues with quoting.
-        execlp(command, command, "-", (char *)NULL);
-
-        // Note: If we reach this point, execlp has failed.
-        DIE(ERROR_EXEC, "Failed to execute the jaunch configurator");
-    } else { // Parent process
-        // Close unused ends of the pipes.
-        close(stdinPipe[0]);
-        close(stdoutPipe[1]);
-
-        // Write to the child process's stdin.
-        LOG_DEBUG("POSIX", "run_command: writing to jaunch stdin");
-        // Passing the input line count as the first line tells the child process what
-        // to expect, so that it can stop reading from stdin once it has received
-        // those lines, even though the pipe is not yet closed. This avoids deadlocks.
-        dprintf(stdinPipe[1], "%zu\n", numInput);
-        LOG_DEBUG("POSIX", "run_command: wrote numInput: %zu", numInput);
-        for (size_t i = 0; i < numInput; i++) {
-            dprintf(stdinPipe[1], "%s\n", input[i]);
-            LOG_DEBUG("POSIX", "run_command: wrote input #%zu: %s", i, input[i]);
-        }
+    // Write to the child process's stdin.
+    trace_start = trace_now();
+    LOG_DEBUG("POSIX", "run_command: writing to jaunch stdin");
+    // Passing the input record count up front tells the child process what
+    // to expect, so that it can stop reading from stdin once it has received
+    // those records, even though the pipe is not yet closed. This avoids deadlocks.
+    size_t inputLength;
+    char *inputBuffer = encode_records(numInput, input, &inputLength);
+    for (size_t written = 0; written < inputLength; ) {
+        ssize_t n = write(stdinPipe[1], inputBuffer + written, inputLength - written);
+        if (n == -1 && errno == EINTR) continue;
+        if (n <= 0) DIE(ERROR_PIPE, "Failed writing to jaunch stdin");
+        written += (size_t)n;
+    }
+    free(inputBuffer);
+    LOG_DEBUG("POSIX", "run_command: wrote numInput: %zu", numInput);
+    for (size_t i = 0; i < numInput; i++) {
+        LOG_DEBUG("POSIX", "run_command: wrote input #%zu: %s", i, input[i]);
+    }
 
-        // Close the write end of stdin to signal the end of input.
-        close(stdinPipe[1]);
-        LOG_DEBUG("POSIX", "run_command: closed jaunch stdin pipe");
+    // Close the write end of stdin to signal the end of input.
+    close(stdinPipe[1]);
+    LOG_DEBUG("POSIX", "run_command: closed jaunch stdin pipe");
+    trace_span("launcher", "write input", trace_start, NULL);
 
-        // Read from the child process's stdout.
-        char buffer[1024];
-        size_t bytesRead;
-        size_t totalBytesRead = 0;
-        size_t bufferSize = 1024;
-        char *outputBuffer = malloc_or_die(bufferSize, "initial buffer");
+    // Read from the child process's stdout.
+    trace_start = trace_now();
+    size_t totalBytesRead = 0;
+    size_t bufferSize = 65536;
+    char *outputBuffer = malloc_or_die(bufferSize, "output buffer");
 
-        while ((bytesRead = read(stdoutPipe[0], buffer, sizeof(buffer))) > 0) {
-            append_to_buffer(&outputBuffer, &bufferSize, &totalBytesRead, buffer, bytesRead);
+    // Read straight into the output buffer, which keeps room for a terminator,
+    // until the end of the output, or until the configurator declares it final.
+    size_t scanned = 0, final = 0;
+    while (final == 0) {
+        reserve_buffer(&outputBuffer, &bufferSize, totalBytesRead, 1);
+        ssize_t bytesRead = read(stdoutPipe[0], outputBuffer + totalBytesRead, bufferSize - totalBytesRead - 1);
+        if (bytesRead == -1 && errno == EINTR) continue;
+        if (bytesRead <= 0) break;
+        totalBytesRead += (size_t)bytesRead;
+        final = find_final_record(outputBuffer, totalBytesRead, &scanned);
+    }
+
+    if (final > 0) {
+        // Leave the configurator to finish up in the background.
+        trace_span("launcher", "read output", trace_start, "final record");
+        ConfiguratorReaper *reaper = (ConfiguratorReaper *)malloc_or_die(sizeof(ConfiguratorReaper), "reaper");
+        reaper->fd = stdoutPipe[0];
+        reaper->pid = pid;
+        if (pthread_create(&reaper_thread, NULL, reap_configurator, reaper) == 0) {
+            reaper_running = 1;
+            LOG_DEBUG("POSIX", "run_command: configurator output is final");
+            *output = parse_output(outputBuffer, final, numOutput);
+            return;
+        }
+        // NB: Without a reaper thread, wait for the configurator after all.
+        free(reaper);
+        while (1) {
+            reserve_buffer(&outputBuffer, &bufferSize, totalBytesRead, 1);
+            ssize_t bytesRead = read(stdoutPipe[0], outputBuffer + totalBytesRead, bufferSize - totalBytesRead - 1);
+            if (bytesRead == -1 && errno == EINTR) continue;
+            if (bytesRead <= 0) break;
+            totalBytesRead += (size_t)bytesRead;
         }
+        totalBytesRead = final;
+    }
 
-        // Close the read end of stdout.
-        close(stdoutPipe[0]);
-        LOG_DEBUG("POSIX", "run_command: closed jaunch stdout pipe");
+    // Close the read end of stdout.
+    close(stdoutPipe[0]);
+    LOG_DEBUG("POSIX", "run_command: closed jaunch stdout pipe");
+    trace_span("launcher", "read output", trace_start, NULL);
 
-        // Wait for the child process to finish.
-        if (waitpid(pid, NULL, 0) == -1) {
-            DIE(ERROR_WAITPID, "Failed waiting for Jaunch termination");
-        }
+    // Wait for the child process to finish.
+    trace_start = trace_now();
+    if (waitpid(pid, NULL, 0) == -1) {
+        DIE(ERROR_WAITPID, "Failed waiting for Jaunch termination");
+    }
+    trace_span("launcher", "waitpid", trace_start, NULL);
 
-        // Return the output buffer and the number of lines.
-        *output = NULL;
-        *numOutput = 0;
-        if (totalBytesRead > 0) {
-            outputBuffer[totalBytesRead] = '\0'; // Null-terminate before parsing.
-            split_lines(outputBuffer, "\n", output, numOutput);
-        }
-        free(outputBuffer);
+    // Return the output strings, parsed in place within the output buffer.
+    *output = parse_output(outputBuffer, totalBytesRead, numOutput);
+}
+
+/*
+ * Waits for the configurator to finish, if run_command left it finishing up
+ * in the background, so that the launcher neither exits before it, nor leaves
+ * it writing to a terminal the launcher no longer owns.
+ */
+void run_command_wait() {
+    if (!reaper_running) return;
+    long long trace_start = trace_now();
+    pthread_join(reaper_thread, NULL);
+    reaper_running = 0;
+    trace_span("launcher", "configurator wait", trace_start, NULL);
+}
+
+/*
+ * Runs the given command -- a full path, with the given NULL-terminated
+ * arguments, starting with the command itself -- as a separate process
+ * sharing the launcher's standard streams, and waits for it to finish.
+ * Returns its exit code, or 128 plus the signal number if a signal ended it.
+ */
+int run_process(const char *command, const char *argv[]) {
+    pid_t pid;
+#ifdef HAVE_POSIX_SPAWN
+    int error = posix_spawn(&pid, command, NULL, NULL, (char *const *)argv, environ);
+    if (error != 0) FAIL(ERROR_EXEC, "Failed to run %s: %s", command, strerror(error));
+#else
+    pid = fork();
+    if (pid == -1) FAIL(ERROR_FORK, "Failed to fork the process");
+    if (pid == 0) {
+        execv(command, (char *const *)argv);
+        _exit(ERROR_EXEC);
+    }
+#endif
+    int status;
+    while (waitpid(pid, &status, 0) == -1) {
+        if (errno != EINTR) FAIL(ERROR_WAITPID, "Failed waiting for %s", command);
     }
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    return WEXITSTATUS(status);
 }
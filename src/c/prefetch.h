@@ -0,0 +1,418 @@
+#ifndef _JAUNCH_PREFETCH_H
+#define _JAUNCH_PREFETCH_H
+
+#include <ctype.h>    // for isxdigit
+#include <pthread.h>  // for pthread_create, pthread_detach, pthread_mutex_*
+#include <stdio.h>    // for FILE, fopen, fputs, fclose, snprintf
+#include <stdlib.h>   // for NULL, size_t, free, strtol
+#include <string.h>   // for memcmp, memcpy, memset, strchr, strcmp, strlen, strncmp
+
+#include "logging.h"
+#include "common.h"
+#include "trace.h"
+
+/*
+ * This is the logic implementing Jaunch's page cache prefetching.
+ *
+ * On a cold start -- after a reboot, or with the application on a network
+ * file system -- much of a JVM launch is spent in page faults on the runtime
+ * image (lib/modules), the class data archive, and the classpath JARs.
+ * So once the JVM directive is known, prefetch_jvm asks the system to read
+ * those files ahead (see file_prefetch), from a few background threads,
+ * while the launcher goes on to load libjvm and create the JVM.
+ *
+ * When the classpath is a pathing JAR of the configurator (see pathing.kt),
+ * the JARs listed by its manifest are the candidates, as well as the
+ * pathing JAR itself. Candidates within the cache directory -- pathing JAR
+ * and class data archive -- are also marked as used (see file_mark_used),
+ * so that the configurator does not prune them while launches keep using
+ * them from the launch cache.
+ *
+ * Classpaths often list many more JARs than a launch loads classes from,
+ * though. So prefetch_record notes which of the candidate files the JVM has
+ * open or mapped -- on Linux, where /proc tells -- in a file of the cache
+ * directory named after a hash of the candidates, one path per line; and
+ * later launches with the same candidates prefetch only those files. It
+ * notes them when the main method returns, and again as the JVM goes away
+ * (from its exit hook, or after DestroyJavaVM), since applications such as
+ * GUIs go on loading classes long after their main method has returned.
+ */
+
+#define PREFETCH_THREADS 4
+
+#ifdef WIN32
+    #define PREFETCH_PATH_SEP ';'
+#else
+    #define PREFETCH_PATH_SEP ':'
+#endif
+
+typedef struct {
+    char **paths;
+    size_t count;
+    size_t next;
+    int workers;
+    pthread_mutex_t lock;
+} PrefetchQueue;
+
+// The files which prefetch_jvm considered, and where to record which were touched.
+static char **prefetch_candidates = NULL;
+static size_t prefetch_candidate_count = 0;
+static char *prefetch_record_path = NULL;
+// Which of the candidates prefetch_record found touched so far, and how many.
+static char *prefetch_touched = NULL;
+static size_t prefetch_touched_count = 0;
+static pthread_mutex_t prefetch_record_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Duplicates the first length characters of the given string. */
+static char *prefetch_strndup(const char *s, size_t length) {
+    char *copy = (char *)malloc_or_die(length + 1, "prefetch path");
+    memcpy(copy, s, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+static void prefetch_add(char ***paths, size_t *count, size_t *capacity, char *path) {
+    if (*count == *capacity) {
+        *capacity = *capacity == 0 ? 16 : 2 * *capacity;
+        char **grown = (char **)realloc(*paths, *capacity * sizeof(char *));
+        if (grown == NULL) DIE(ERROR_REALLOC, "Failed to reallocate memory (prefetch paths)");
+        *paths = grown;
+    }
+    (*paths)[(*count)++] = path;
+}
+
+/* Checks whether the given classpath element names an archive, rather than a directory or wildcard. */
+static int prefetch_is_archive(const char *path, size_t length) {
+    return length > 4 && (strncmp(path + length - 4, ".jar", 4) == 0 || strncmp(path + length - 4, ".zip", 4) == 0);
+}
+
+/* Decodes the given file URL of a pathing JAR manifest (see fileUrl in pathing.kt) into a path. */
+static char *prefetch_url_path(const char *url, size_t length) {
+    if (length < 5 || strncmp(url, "file:", 5) != 0) return NULL;
+    url += 5;
+    length -= 5;
+#ifdef WIN32
+    // NB: Drive paths are written as file:/C:/...
+    if (length >= 3 && url[0] == '/' && url[2] == ':') { url++; length--; }
+#endif
+    char *path = (char *)malloc_or_die(length + 1, "prefetch path");
+    size_t n = 0;
+    for (size_t i = 0; i < length; i++) {
+        char c = url[i];
+        if (c == '%' && i + 2 < length && isxdigit((unsigned char)url[i + 1]) && isxdigit((unsigned char)url[i + 2])) {
+            char hex[3] = { url[i + 1], url[i + 2], '\0' };
+            c = (char)strtol(hex, NULL, 16);
+            i += 2;
+        }
+        else if (c == '/') c = SLASH[0];
+        path[n++] = c;
+    }
+    path[n] = '\0';
+    return path;
+}
+
+/*
+ * Adds the archives which the given pathing JAR lists in the Class-Path
+ * attribute of its manifest. Pathing JARs are stored uncompressed, so the
+ * manifest is found verbatim within the file.
+ */
+static void prefetch_add_pathing_jar(char ***paths, size_t *count, size_t *capacity, const char *jar) {
+    size_t length = 0;
+    char *contents = read_file(jar, &length);
+    if (contents == NULL) return;
+
+    // Unfold the attribute value: continuation lines begin with a space.
+    static const char attribute[] = "\r\nClass-Path: ";
+    const char *start = NULL;
+    for (size_t i = 0; start == NULL && i + sizeof(attribute) - 1 <= length; i++) {
+        if (memcmp(contents + i, attribute, sizeof(attribute) - 1) == 0) start = contents + i + sizeof(attribute) - 1;
+    }
+    size_t n = 0;
+    if (start != NULL) {
+        // NB: The value is unfolded in place, never overtaking where it is read from.
+        for (const char *p = start; p < contents + length; p++) {
+            if (*p == '\r' && p + 1 < contents + length && p[1] == '\n') {
+                if (p + 2 < contents + length && p[2] == ' ') { p += 2; continue; }
+                break;
+            }
+            contents[n++] = *p;
+        }
+    }
+
+    // Add each listed archive; directories end with a slash.
+    size_t before = *count;
+    for (size_t i = 0; i < n; ) {
+        size_t end = i;
+        while (end < n && contents[end] != ' ') end++;
+        char *path = prefetch_url_path(contents + i, end - i);
+        if (path != NULL && prefetch_is_archive(path, strlen(path))) prefetch_add(paths, count, capacity, path);
+        else free(path);
+        i = end + 1;
+    }
+    LOG_DEBUG("PREFETCH", "Pathing JAR %s lists %zu archives", jar, *count - before);
+    free(contents);
+}
+
+/*
+ * Adds the runtime image of the Java installation containing the given libjvm:
+ * lib/modules of Java 9+, or lib/rt.jar of Java 8, whose libjvm lies in jre/.
+ */
+static void prefetch_add_runtime_image(char ***paths, size_t *count, size_t *capacity, const char *libjvm_path) {
+    static const char *images[] = { SLASH "lib" SLASH "modules", SLASH "lib" SLASH "rt.jar", NULL };
+    size_t dir_len = strlen(libjvm_path);
+    for (int level = 0; level < 4; level++) {
+        while (dir_len > 0 && libjvm_path[dir_len - 1] != SLASH[0]) dir_len--;
+        if (dir_len == 0) return;
+        dir_len--; // Drop the slash.
+        for (const char **image = images; *image != NULL; image++) {
+            char *candidate = (char *)malloc_or_die(dir_len + strlen(*image) + 1, "runtime image path");
+            memcpy(candidate, libjvm_path, dir_len);
+            strcpy(candidate + dir_len, *image);
+            if (file_exists(candidate)) {
+                prefetch_add(paths, count, capacity, candidate);
+                return;
+            }
+            free(candidate);
+        }
+    }
+}
+
+/*
+ * Reads the list of previously touched files, if recorded, into a newly allocated
+ * buffer of null-terminated lines, storing the buffer's length into *length.
+ */
+static char *prefetch_read_record(const char *record_path, size_t *length) {
+    char *contents = read_file(record_path, length);
+    if (contents == NULL) return NULL;
+    // Terminate each line, to compare them as strings.
+    for (size_t i = 0; i < *length; i++) {
+        if (is_line_break(contents[i])) contents[i] = '\0';
+    }
+    return contents;
+}
+
+/* Checks whether the given record, as read by prefetch_read_record, lists the given path. */
+static int prefetch_recorded(const char *record, size_t length, const char *path) {
+    for (const char *line = record; line < record + length; line += strlen(line) + 1) {
+        if (strcmp(line, path) == 0) return 1;
+    }
+    return 0;
+}
+
+static void *prefetch_worker(void *arg) {
+    PrefetchQueue *queue = (PrefetchQueue *)arg;
+    while (1) {
+        pthread_mutex_lock(&queue->lock);
+        size_t i = queue->next++;
+        pthread_mutex_unlock(&queue->lock);
+        if (i >= queue->count) break;
+        file_prefetch(queue->paths[i]);
+    }
+
+    // The last worker out cleans up.
+    pthread_mutex_lock(&queue->lock);
+    int last = --queue->workers == 0;
+    pthread_mutex_unlock(&queue->lock);
+    if (last) {
+        pthread_mutex_destroy(&queue->lock);
+        free(queue->paths);
+        free(queue);
+    }
+    return NULL;
+}
+
+/*
+ * Start prefetching the files which the JVM of the given JVM directive
+ * is about to read: its runtime image, class data archive and classpath.
+ */
+void prefetch_jvm(const char *libjvm_path, size_t jvm_argc, const char **jvm_argv) {
+    if (prefetch_candidates != NULL) return; // Only the first JVM is created.
+    long long trace_start = trace_now();
+
+    // NB: Pathing JARs are kept in the classpath subdirectory of the cache directory.
+    char *dir = cache_dir();
+    char *pathing_dir = NULL;
+    if (dir != NULL) {
+        size_t pathing_len = strlen(dir) + 12;
+        pathing_dir = (char *)malloc_or_die(pathing_len, "pathing JAR directory");
+        snprintf(pathing_dir, pathing_len, "%s" SLASH "classpath" SLASH, dir);
+    }
+
+    char **paths = NULL;
+    size_t count = 0, capacity = 0;
+    prefetch_add_runtime_image(&paths, &count, &capacity, libjvm_path);
+    for (size_t a = 0; a < jvm_argc; a++) {
+        const char *arg = jvm_argv[a];
+        if (strncmp(arg, "-Djava.class.path=", 18) == 0) {
+            for (const char *p = arg + 18; *p != '\0'; ) {
+                const char *end = strchr(p, PREFETCH_PATH_SEP);
+                size_t length = end == NULL ? strlen(p) : (size_t)(end - p);
+                if (prefetch_is_archive(p, length)) {
+                    char *path = prefetch_strndup(p, length);
+                    prefetch_add(&paths, &count, &capacity, path);
+                    if (pathing_dir != NULL && strncmp(path, pathing_dir, strlen(pathing_dir)) == 0) {
+                        prefetch_add_pathing_jar(&paths, &count, &capacity, path);
+                    }
+                }
+                p += length + (end == NULL ? 0 : 1);
+            }
+        }
+        else if (strncmp(arg, "-XX:SharedArchiveFile=", 22) == 0) {
+            prefetch_add(&paths, &count, &capacity, prefetch_strndup(arg + 22, strlen(arg + 22)));
+        }
+        else if (strncmp(arg, "-XX:AOTCache=", 13) == 0) {
+            prefetch_add(&paths, &count, &capacity, prefetch_strndup(arg + 13, strlen(arg + 13)));
+        }
+    }
+    free(pathing_dir);
+
+    // Mark the files of the cache directory which this launch uses -- its pathing
+    // JAR and class data archive -- for the configurator to keep (see pruneCacheFiles).
+    for (size_t i = 0; dir != NULL && i < count; i++) {
+        if (strncmp(paths[i], dir, strlen(dir)) == 0 && paths[i][strlen(dir)] == SLASH[0]) {
+            file_mark_used(paths[i]);
+        }
+    }
+
+    if (count == 0) {
+        free(paths);
+        free(dir);
+        return;
+    }
+    prefetch_candidates = paths;
+    prefetch_candidate_count = count;
+
+    // Narrow the candidates down to the files touched last time, if recorded.
+    if (dir != NULL) {
+        unsigned long long hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < count; i++) {
+            hash = fnv1a(hash, "\n");
+            hash = fnv1a(hash, paths[i]);
+        }
+        size_t path_len = strlen(dir) + 32;
+        prefetch_record_path = (char *)malloc_or_die(path_len, "prefetch record path");
+        snprintf(prefetch_record_path, path_len, "%s" SLASH "prefetch-%016llx.txt", dir, hash);
+        free(dir);
+    }
+
+    PrefetchQueue *queue = (PrefetchQueue *)malloc_or_die(sizeof(PrefetchQueue), "prefetch queue");
+    queue->paths = (char **)malloc_or_die(count * sizeof(char *), "prefetch queue paths");
+    queue->count = 0;
+    queue->next = 0;
+    queue->workers = 0;
+    pthread_mutex_init(&queue->lock, NULL);
+    size_t record_length = 0;
+    char *record = prefetch_record_path == NULL ? NULL :
+        prefetch_read_record(prefetch_record_path, &record_length);
+    for (size_t i = 0; i < count; i++) {
+        if (record == NULL || prefetch_recorded(record, record_length, paths[i])) {
+            queue->paths[queue->count++] = paths[i];
+        }
+    }
+    LOG_INFO("PREFETCH", "Prefetching %zu of %zu files%s", queue->count, count,
+        record == NULL ? "" : " touched last time");
+    free(record);
+
+    // NB: The workers are detached, since nobody waits for them. The JVM
+    // simply finds whatever they have read by then in the page cache.
+    pthread_mutex_lock(&queue->lock);
+    for (int t = 0; t < PREFETCH_THREADS && (size_t)t < queue->count; t++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, prefetch_worker, queue) != 0) break;
+        pthread_detach(thread);
+        queue->workers++;
+    }
+    int workers = queue->workers;
+    pthread_mutex_unlock(&queue->lock);
+    if (workers == 0) {
+        pthread_mutex_destroy(&queue->lock);
+        free(queue->paths);
+        free(queue);
+    }
+    trace_span("launcher", "prefetch", trace_start, NULL);
+}
+
+/*
+ * Record which of the prefetch candidates the JVM has touched so far,
+ * for later launches to prefetch only those. May be called repeatedly;
+ * each call adds the files touched since, rewriting the record only if
+ * there are any.
+ */
+#ifdef __linux__
+
+#include <dirent.h>   // for DIR, dirfd, opendir, readdir, closedir
+#include <limits.h>   // for PATH_MAX
+#include <unistd.h>   // for readlinkat
+
+/* Marks the candidate whose resolved path is the given one, if any. */
+static void prefetch_mark(char **resolved, const char *path) {
+    for (size_t i = 0; i < prefetch_candidate_count; i++) {
+        if (!prefetch_touched[i] && resolved[i] != NULL && strcmp(path, resolved[i]) == 0) {
+            prefetch_touched[i] = 1;
+            prefetch_touched_count++;
+        }
+    }
+}
+
+#endif
+
+void prefetch_record() {
+#ifdef __linux__
+    if (prefetch_record_path == NULL) return;
+    // NB: Called from the thread of the main method, and from the JVM's exit hook.
+    pthread_mutex_lock(&prefetch_record_lock);
+    if (prefetch_touched == NULL) {
+        prefetch_touched = (char *)malloc_or_die(prefetch_candidate_count, "touched flags");
+        memset(prefetch_touched, 0, prefetch_candidate_count);
+    }
+    size_t touched_before = prefetch_touched_count;
+
+    // Resolve the candidates as the kernel reports the files in use.
+    char **resolved = (char **)malloc_or_die(prefetch_candidate_count * sizeof(char *), "resolved paths");
+    for (size_t i = 0; i < prefetch_candidate_count; i++) {
+        resolved[i] = prefetch_touched[i] ? NULL : realpath(prefetch_candidates[i], NULL);
+    }
+
+    // Mark the candidates which this process has mapped, or open.
+    FILE *maps = fopen("/proc/self/maps", "r");
+    if (maps != NULL) {
+        char line[PATH_MAX + 128];
+        while (fgets(line, sizeof(line), maps) != NULL) {
+            char *path = strchr(line, '/');
+            if (path == NULL) continue;
+            path[strcspn(path, "\n")] = '\0';
+            prefetch_mark(resolved, path);
+        }
+        fclose(maps);
+    }
+    DIR *fds = opendir("/proc/self/fd");
+    if (fds != NULL) {
+        struct dirent *entry;
+        char target[PATH_MAX];
+        while ((entry = readdir(fds)) != NULL) {
+            ssize_t n = readlinkat(dirfd(fds), entry->d_name, target, sizeof(target) - 1);
+            if (n <= 0) continue;
+            target[n] = '\0';
+            prefetch_mark(resolved, target);
+        }
+        closedir(fds);
+    }
+
+    // NB: A record of nothing would stop all prefetching; rather keep the old one.
+    FILE *fp = prefetch_touched_count == touched_before ? NULL : fopen(prefetch_record_path, "wb");
+    if (fp != NULL) {
+        for (size_t i = 0; i < prefetch_candidate_count; i++) {
+            if (!prefetch_touched[i]) continue;
+            fputs(prefetch_candidates[i], fp);
+            fputc('\n', fp);
+        }
+        fclose(fp);
+        LOG_DEBUG("PREFETCH", "Recorded %zu touched files at %s", prefetch_touched_count, prefetch_record_path);
+    }
+    for (size_t i = 0; i < prefetch_candidate_count; i++) free(resolved[i]);
+    free(resolved);
+    pthread_mutex_unlock(&prefetch_record_lock);
+#endif
+}
+
+#endif
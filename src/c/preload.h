@@ -0,0 +1,224 @@
+#ifndef _JAUNCH_PRELOAD_H
+#define _JAUNCH_PRELOAD_H
+
+#include <pthread.h>  // for pthread_create, pthread_join
+#include <stdio.h>    // for FILE, fopen, fputs, fclose, snprintf
+#include <stdlib.h>   // for NULL, size_t, free
+#include <string.h>   // for strcmp, strlen
+
+#include "logging.h"
+#include "common.h"
+#include "trace.h"
+
+/*
+ * This is the logic implementing Jaunch's speculative runtime library loading.
+ *
+ * Loading libjvm or libpython maps and relocates tens of megabytes, and
+ * normally happens only once the configurator has finished, right on the
+ * critical path of the launch. But a program almost always loads the same
+ * runtime libraries as it did the previous time. So whenever a directive
+ * loads a runtime library via runtime_lib_open, its path is recorded into a
+ * small file in the cache directory, named after a hash of the program's
+ * path, along with any others loaded earlier in the same launch -- e.g.
+ * libpython and then libjvm, for a launch running both -- in order:
+ *
+ *     <path to the first runtime library>
+ *     <path to the second runtime library, if any>
+ *
+ * On the next launch, preload_start loads the recorded libraries on a
+ * background thread, while the configurator runs. It loads them with
+ * lib_open_local, so that a wrong guess does not make any symbols global.
+ * Then runtime_lib_open loads a library the usual way, which merely makes
+ * its symbols global if it was preloaded. Libraries no directive names are
+ * closed again by preload_finish.
+ */
+
+#define PRELOAD_MAX 4
+
+// The file recording the runtime libraries of this program, or NULL.
+static char *preload_hint = NULL;
+// The runtime libraries being loaded speculatively.
+static char *preload_paths[PRELOAD_MAX];
+static void *preload_handles[PRELOAD_MAX];
+static long long preload_micros[PRELOAD_MAX];
+static size_t preload_count = 0;
+static int preload_joined = 1;
+static pthread_t preload_thread;
+// The runtime libraries loaded by this launch so far, in order.
+static char *preload_used[PRELOAD_MAX];
+static size_t preload_used_count = 0;
+
+/*
+ * Compute the path to the file recording the runtime libraries of the given program.
+ * Returns a newly allocated string, or NULL if no cache directory is known.
+ */
+static char *preload_hint_path(const char *exe_path) {
+    char *dir = cache_dir();
+    if (dir == NULL) return NULL;
+
+    size_t path_len = strlen(dir) + 32;
+    char *path = (char *)malloc_or_die(path_len, "preload hint path");
+    snprintf(path, path_len, "%s" SLASH "preload-%016llx.txt", dir,
+        fnv1a(14695981039346656037ULL, exe_path));
+    free(dir);
+    return path;
+}
+
+static void *preload_run(void *arg) {
+    for (size_t i = 0; i < preload_count; i++) {
+        long long start = monotonic_micros();
+        preload_handles[i] = lib_open_local(preload_paths[i]);
+        preload_micros[i] = monotonic_micros() - start;
+    }
+    return NULL;
+}
+
+/*
+ * Start loading the runtime libraries last used by the given program,
+ * if any, on a background thread.
+ */
+void preload_start(const char *exe_path) {
+    if (exe_path == NULL) return;
+    preload_hint = preload_hint_path(exe_path);
+    if (preload_hint == NULL) return;
+
+    size_t length;
+    char *contents = read_file(preload_hint, &length);
+    if (contents == NULL) {
+        LOG_DEBUG("PRELOAD", "No runtime library recorded at %s", preload_hint);
+        return;
+    }
+    // Split the contents into lines, one path per line.
+    // NB: read_file terminates the contents, so the last line ends too.
+    char *line = contents;
+    for (size_t i = 0; i <= length && preload_count < PRELOAD_MAX; i++) {
+        if (i < length && !is_line_break(contents[i])) continue;
+        contents[i] = '\0';
+        if (contents + i > line) preload_paths[preload_count++] = strdup(line);
+        line = contents + i + 1;
+    }
+    free(contents);
+    if (preload_count == 0) return;
+
+    if (pthread_create(&preload_thread, NULL, preload_run, NULL) != 0) {
+        for (size_t i = 0; i < preload_count; i++) free(preload_paths[i]);
+        preload_count = 0;
+        return;
+    }
+    preload_joined = 0;
+    for (size_t i = 0; i < preload_count; i++) LOG_INFO("PRELOAD", "Preloading %s", preload_paths[i]);
+}
+
+/*
+ * Record the runtime libraries loaded by this launch so far, unless already
+ * recorded -- or, if partial is set, unless the recorded ones begin with them,
+ * so that a launch loading several does not rewrite the file for each.
+ */
+static void preload_save(int partial) {
+    if (preload_hint == NULL || preload_used_count == 0) return;
+
+    size_t expected_len = 0;
+    for (size_t i = 0; i < preload_used_count; i++) expected_len += strlen(preload_used[i]) + 1;
+    char *expected = (char *)malloc_or_die(expected_len + 1, "preload hint");
+    expected[0] = '\0';
+    for (size_t i = 0; i < preload_used_count; i++) {
+        strcat(expected, preload_used[i]);
+        strcat(expected, "\n");
+    }
+    size_t length;
+    char *contents = read_file(preload_hint, &length);
+    int same = contents != NULL && (length == expected_len || (partial && length > expected_len)) &&
+        strncmp(contents, expected, expected_len) == 0;
+    free(contents);
+    if (same) {
+        free(expected);
+        return;
+    }
+
+    // NB: The cache directory is created by the configurator. If it does
+    // not exist yet, the libraries are simply recorded on the next launch.
+    FILE *fp = fopen(preload_hint, "wb");
+    if (fp != NULL) {
+        fputs(expected, fp);
+        fclose(fp);
+        LOG_DEBUG("PRELOAD", "Recorded %zu runtime libraries", preload_used_count);
+    }
+    free(expected);
+}
+
+/* Record the given runtime library as one this program uses. */
+static void preload_record(const char *path) {
+    if (preload_hint == NULL) return;
+    for (size_t i = 0; i < preload_used_count; i++) {
+        if (strcmp(preload_used[i], path) == 0) return;
+    }
+    if (preload_used_count == PRELOAD_MAX) return;
+    preload_used[preload_used_count++] = strdup(path);
+    preload_save(1);
+}
+
+/* Wait for the speculative loads to finish, if any are underway. */
+void preload_wait() {
+    if (preload_joined) return;
+    long long trace_start = trace_now();
+    pthread_join(preload_thread, NULL);
+    preload_joined = 1;
+    trace_span("launcher", "preload wait", trace_start, NULL);
+}
+
+/*
+ * Wait for the speculative loads to finish, if any are underway, and take
+ * over the library loaded from the given path, if any. Returns the library
+ * taken over -- loaded locally, see preload_start -- or NULL.
+ */
+static void *preload_take(const char *path) {
+    if (preload_count == 0) return NULL;
+
+    preload_wait();
+    for (size_t i = 0; path != NULL && i < preload_count; i++) {
+        void *library = preload_handles[i];
+        if (library == NULL || strcmp(path, preload_paths[i]) != 0) continue;
+        LOG_INFO("PRELOAD", "Took over %s, loaded in %lld us", path, preload_micros[i]);
+        preload_handles[i] = NULL;
+        return library;
+    }
+    return NULL;
+}
+
+/*
+ * Load the given runtime library, taking over the speculatively loaded one
+ * if it is the same, and record it for the next launch of this program.
+ */
+void *runtime_lib_open(const char *path) {
+    void *preloaded = preload_take(path);
+    // NB: If the library was preloaded, this only makes its symbols global.
+    // On failure, it yields the error for lib_error on this thread.
+    void *library = lib_open(path);
+    if (preloaded != NULL) lib_close(preloaded);
+    if (library != NULL) preload_record(path);
+    return library;
+}
+
+/*
+ * Finish the speculative loads, closing any libraries no directive took over,
+ * and record exactly the runtime libraries this launch loaded.
+ */
+void preload_finish() {
+    preload_take(NULL);
+    preload_save(0);
+    for (size_t i = 0; i < preload_count; i++) {
+        if (preload_handles[i] != NULL) {
+            LOG_INFO("PRELOAD", "Closing unneeded %s", preload_paths[i]);
+            lib_close(preload_handles[i]);
+            preload_handles[i] = NULL;
+        }
+        free(preload_paths[i]);
+    }
+    preload_count = 0;
+    for (size_t i = 0; i < preload_used_count; i++) free(preload_used[i]);
+    preload_used_count = 0;
+    free(preload_hint);
+    preload_hint = NULL;
+}
+
+#endif
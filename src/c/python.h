@@ -1,26 +1,362 @@
 #ifndef _JAUNCH_PYTHON_H
 #define _JAUNCH_PYTHON_H
 
+#include <pthread.h>  // for pthread_mutex_t, pthread_mutex_lock, pthread_mutex_unlock, pthread_equal, pthread_self
 #include <stddef.h>   // for NULL, size_t
+#include <stdint.h>   // for intptr_t
+#include <stdio.h>    // for fprintf, snprintf, stderr
+#include <stdlib.h>   // for getenv
+#include <string.h>   // for memcpy, strchr, strcmp
 
 #include "logging.h"
 #include "common.h"
+#include "server.h"
+#include "thread.h"
+#include "trace.h"
 
 /*
  * This is the logic implementing Jaunch's PYTHON directive.
  * 
- * It dynamically loads libpython and calls Py_BytesMain with the given args.
+ * It dynamically loads libpython, initializes an interpreter with the given
+ * runtime args, and runs the program in it (see PYTHON_RUNNER_SCRIPT). Like
+ * the JVM, the interpreter is kept for any later PYTHON directives, which
+ * run their programs in it with fresh sys.argv, until cleanup_python
+ * finalizes it. Programs the runner cannot run -- e.g. the interactive
+ * interpreter, with no program arguments or with -i -- are left to
+ * Py_BytesMain, as are PYTHON directives on threads other than the
+ * directives thread, since the interpreter must be finalized on the thread
+ * which initialized it.
+ *
+ * A directive which the cached interpreter cannot run as specified -- one
+ * with a differing libpython or runtime args, or a program the runner cannot
+ * run -- first has the directives thread finalize the cached interpreter, as
+ * only one may exist per process. On any other thread, it runs in a separate
+ * Python process instead (see run_process).
+ *
+ * If the zygote is enabled (python.zygote), and a Python zygote with the same
+ * signature is running, the program runs in a process forked from the zygote
+ * instead; and in server mode, the launch becomes such a zygote. See
+ * serve_python below.
+ *
+ * Python runs one program per process at a time, so concurrent PYTHON
+ * directives (see thread.h) take turns; see launch_python below.
  */
-static int launch_python(const size_t argc, const char **argv) {
+
+static pthread_mutex_t python_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Global Python state for reuse across multiple directives.
+static void *cached_python_library = NULL;
+static void *cached_python_runner = NULL;
+static unsigned long long cached_python_signature = 0;
+
+/*
+ * The parts of the CPython API (3.8+) which the launcher uses, loaded from
+ * libpython by load_python_api. PyConfig is only ever handled by pointer,
+ * so it is declared as a buffer of ample size; PyStatus is passed by value,
+ * so it is declared with CPython's layout.
+ */
+typedef union {
+    char bytes[8192];
+    long long align;
+} PythonConfig;
+
+typedef struct {
+    enum { PYTHON_STATUS_OK = 0, PYTHON_STATUS_ERROR = 1, PYTHON_STATUS_EXIT = 2 } type;
+    const char *func;
+    const char *err_msg;
+    int exitcode;
+} PythonStatus;
+
+static struct {
+    void (*PyConfig_InitPythonConfig)(PythonConfig *);
+    PythonStatus (*PyConfig_SetBytesArgv)(PythonConfig *, intptr_t, char * const *);
+    void (*PyConfig_Clear)(PythonConfig *);
+    PythonStatus (*Py_InitializeFromConfig)(const PythonConfig *);
+    int (*Py_FinalizeEx)(void);
+    void *(*PyEval_SaveThread)(void);
+    int (*PyGILState_Ensure)(void);
+    void (*PyGILState_Release)(int);
+    int (*PyRun_SimpleString)(const char *);
+    void *(*PyImport_AddModule)(const char *);
+    void *(*PyObject_GetAttrString)(void *, const char *);
+    int (*PyObject_SetAttrString)(void *, const char *, void *);
+    void *(*PyObject_CallFunctionObjArgs)(void *, ...);
+    void *(*PyList_New)(intptr_t);
+    int (*PyList_SetItem)(void *, intptr_t, void *);
+    void *(*PyUnicode_DecodeFSDefault)(const char *);
+    long (*PyLong_AsLong)(void *);
+    void (*Py_DecRef)(void *);
+    void (*PyErr_Print)(void);
+} python_api;
+
+#define LOAD_PYTHON_SYM(library, name) do { \
+    python_api.name = lib_sym((library), #name); \
+    if (python_api.name == NULL) FAIL(ERROR_DLSYM, "Failed to locate %s function: %s", #name, lib_error()); \
+} while (0)
+
+static int load_python_api(void *library) {
+    LOAD_PYTHON_SYM(library, PyConfig_InitPythonConfig);
+    LOAD_PYTHON_SYM(library, PyConfig_SetBytesArgv);
+    LOAD_PYTHON_SYM(library, PyConfig_Clear);
+    LOAD_PYTHON_SYM(library, Py_InitializeFromConfig);
+    LOAD_PYTHON_SYM(library, Py_FinalizeEx);
+    LOAD_PYTHON_SYM(library, PyEval_SaveThread);
+    LOAD_PYTHON_SYM(library, PyGILState_Ensure);
+    LOAD_PYTHON_SYM(library, PyGILState_Release);
+    LOAD_PYTHON_SYM(library, PyRun_SimpleString);
+    LOAD_PYTHON_SYM(library, PyImport_AddModule);
+    LOAD_PYTHON_SYM(library, PyObject_GetAttrString);
+    LOAD_PYTHON_SYM(library, PyObject_SetAttrString);
+    LOAD_PYTHON_SYM(library, PyObject_CallFunctionObjArgs);
+    LOAD_PYTHON_SYM(library, PyList_New);
+    LOAD_PYTHON_SYM(library, PyList_SetItem);
+    LOAD_PYTHON_SYM(library, PyUnicode_DecodeFSDefault);
+    LOAD_PYTHON_SYM(library, PyLong_AsLong);
+    LOAD_PYTHON_SYM(library, Py_DecRef);
+    LOAD_PYTHON_SYM(library, PyErr_Print);
+    return SUCCESS;
+}
+
+/*
+ * Defines the function which runs a program in the cached interpreter, given
+ * its program arguments: a script -- or `-c` command, or `-m` module -- plus
+ * its arguments. It runs the program the way the python executable would,
+ * with sys.argv and sys.path[0] set for it, and returns its exit code:
+ * uncaught exceptions go to sys.excepthook, and a KeyboardInterrupt ends
+ * the process by SIGINT, as python does.
+ */
+static const char *PYTHON_RUNNER_SCRIPT =
+    "def _jaunch_run(argv):\n"
+    "    import os, runpy, signal, sys\n"
+    "    code, entry = 1, None\n"
+    "    try:\n"
+    "        if argv[0] == '-c':\n"
+    "            sys.argv, entry = ['-c'] + argv[2:], ''\n"
+    "        elif argv[0] == '-m':\n"
+    "            sys.argv, entry = argv[1:], os.getcwd()\n"
+    "        else:\n"
+    "            sys.argv, entry = list(argv), os.path.dirname(os.path.abspath(argv[0]))\n"
+    "        if sys.flags.isolated or getattr(sys.flags, 'safe_path', False):\n"
+    "            entry = None\n"
+    "        else:\n"
+    "            sys.path.insert(0, entry)\n"
+    "        if argv[0] == '-c':\n"
+    "            exec(compile(argv[1], '<string>', 'exec'), {'__name__': '__main__', '__builtins__': __builtins__})\n"
+    "        elif argv[0] == '-m':\n"
+    "            runpy.run_module(argv[1], run_name='__main__', alter_sys=True)\n"
+    "        else:\n"
+    "            runpy.run_path(argv[0], run_name='__main__')\n"
+    "        code = 0\n"
+    "    except SystemExit as e:\n"
+    "        if e.code is None:\n"
+    "            code = 0\n"
+    "        elif isinstance(e.code, int):\n"
+    "            code = e.code\n"
+    "        else:\n"
+    "            print(e.code, file=sys.stderr)\n"
+    "    except BaseException as e:\n"
+    "        # NB: Omit the frames of the runner and runpy, as python itself would.\n"
+    "        tb = e.__traceback__\n"
+    "        while tb is not None and (tb.tb_frame.f_globals is globals() or tb.tb_frame.f_globals.get('__name__') == 'runpy'):\n"
+    "            tb = tb.tb_next\n"
+    "        sys.excepthook(type(e), e, tb)\n"
+    "        if isinstance(e, KeyboardInterrupt):\n"
+    "            sys.stdout.flush()\n"
+    "            sys.stderr.flush()\n"
+    "            if hasattr(signal, 'SIGKILL'):\n"
+    "                signal.signal(signal.SIGINT, signal.SIG_DFL)\n"
+    "                os.kill(os.getpid(), signal.SIGINT)\n"
+    "            code = 0xC000013A if os.name == 'nt' else 130\n"
+    "    finally:\n"
+    "        if entry is not None and sys.path and sys.path[0] == entry:\n"
+    "            del sys.path[0]\n"
+    "        try:\n"
+    "            sys.stdout.flush()\n"
+    "            sys.stderr.flush()\n"
+    "        except Exception:\n"
+    "            pass\n"
+    "    return code\n";
+
+/*
+ * Checks whether the given runtime args -- or, unless they say to ignore
+ * the environment, the PYTHONINSPECT variable -- ask for the interactive
+ * interpreter after the program.
+ */
+static int python_inspect(size_t runtime_argc, const char **runtime_argv) {
+    int ignore_env = 0;
+    for (size_t a = 0; a < runtime_argc; a++) {
+        const char *arg = runtime_argv[a];
+        if (arg[0] != '-' || arg[1] == '-') continue;
+        // Short options may be combined, up to one which takes a value.
+        for (const char *c = arg + 1; *c != '\0' && strchr("cmWX", *c) == NULL; c++) {
+            if (*c == 'i') return 1;
+            if (*c == 'E' || *c == 'I') ignore_env = 1;
+        }
+    }
+    const char *inspect = ignore_env ? NULL : getenv("PYTHONINSPECT");
+    return inspect != NULL && inspect[0] != '\0';
+}
+
+/* Checks whether the runner script can run the given program arguments. */
+static int python_runnable(size_t main_argc, const char **main_argv) {
+    if (main_argc == 0) return 0;
+    if (strcmp(main_argv[0], "-c") == 0 || strcmp(main_argv[0], "-m") == 0) return main_argc >= 2;
+    return main_argv[0][0] != '-';
+}
+
+/*
+ * Initialize an interpreter with the given executable and runtime arguments,
+ * and cache it along with the runner function. On success, the interpreter's
+ * GIL is released, for whichever thread runs the next program.
+ */
+static int create_python(size_t python_argc, const char **python_argv) {
+    long long trace_start = trace_now();
+    PythonConfig *config = malloc_or_die(sizeof(PythonConfig), "python config");
+    python_api.PyConfig_InitPythonConfig(config);
+    PythonStatus status = python_api.PyConfig_SetBytesArgv(config, (intptr_t)python_argc, (char * const *)python_argv);
+    if (status.type == PYTHON_STATUS_OK) status = python_api.Py_InitializeFromConfig(config);
+    python_api.PyConfig_Clear(config);
+    free(config);
+    if (status.type == PYTHON_STATUS_EXIT) return status.exitcode;
+    if (status.type != PYTHON_STATUS_OK) {
+        FAIL(ERROR_RUNTIME_CRASH, "Failed to initialize Python: %s: %s",
+            status.func == NULL ? "<unknown>" : status.func,
+            status.err_msg == NULL ? "<unknown>" : status.err_msg);
+    }
+    trace_span("PYTHON", "Py_InitializeFromConfig", trace_start, NULL);
+
+    void *runner = NULL;
+    if (python_api.PyRun_SimpleString(PYTHON_RUNNER_SCRIPT) == 0) {
+        void *main_module = python_api.PyImport_AddModule("__main__");
+        if (main_module != NULL) {
+            runner = python_api.PyObject_GetAttrString(main_module, "_jaunch_run");
+            python_api.PyObject_SetAttrString(main_module, "_jaunch_run", NULL);
+        }
+    }
+    if (runner == NULL) {
+        python_api.PyErr_Print();
+        python_api.Py_FinalizeEx();
+        FAIL(ERROR_RUNTIME_CRASH, "Failed to define the Python runner");
+    }
+    cached_python_runner = runner;
+    python_api.PyEval_SaveThread();
+    return SUCCESS;
+}
+
+/* Run the given program arguments in the cached interpreter, returning the exit code. */
+static int run_python_program(size_t main_argc, const char **main_argv) {
+    int gil = python_api.PyGILState_Ensure();
+    int result = 1;
+    void *args = python_api.PyList_New((intptr_t)main_argc);
+    for (size_t i = 0; args != NULL && i < main_argc; i++) {
+        void *arg = python_api.PyUnicode_DecodeFSDefault(main_argv[i]);
+        if (arg == NULL || python_api.PyList_SetItem(args, (intptr_t)i, arg) != 0) {
+            python_api.Py_DecRef(args);
+            args = NULL;
+        }
+    }
+    void *code = args == NULL ? NULL :
+        python_api.PyObject_CallFunctionObjArgs(cached_python_runner, args, NULL);
+    if (code != NULL) {
+        result = (int)python_api.PyLong_AsLong(code);
+        python_api.Py_DecRef(code);
+    }
+    else python_api.PyErr_Print();
+    if (args != NULL) python_api.Py_DecRef(args);
+    python_api.PyGILState_Release(gil);
+    return result;
+}
+
+#ifdef WIN32
+
+static int serve_python(int (*Py_BytesMain)(int, char **), const char *libpython_path,
+    size_t sig_argc, const char **sig_argv, size_t python_argc, const char **python_argv,
+    const char *zygote_path, size_t preload_count, const char **preloads)
+{
+    FAIL(ERROR_SERVER, "The Python zygote is not supported on Windows");
+}
+
+#else
+
+#include <unistd.h>   // for unlink
+
+/*
+ * Become a Python zygote: listen on a socket named after the given signature,
+ * and run the given zygote script (zygote.py, beside the configurator) with
+ * the given python executable and runtime arguments, until no request arrives
+ * for server_timeout seconds. See zygote.py for the Python side.
+ */
+static int serve_python(int (*Py_BytesMain)(int, char **), const char *libpython_path,
+    size_t sig_argc, const char **sig_argv, size_t python_argc, const char **python_argv,
+    const char *zygote_path, size_t preload_count, const char **preloads)
+{
+    // NB: The script runs as a -c command, so that sys.path[0] is the
+    // working directory, as for preload modules imported by python -c.
+    size_t script_length = 0;
+    char *script = read_file(zygote_path, &script_length);
+    if (script == NULL) FAIL(ERROR_SERVER, "Failed to read the Python zygote script %s", zygote_path);
+    char *socket_path = server_socket_path(libpython_path, sig_argc, sig_argv);
+    if (socket_path == NULL) {
+        free(script);
+        FAIL(ERROR_SERVER, "No location for the Python zygote socket");
+    }
+    int fd = server_listen("PYTHON", socket_path);
+    if (fd < 0) {
+        free(script);
+        free(socket_path);
+        return ERROR_SERVER;
+    }
+    fprintf(stderr, "Jaunch Python zygote listening at %s (idle timeout %d seconds)\n",
+        socket_path, server_timeout);
+
+    // python <runtime args> -c <zygote script> <socket fd> <idle timeout> <preload modules>
+    char fd_str[16], timeout_str[16];
+    snprintf(fd_str, sizeof(fd_str), "%d", fd);
+    snprintf(timeout_str, sizeof(timeout_str), "%d", server_timeout);
+    const size_t zygote_argc = python_argc + 4 + preload_count;
+    const char **zygote_argv = malloc_or_die((zygote_argc + 1) * sizeof(char *), "zygote arguments");
+    memcpy(zygote_argv, python_argv, python_argc * sizeof(char *));
+    zygote_argv[python_argc] = "-c";
+    zygote_argv[python_argc + 1] = script;
+    zygote_argv[python_argc + 2] = fd_str;
+    zygote_argv[python_argc + 3] = timeout_str;
+    memcpy(zygote_argv + python_argc + 4, preloads, preload_count * sizeof(char *));
+    zygote_argv[zygote_argc] = NULL;
+
+    // NB: Forked children exit from within the script, so only the zygote
+    // itself returns here; and the script's socket object closes the socket.
+    int result = Py_BytesMain((int)zygote_argc, (char **)zygote_argv);
+    LOG_INFO("SERVER", "Python zygote finished with exit code %d", result);
+    unlink(socket_path);
+    free(zygote_argv);
+    free(script);
+    free(socket_path);
+    return result;
+}
+
+#endif
+
+static void cleanup_python();
+
+static int run_python(const size_t argc, const char **argv) {
     // =======================================================================
     // Parse the arguments, which must conform to the following structure:
     //
     // 1. Path to the runtime native library (libpython).
     // 2. Path to the runtime executable launcher (python).
-    // 3. List of arguments to the Python runtime, one per line.
+    // 3. Number of zygote lines; 0 unless python.zygote is enabled.
+    // 4. Zygote lines: the path to the zygote script (zygote.py),
+    //    then the modules for the zygote to preload, one per line.
+    // 5. Number of arguments to the Python runtime.
+    // 6. List of arguments to the Python runtime, one per line.
+    // 7. List of program arguments -- usually the script path plus its
+    //    main arguments -- one per line.
+    //
+    // Note that an explicit count of program arguments is
+    // not needed because it can be computed from argc.
     // =======================================================================
 
-    if (argc < 1) {
+    if (argc < 4) {
       FAIL(ERROR_ARGC_OUT_OF_BOUNDS, "Too few PYTHON directive arguments: %d", argc);
     }
 
@@ -29,21 +365,101 @@ static int launch_python(const size_t argc, const char **argv) {
     const char *libpython_path = *ptr++;
     LOG_INFO("PYTHON", "libpython_path = %s", libpython_path);
 
-    const int python_argc = argc - 1;
-    const char **python_argv = (const char **)ptr;
-
     const char *python_exe_path = *ptr++;
     LOG_INFO("PYTHON", "python_exe_path = %s", python_exe_path);
 
+    const int zygote_count = atoi(*ptr++);
+    const char **zygote_lines = (const char **)ptr;
+    CHECK_ARGS("PYTHON", "zygote", zygote_count, 0, argc - 4, zygote_lines);
+    ptr += zygote_count;
+    const char *zygote_path = zygote_count > 0 ? zygote_lines[0] : NULL;
+    const size_t preload_count = zygote_count > 0 ? zygote_count - 1 : 0;
+    const char **preloads = zygote_lines + 1;
+
+    const int runtime_argc = atoi(*ptr++);
+    const char **runtime_argv = (const char **)ptr;
+    CHECK_ARGS("PYTHON", "runtime", runtime_argc, 0, argc - 4 - zygote_count, runtime_argv);
+    ptr += runtime_argc;
+
+    const int main_argc = argc - 4 - zygote_count - runtime_argc;
+    const char **main_argv = (const char **)ptr;
+    CHECK_ARGS("PYTHON", "main", main_argc, 0, main_argc, main_argv);
+
+    // The signature of a zygote: everything which shapes the interpreter.
+    const size_t sig_argc = 3 + zygote_count + runtime_argc;
+    const char **sig_argv = argv + 1;
+    // And that of a cached interpreter: its libpython and runtime args.
+    unsigned long long signature = fnv1a(14695981039346656037ULL, libpython_path);
+    for (int i = 0; i < runtime_argc; i++) {
+        signature = fnv1a(fnv1a(signature, "\n"), runtime_argv[i]);
+    }
+
+    // The interpreter takes the executable, then the runtime and program arguments.
+    const int python_argc = 1 + runtime_argc + main_argc;
+    const char **python_argv = malloc_or_die((python_argc + 1) * sizeof(char *), "python arguments");
+    python_argv[0] = python_exe_path;
+    memcpy(python_argv + 1, runtime_argv, runtime_argc * sizeof(char *));
+    memcpy(python_argv + 1 + runtime_argc, main_argv, main_argc * sizeof(char *));
+    python_argv[python_argc] = NULL;
+
+    if (cached_python_runner != NULL && signature == cached_python_signature &&
+        python_runnable(main_argc, main_argv))
+    {
+        // Subsequent PYTHON directive - reuse cached interpreter.
+        LOG_INFO("PYTHON", "Reusing cached Python interpreter");
+        trace_span("PYTHON", "until main", trace_origin, NULL);
+        long long trace_start = trace_now();
+        int result = run_python_program(main_argc, main_argv);
+        trace_span("PYTHON", "main", trace_start, main_argv[0]);
+        free(python_argv);
+        return result;
+    }
+
+    if (cached_python_runner != NULL) {
+        // The cached interpreter cannot run this directive as specified: it
+        // has a differing libpython or runtime args, or the program is not
+        // one the runner can run. Only one interpreter may exist at a time.
+        if (pthread_equal(pthread_self(), ctx()->thread_id_directives)) {
+            // Finalize it, then proceed as though there never was one.
+            LOG_INFO("PYTHON", "Finalizing cached Python interpreter, which cannot run this directive");
+            cleanup_python();
+        }
+        else {
+            // Only the directives thread may finalize it; run a separate Python process.
+            LOG_INFO("PYTHON", "Running %s as a separate process", python_exe_path);
+            long long trace_start = trace_now();
+            int result = run_process(python_exe_path, python_argv);
+            trace_span("PYTHON", "run_process", trace_start, python_exe_path);
+            free(python_argv);
+            return result;
+        }
+    }
+
+    if (server_timeout == 0 && main_argc > 0 && zygote_path != NULL) {
+        // Let a child of a running zygote do the work, if there is one.
+        int exit_code;
+        if (server_launch("PYTHON", libpython_path, sig_argc, sig_argv, main_argc, main_argv, &exit_code)) {
+            free(python_argv);
+            return exit_code;
+        }
+    }
+
     // =======================================================================
-    // Load the Python runtime.
+    // Load the Python runtime, or reuse the cached library.
     // =======================================================================
 
-    // Load libpython.
-    LOG_DEBUG("PYTHON", "Loading libpython");
-    void *python_library = lib_open(libpython_path);
+    void *python_library = cached_python_library;
     if (python_library == NULL) {
-        FAIL(ERROR_DLOPEN, "Failed to load libpython: %s", lib_error());
+        // Load libpython.
+        LOG_DEBUG("PYTHON", "Loading libpython");
+        long long trace_start = trace_now();
+        python_library = runtime_lib_open(libpython_path);
+        if (python_library == NULL) {
+            free(python_argv);
+            FAIL(ERROR_DLOPEN, "Failed to load libpython: %s", lib_error());
+        }
+        trace_span("PYTHON", "lib_open", trace_start, libpython_path);
+        cached_python_library = python_library;
     }
 
     // Load Py_BytesMain function.
@@ -52,30 +468,89 @@ static int launch_python(const size_t argc, const char **argv) {
     Py_BytesMain = lib_sym(python_library, "Py_BytesMain");
     if (Py_BytesMain == NULL) {
         LOG_ERROR("Failed to locate Py_BytesMain function: %s", lib_error());
-        lib_close(python_library);
+        free(python_argv);
         return ERROR_DLSYM;
     }
 
-    // Invoke Python main routine with the specified arguments.
-    int result = Py_BytesMain(python_argc, (char **)python_argv);
+    if (server_timeout > 0 && zygote_path == NULL) {
+        LOG_WARN("The Python zygote is disabled (see python.zygote); launching normally");
+    }
+    else if (server_timeout > 0) {
+        // Server mode: become a zygote rather than running the program.
+        int result = serve_python(Py_BytesMain, libpython_path, sig_argc, sig_argv,
+            1 + runtime_argc, python_argv, zygote_path, preload_count, preloads);
+        free(python_argv);
+        return result;
+    }
+
+    // NB: Only the directives thread, which runs cleanup_python, may initialize
+    // the interpreter for reuse; see the comment at the top of this file.
+    int result;
+    int reusable = python_runnable(main_argc, main_argv) && !python_inspect(runtime_argc, runtime_argv) &&
+        pthread_equal(pthread_self(), ctx()->thread_id_directives);
+    if (reusable) {
+        // Initialize an interpreter, and keep it for potential reuse.
+        int loaded = load_python_api(python_library);
+        result = loaded != SUCCESS ? loaded : create_python(1 + runtime_argc, python_argv);
+        if (result == SUCCESS) {
+            cached_python_signature = signature;
+            trace_span("PYTHON", "until main", trace_origin, NULL);
+            long long trace_start = trace_now();
+            result = run_python_program(main_argc, main_argv);
+            trace_span("PYTHON", "main", trace_start, main_argv[0]);
+        }
+    }
+    else {
+        // Invoke Python main routine with the specified arguments.
+        trace_span("PYTHON", "until main", trace_origin, NULL);
+        long long trace_start = trace_now();
+        result = Py_BytesMain(python_argc, (char **)python_argv);
+        trace_span("PYTHON", "Py_BytesMain", trace_start, NULL);
+    }
+    free(python_argv);
 
     if (result != 0) {
       LOG_ERROR("Failed to run Python script: %d", result);
-      lib_close(python_library);
       return result;
     }
 
     // =======================================================================
-    // Clean up.
+    // Clean up, but keep the interpreter alive for potential reuse.
     // =======================================================================
 
-    LOG_DEBUG("PYTHON", "Closing libpython");
-    lib_close(python_library);
-    LOG_INFO("PYTHON", "Python cleanup complete");
+    LOG_INFO("PYTHON", "PYTHON directive completed - keeping Python alive for potential reuse");
+    // Python will be finalized later in cleanup_python() when all directives are done.
 
     return SUCCESS;
 }
 
-static void cleanup_python() {}
+static int launch_python(const size_t argc, const char **argv) {
+    pthread_mutex_lock(&python_lock);
+    int result = run_python(argc, argv);
+    pthread_mutex_unlock(&python_lock);
+    return result;
+}
+
+/*
+ * Cleanup function to finalize the cached Python interpreter when all directives are complete.
+ * This should be called at the end of the directive processing loop.
+ */
+static void cleanup_python() {
+    if (cached_python_runner != NULL) {
+        LOG_DEBUG("PYTHON", "Finalizing Python");
+        long long trace_start = trace_now();
+        python_api.PyGILState_Ensure();
+        python_api.Py_DecRef(cached_python_runner);
+        if (python_api.Py_FinalizeEx() != 0) LOG_ERROR("Failed to finalize Python cleanly");
+        trace_span("PYTHON", "Py_FinalizeEx", trace_start, NULL);
+        cached_python_runner = NULL;
+    }
+    if (cached_python_library != NULL) {
+        LOG_DEBUG("PYTHON", "Closing libpython");
+        lib_close(cached_python_library);
+        cached_python_library = NULL;
+        LOG_INFO("PYTHON", "Python cleanup complete");
+    }
+}
 
 #endif
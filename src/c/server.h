@@ -0,0 +1,714 @@
+#ifndef _JAUNCH_SERVER_H
+#define _JAUNCH_SERVER_H
+
+#include <stdio.h>    // for fflush, fprintf, snprintf, stderr, stdout
+#include <stdlib.h>   // for NULL, size_t, atoi, free, getenv
+#include <string.h>   // for memcpy, strchr, strcmp, strlen, strncmp
+
+#include "jni.h"      // for JavaVM, JNIEnv, JNICALL, jint
+
+#include "logging.h"
+#include "common.h"
+#include "trace.h"
+
+/*
+ * This is the logic implementing Jaunch's JVM server mode.
+ *
+ * Launching with --jaunch-server[=<seconds>] creates the JVM as usual, but
+ * rather than running the main class, keeps the JVM alive and listens on a
+ * per-user Unix domain socket within the cache directory, named after a hash
+ * of the libjvm path and the JVM arguments -- the JVM's signature. Subsequent
+ * launches whose JVM directive has the same signature connect to that socket
+ * instead of creating a JVM of their own, and send:
+ *
+ *     <u32 length of the request, with stdin, stdout and stderr as SCM_RIGHTS>
+ *     <request: binary records (see encode_records) as follows>
+ *       <working directory>
+ *       <number of environment variables>
+ *       <NAME=value, one per record>
+ *       <main class>
+ *       <main arguments, one per record>
+ *
+ * Each side only deals with a peer running as the same user, issued from its own
+ * working directory with an identical environment -- shell bookkeeping such
+ * as SHLVL aside -- since the JVM cannot take on those of each client. It
+ * answers with a single byte: SERVER_ACCEPTED, or SERVER_REFUSED, in which
+ * case the client launches normally instead. After
+ * accepting, it runs the main method on a fresh thread, with the client's stdio
+ * streams in place of its own, then replies with the exit code as a u32.
+ * Requests are served one at a time, since stdio streams are process-wide.
+ *
+ * Meanwhile, the client forwards each SIGINT, SIGTERM or SIGHUP it receives
+ * -- e.g. from Ctrl+C in its terminal -- as a u32 signal number, which the
+ * server raises in itself, as though the JVM had received the signal. If the
+ * client dies instead, the server raises SIGHUP, as upon a terminal hangup.
+ * Either way, the JVM shuts down as it would have outside the server, and
+ * the exit hook forwards its exit code to the client, if still there.
+ *
+ * The server exits once no request arrives for the idle timeout, or when the
+ * application calls System.exit, whose exit code is forwarded to the client.
+ *
+ * The Python zygote of python.h speaks the same protocol, so the client side
+ * here serves PYTHON directives too; see serve_python.
+ */
+
+#define SERVER_FLAG "--jaunch-server"
+#define SERVER_DEFAULT_TIMEOUT 600
+#define SERVER_ACCEPTED 'A'
+#define SERVER_REFUSED 'R'
+
+// =========================
+// GLOBAL STATE DECLARATIONS
+// =========================
+
+extern int server_timeout; // Idle timeout of the JVM server in seconds, or 0 if not serving.
+
+/*
+ * Parse the given argument as --jaunch-server[=<seconds>], setting server_timeout.
+ * Returns 1 if the argument is the server flag, 0 otherwise.
+ */
+int server_parse_flag(const char *arg) {
+    size_t len = strlen(SERVER_FLAG);
+    if (strncmp(arg, SERVER_FLAG, len) != 0) return 0;
+    if (arg[len] == '\0') server_timeout = SERVER_DEFAULT_TIMEOUT;
+    else if (arg[len] == '=') server_timeout = atoi(arg + len + 1);
+    else return 0;
+    if (server_timeout <= 0) server_timeout = SERVER_DEFAULT_TIMEOUT;
+    return 1;
+}
+
+/*
+ * Exit the process via Runtime.exit of the given JVM, running its shutdown
+ * hooks, with the given status. Returns only if Runtime.exit failed.
+ */
+static void runtime_exit(JavaVM *jvm, int status) {
+    JNIEnv *env;
+    if ((*jvm)->AttachCurrentThread(jvm, (void **)&env, NULL) != JNI_OK) return;
+    jclass runtimeClass = (*env)->FindClass(env, "java/lang/Runtime");
+    jmethodID getRuntime = runtimeClass == NULL ? NULL :
+        (*env)->GetStaticMethodID(env, runtimeClass, "getRuntime", "()Ljava/lang/Runtime;");
+    jobject runtime = getRuntime == NULL ? NULL :
+        (*env)->CallStaticObjectMethod(env, runtimeClass, getRuntime);
+    jmethodID exitMethod = runtime == NULL ? NULL :
+        (*env)->GetMethodID(env, runtimeClass, "exit", "(I)V");
+    if (exitMethod != NULL) (*env)->CallVoidMethod(env, runtime, exitMethod, (jint)status);
+    // Runtime.exit returns only if it failed.
+    if ((*env)->ExceptionCheck(env)) (*env)->ExceptionDescribe(env);
+}
+
+#ifdef WIN32
+
+// The JVM server relies on Unix domain sockets and SCM_RIGHTS, so on Windows,
+// every launch creates its own JVM, and server mode runs the main class once.
+
+static int server_launch(const char *runtime, const char *runtime_path, size_t sig_argc, const char **sig_argv,
+    size_t main_argc, const char **main_argv, int *exit_code)
+{
+    return 0;
+}
+
+static int serve_jvm(JavaVM *jvm, const char *libjvm_path, size_t jvm_argc, const char **jvm_argv) {
+    FAIL(ERROR_SERVER, "The JVM server is not supported on Windows");
+}
+
+static void JNICALL server_exit_hook(jint code) {}
+
+#else
+
+#include <errno.h>       // for errno, EINTR, ECONNREFUSED
+#include <limits.h>      // for INT_MAX
+#include <poll.h>        // for poll, POLLIN
+#include <pthread.h>     // for pthread_create, pthread_join
+#include <signal.h>      // for sigaction, kill, SIGHUP, SIGINT, SIGTERM
+#include <unistd.h>      // for close, dup, dup2, getcwd, getpid, getuid, pipe, read, unlink, write
+#include <sys/socket.h>  // for accept, bind, connect, listen, recvmsg, sendmsg, socket
+#include <sys/stat.h>    // for mkdir, umask
+#include <sys/un.h>      // for sockaddr_un
+
+extern char **environ;
+
+#define SERVER_MAX_REQUEST (256 * 1024 * 1024)
+
+// NB: macOS has no MSG_NOSIGNAL, but sets SO_NOSIGPIPE on the socket instead;
+// see server_no_sigpipe.
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// The signals a client forwards to the server running its main program.
+static const int server_signals[] = { SIGINT, SIGTERM, SIGHUP };
+#define SERVER_SIGNAL_COUNT (sizeof(server_signals) / sizeof(server_signals[0]))
+
+// The connection of the request being served, for the exit hook; or -1.
+static int server_client = -1;
+static const char *server_socket = NULL;
+
+/*
+ * Compute the path to the server socket for the given signature: the runtime
+ * library plus the arguments which shape the runtime, e.g. the JVM arguments.
+ * Returns a newly allocated string, or NULL if no cache directory is known
+ * or the path would be too long for a socket address.
+ */
+static char *server_socket_path(const char *runtime_path, size_t sig_argc, const char **sig_argv) {
+    char *dir = cache_dir();
+    if (dir == NULL) return NULL;
+
+    unsigned long long hash = fnv1a(14695981039346656037ULL, runtime_path);
+    for (size_t i = 0; i < sig_argc; i++) {
+        hash = fnv1a(hash, "\n");
+        hash = fnv1a(hash, sig_argv[i]);
+    }
+
+    size_t path_len = strlen(dir) + 32;
+    char *path = (char *)malloc_or_die(path_len, "server socket path");
+    snprintf(path, path_len, "%s/server-%016llx.sock", dir, hash);
+    free(dir);
+    if (strlen(path) >= sizeof(((struct sockaddr_un *)0)->sun_path)) {
+        LOG_INFO("SERVER", "Socket path is too long: %s", path);
+        free(path);
+        return NULL;
+    }
+    return path;
+}
+
+static int server_address(const char *path, struct sockaddr_un *addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    strncpy(addr->sun_path, path, sizeof(addr->sun_path) - 1);
+    return socket(AF_UNIX, SOCK_STREAM, 0);
+}
+
+/*
+ * Keeps writes to the given socket from raising SIGPIPE once its peer is gone,
+ * on platforms lacking MSG_NOSIGNAL; see write_fully.
+ */
+static void server_no_sigpipe(int fd) {
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+}
+
+static int write_fully(int fd, const char *data, size_t length) {
+    for (size_t written = 0; written < length; ) {
+        // NB: A peer which died must not take this process with it, via SIGPIPE.
+        ssize_t n = send(fd, data + written, length - written, MSG_NOSIGNAL);
+        if (n == -1 && errno == EINTR) continue;
+        if (n <= 0) return 0;
+        written += (size_t)n;
+    }
+    return 1;
+}
+
+static int read_fully(int fd, char *data, size_t length) {
+    for (size_t got = 0; got < length; ) {
+        ssize_t n = read(fd, data + got, length - got);
+        if (n == -1 && errno == EINTR) continue;
+        if (n <= 0) return 0;
+        got += (size_t)n;
+    }
+    return 1;
+}
+
+/* Checks whether the peer of the given connection runs as the same user. */
+static int server_peer_trusted(int fd) {
+#ifdef __linux__
+    // NB: Same layout as struct ucred, which glibc only declares with _GNU_SOURCE.
+    struct { pid_t pid; uid_t uid; gid_t gid; } cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0) return 0;
+    return cred.uid == getuid();
+#else
+    uid_t uid;
+    gid_t gid;
+    if (getpeereid(fd, &uid, &gid) != 0) return 0;
+    return uid == getuid();
+#endif
+}
+
+/* Checks whether the given variable is shell bookkeeping, which differs between any two shells. */
+static int server_env_ignored(const char *var) {
+    return strncmp(var, "_=", 2) == 0 || strncmp(var, "SHLVL=", 6) == 0 || strncmp(var, "OLDPWD=", 7) == 0;
+}
+
+/* Checks whether the given environment equals that of this process, apart from shell bookkeeping. */
+static int server_env_matches(size_t count, const char **vars) {
+    size_t own = 0;
+    for (char **e = environ; *e != NULL; e++) {
+        if (!server_env_ignored(*e)) own++;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const char *eq = strchr(vars[i], '=');
+        if (eq == NULL) return 0;
+        if (server_env_ignored(vars[i])) continue;
+        if (own-- == 0) return 0;
+        // Look up the variable by name, without allocating a copy of the name.
+        const char *value = NULL;
+        size_t name_len = (size_t)(eq - vars[i]);
+        for (char **e = environ; *e != NULL; e++) {
+            if (strncmp(*e, vars[i], name_len + 1) == 0) { value = *e + name_len + 1; break; }
+        }
+        if (value == NULL || strcmp(value, eq + 1) != 0) {
+            LOG_DEBUG("SERVER", "Environment variable differs: %.*s", (int)name_len, vars[i]);
+            return 0;
+        }
+    }
+    return own == 0;
+}
+
+// ===========================================================
+//                         CLIENT SIDE
+// ===========================================================
+
+// The connection to the server running our main program, for forwarding signals; or -1.
+static volatile sig_atomic_t server_connection = -1;
+
+/* Signal handler forwarding the signal number to the server; see the top of this file. */
+static void server_forward_signal(int sig) {
+    char sig_bytes[4];
+    write_u32(sig_bytes, (uint32_t)sig);
+    if (server_connection >= 0) send(server_connection, sig_bytes, sizeof(sig_bytes), MSG_NOSIGNAL);
+}
+
+/*
+ * Run the given main program -- e.g. main class and arguments -- in a running
+ * server of the given runtime with a matching signature, if any.
+ * Returns 1 if the server ran it, storing its exit code into *exit_code,
+ * or 0 if there is no such server or it refused, so that the caller launches normally.
+ */
+static int server_launch(const char *runtime, const char *runtime_path, size_t sig_argc, const char **sig_argv,
+    size_t main_argc, const char **main_argv, int *exit_code)
+{
+    char *socket_path = server_socket_path(runtime_path, sig_argc, sig_argv);
+    if (socket_path == NULL) return 0;
+    if (access(socket_path, F_OK) != 0) {
+        free(socket_path);
+        return 0;
+    }
+
+    long long trace_start = trace_now();
+    struct sockaddr_un addr;
+    int fd = server_address(socket_path, &addr);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        // NB: A socket nobody listens on is left over from a server which died.
+        if (errno == ECONNREFUSED) unlink(socket_path);
+        LOG_INFO("SERVER", "No %s server at %s: %s", runtime, socket_path, strerror(errno));
+        if (fd >= 0) close(fd);
+        free(socket_path);
+        return 0;
+    }
+    if (!server_peer_trusted(fd)) {
+        // NB: Our environment and stdio streams are not for another user's eyes.
+        LOG_WARN("Ignoring %s server at %s, which runs as another user", runtime, socket_path);
+        close(fd);
+        free(socket_path);
+        return 0;
+    }
+    server_no_sigpipe(fd);
+    LOG_INFO("SERVER", "Connected to %s server at %s", runtime, socket_path);
+
+    // Assemble the request.
+    char *cwd = getcwd(NULL, 0);
+    size_t env_count = 0;
+    while (environ[env_count] != NULL) env_count++;
+    char env_count_str[32];
+    snprintf(env_count_str, sizeof(env_count_str), "%zu", env_count);
+    size_t count = 2 + env_count + main_argc;
+    const char **records = malloc_or_die(count * sizeof(char *), "server request");
+    size_t r = 0;
+    records[r++] = cwd == NULL ? "" : cwd;
+    records[r++] = env_count_str;
+    for (size_t i = 0; i < env_count; i++) records[r++] = environ[i];
+    for (size_t i = 0; i < main_argc; i++) records[r++] = main_argv[i];
+    size_t length;
+    char *request = encode_records(count, records, &length);
+    free(records);
+    free(cwd);
+
+    // Send the request length along with our stdio streams, then the request itself.
+    char length_bytes[4];
+    write_u32(length_bytes, (uint32_t)length);
+    struct iovec iov = { length_bytes, sizeof(length_bytes) };
+    int fds[3] = { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO };
+    char control[CMSG_SPACE(sizeof(fds))];
+    memset(control, 0, sizeof(control));
+    struct msghdr msg = { 0 };
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    fflush(stdout);
+    fflush(stderr);
+    char reply = SERVER_REFUSED;
+    int sent = sendmsg(fd, &msg, 0) == (ssize_t)sizeof(length_bytes) &&
+        write_fully(fd, request, length);
+    free(request);
+    if (!sent || !read_fully(fd, &reply, 1) || reply != SERVER_ACCEPTED) {
+        LOG_INFO("SERVER", "%s server did not accept the request; launching normally", runtime);
+        close(fd);
+        free(socket_path);
+        return 0;
+    }
+
+    // The main program is now running; await its exit code, forwarding signals meanwhile.
+    struct sigaction forward, previous[SERVER_SIGNAL_COUNT];
+    memset(&forward, 0, sizeof(forward));
+    forward.sa_handler = server_forward_signal;
+    forward.sa_flags = SA_RESTART;
+    sigemptyset(&forward.sa_mask);
+    server_connection = fd;
+    for (size_t i = 0; i < SERVER_SIGNAL_COUNT; i++) sigaction(server_signals[i], &forward, &previous[i]);
+    char code_bytes[4];
+    int finished = read_fully(fd, code_bytes, sizeof(code_bytes));
+    for (size_t i = 0; i < SERVER_SIGNAL_COUNT; i++) sigaction(server_signals[i], &previous[i], NULL);
+    server_connection = -1;
+    if (finished) *exit_code = (int)read_u32(code_bytes);
+    else {
+        LOG_ERROR("%s server at %s terminated unexpectedly", runtime, socket_path);
+        *exit_code = ERROR_RUNTIME_CRASH;
+    }
+    close(fd);
+    trace_span(runtime, "server", trace_start, main_argc > 0 ? main_argv[0] : NULL);
+    free(socket_path);
+    return 1;
+}
+
+// ===========================================================
+//                         SERVER SIDE
+// ===========================================================
+
+typedef struct {
+    JavaVM *jvm;
+    const char *main_class_name;
+    size_t main_argc;
+    const char **main_argv;
+    int exit_code;
+} ServerRequest;
+
+/* Flushes System.out or System.err, which the client's streams are about to leave. */
+static void server_flush(JNIEnv *env, const char *name) {
+    jclass system = (*env)->FindClass(env, "java/lang/System");
+    jfieldID field = system == NULL ? NULL :
+        (*env)->GetStaticFieldID(env, system, name, "Ljava/io/PrintStream;");
+    jobject stream = field == NULL ? NULL : (*env)->GetStaticObjectField(env, system, field);
+    if (stream != NULL) {
+        jmethodID flush = (*env)->GetMethodID(env, (*env)->GetObjectClass(env, stream), "flush", "()V");
+        if (flush != NULL) (*env)->CallVoidMethod(env, stream, flush);
+    }
+    (*env)->ExceptionClear(env);
+}
+
+/* Runs the main method of one request, on a fresh thread attached to the JVM. */
+static void *server_run_main(void *arg) {
+    ServerRequest *request = (ServerRequest *)arg;
+    JavaVM *jvm = request->jvm;
+    JNIEnv *env;
+    request->exit_code = ERROR_CREATE_JAVA_VM;
+    if ((*jvm)->AttachCurrentThread(jvm, (void **)&env, NULL) != JNI_OK) return NULL;
+
+    jclass mainClass = (*env)->FindClass(env, request->main_class_name);
+    jmethodID mainMethod = mainClass == NULL ? NULL :
+        (*env)->GetStaticMethodID(env, mainClass, "main", "([Ljava/lang/String;)V");
+    if (mainMethod == NULL) {
+        (*env)->ExceptionDescribe(env);
+        request->exit_code = mainClass == NULL ? ERROR_FIND_CLASS : ERROR_GET_STATIC_METHOD_ID;
+    }
+    else {
+        jobjectArray javaArgs = (*env)->NewObjectArray(env, request->main_argc,
+            (*env)->FindClass(env, "java/lang/String"), NULL);
+        for (size_t i = 0; i < request->main_argc; i++) {
+            (*env)->SetObjectArrayElement(env, javaArgs, i, (*env)->NewStringUTF(env, request->main_argv[i]));
+        }
+        (*env)->CallStaticVoidMethodA(env, mainClass, mainMethod, (jvalue *)&javaArgs);
+        // Like the java launcher, report an uncaught exception with exit code 1.
+        if ((*env)->ExceptionCheck(env)) {
+            (*env)->ExceptionDescribe(env);
+            request->exit_code = 1;
+        }
+        else request->exit_code = SUCCESS;
+    }
+
+    server_flush(env, "out");
+    server_flush(env, "err");
+    (*jvm)->DetachCurrentThread(jvm);
+    return NULL;
+}
+
+typedef struct {
+    JavaVM *jvm;
+    int client;
+    int stop; // Read end of a pipe, which the watcher stops upon.
+} ServerWatch;
+
+/*
+ * Raise the given signal in the served JVM. If the JVM does not handle it --
+ * e.g. because the server was started with the signal ignored, or with -Xrs --
+ * exit via Runtime.exit instead, with the code the JVM's handler would use.
+ */
+static void server_raise(JavaVM *jvm, int sig) {
+    struct sigaction current;
+    if (sigaction(sig, NULL, &current) == 0 &&
+        current.sa_handler != SIG_IGN && current.sa_handler != SIG_DFL)
+    {
+        kill(getpid(), sig);
+    }
+    else runtime_exit(jvm, 128 + sig);
+}
+
+/*
+ * Watches the client while its main method runs, until told to stop:
+ * raises each signal the client forwards, or SIGHUP if it dies.
+ */
+static void *server_watch_client(void *arg) {
+    ServerWatch *watch = (ServerWatch *)arg;
+    struct pollfd pfds[2] = { { watch->client, POLLIN, 0 }, { watch->stop, POLLIN, 0 } };
+    while (1) {
+        int ready = poll(pfds, 2, -1);
+        if (ready == -1 && errno == EINTR) continue;
+        if (ready <= 0 || pfds[1].revents != 0) return NULL;
+        char sig_bytes[4];
+        if (!read_fully(watch->client, sig_bytes, sizeof(sig_bytes))) {
+            // NB: No logging, since the client's stdio streams are swapped in.
+            server_raise(watch->jvm, SIGHUP);
+            return NULL;
+        }
+        int sig = (int)read_u32(sig_bytes);
+        for (size_t i = 0; i < SERVER_SIGNAL_COUNT; i++) {
+            if (sig == server_signals[i]) server_raise(watch->jvm, sig);
+        }
+    }
+}
+
+/*
+ * Exit hook of the served JVM, called when the application calls System.exit:
+ * forwards the exit code to the client being served, before the server dies.
+ */
+static void JNICALL server_exit_hook(jint code) {
+    if (server_client >= 0) {
+        char code_bytes[4];
+        write_u32(code_bytes, (uint32_t)code);
+        write_fully(server_client, code_bytes, sizeof(code_bytes));
+    }
+    if (server_socket != NULL) unlink(server_socket);
+}
+
+/* Receives the request length along with the client's stdio streams. */
+static int server_receive_header(int client, uint32_t *length, int fds[3]) {
+    char length_bytes[4];
+    struct iovec iov = { length_bytes, sizeof(length_bytes) };
+    char control[CMSG_SPACE(3 * sizeof(int))];
+    struct msghdr msg = { 0 };
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t n;
+    do n = recvmsg(client, &msg, 0); while (n == -1 && errno == EINTR);
+    if (n <= 0) return 0;
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS ||
+        cmsg->cmsg_len != CMSG_LEN(3 * sizeof(int)))
+    {
+        return 0;
+    }
+    memcpy(fds, CMSG_DATA(cmsg), 3 * sizeof(int));
+    if ((size_t)n < sizeof(length_bytes) &&
+        !read_fully(client, length_bytes + n, sizeof(length_bytes) - (size_t)n))
+    {
+        for (int i = 0; i < 3; i++) close(fds[i]);
+        return 0;
+    }
+    *length = read_u32(length_bytes);
+    return 1;
+}
+
+/* Serves one client connection. */
+static void server_handle(JavaVM *jvm, int client) {
+    if (!server_peer_trusted(client)) {
+        LOG_ERROR("Rejecting JVM server connection from another user");
+        return;
+    }
+    uint32_t length;
+    int fds[3];
+    if (!server_receive_header(client, &length, fds)) {
+        LOG_INFO("SERVER", "Ignoring malformed request");
+        return;
+    }
+
+    char reply = SERVER_REFUSED;
+    char *buffer = length > SERVER_MAX_REQUEST ? NULL : malloc_or_die((size_t)length + 1, "server request");
+    size_t count = 0;
+    char **strings = NULL;
+    if (buffer != NULL && read_fully(client, buffer, length) &&
+        length >= PROTOCOL_HEADER_LEN + 4 && memcmp(buffer, PROTOCOL_HEADER, PROTOCOL_HEADER_LEN) == 0)
+    {
+        // NB: Drop the record count of the input format, leaving the output
+        // format that parse_output understands; then check the count matches.
+        const uint32_t expected = read_u32(buffer + PROTOCOL_HEADER_LEN);
+        memmove(buffer + PROTOCOL_HEADER_LEN, buffer + PROTOCOL_HEADER_LEN + 4, length - PROTOCOL_HEADER_LEN - 4);
+        strings = parse_output(buffer, length - 4, &count);
+        buffer = NULL; // NB: parse_output takes ownership of the buffer.
+        if (count != expected) count = 0;
+    }
+
+    // Check that we can take on the client's circumstances.
+    const int env_count_value = count >= 3 ? atoi(strings[1]) : -1;
+    const size_t env_count = env_count_value < 0 ? 0 : (size_t)env_count_value;
+    if (env_count_value >= 0 && env_count <= count - 3) {
+        char *cwd = getcwd(NULL, 0);
+        if (cwd == NULL || strcmp(cwd, strings[0]) != 0) {
+            LOG_INFO("SERVER", "Refusing request from another working directory: %s", strings[0]);
+        }
+        else if (!server_env_matches(env_count, (const char **)strings + 2)) {
+            LOG_INFO("SERVER", "Refusing request with a different environment");
+        }
+        else reply = SERVER_ACCEPTED;
+        free(cwd);
+    }
+    else LOG_INFO("SERVER", "Ignoring truncated request");
+    if (!write_fully(client, &reply, 1)) reply = SERVER_REFUSED;
+
+    if (reply == SERVER_ACCEPTED) {
+        ServerRequest request = {
+            jvm,
+            strings[2 + env_count],
+            count - 3 - env_count,
+            (const char **)strings + 3 + env_count,
+            SUCCESS
+        };
+        LOG_INFO("SERVER", "Running %s", request.main_class_name);
+        long long trace_start = trace_now();
+
+        // Swap in the client's stdio streams for the duration of the request.
+        // NB: No logging until they are swapped back out again.
+        fflush(stdout);
+        fflush(stderr);
+        int saved[3];
+        for (int i = 0; i < 3; i++) {
+            saved[i] = dup(i);
+            dup2(fds[i], i);
+        }
+        server_client = client;
+
+        // NB: The watcher stops once the write end of its pipe is closed.
+        int stop_pipe[2];
+        ServerWatch watch = { jvm, client, -1 };
+        pthread_t watcher;
+        int watching = pipe(stop_pipe) == 0;
+        if (watching) watch.stop = stop_pipe[0];
+        if (watching && pthread_create(&watcher, NULL, server_watch_client, &watch) != 0) {
+            close(stop_pipe[0]);
+            close(stop_pipe[1]);
+            watching = 0;
+        }
+
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, server_run_main, &request) == 0) pthread_join(thread, NULL);
+        else request.exit_code = ERROR_SERVER;
+
+        if (watching) {
+            close(stop_pipe[1]);
+            pthread_join(watcher, NULL);
+            close(stop_pipe[0]);
+        }
+
+        server_client = -1;
+        fflush(stdout);
+        fflush(stderr);
+        for (int i = 0; i < 3; i++) {
+            dup2(saved[i], i);
+            close(saved[i]);
+        }
+        trace_span("JVM", "main", trace_start, request.main_class_name);
+        LOG_INFO("SERVER", "%s finished with exit code %d", request.main_class_name, request.exit_code);
+
+        char code_bytes[4];
+        write_u32(code_bytes, (uint32_t)request.exit_code);
+        write_fully(client, code_bytes, sizeof(code_bytes));
+    }
+
+    for (int i = 0; i < 3; i++) close(fds[i]);
+    free(buffer);
+    free(strings);
+}
+
+/*
+ * Listen on the given server socket, unless a live server already does.
+ * Returns the listening socket, or -1 on failure.
+ */
+static int server_listen(const char *runtime, const char *socket_path) {
+    // Refuse to replace a live server; clear away a dead one.
+    struct sockaddr_un addr;
+    int fd = server_address(socket_path, &addr);
+    if (fd >= 0 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+        close(fd);
+        LOG_ERROR("A %s server is already listening at %s", runtime, socket_path);
+        return -1;
+    }
+    if (fd >= 0) close(fd);
+    unlink(socket_path);
+
+    char *dir = cache_dir();
+    if (dir != NULL) mkdir(dir, 0700);
+    free(dir);
+
+    // NB: The socket is accessible to its owner only.
+    fd = server_address(socket_path, &addr);
+    mode_t old_mask = umask(0077);
+    int bound = fd >= 0 && bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+    umask(old_mask);
+    if (!bound || listen(fd, 16) != 0) {
+        LOG_ERROR("Failed to listen at %s: %s", socket_path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*
+ * Serve requests to run main classes in the given JVM, on a socket named after
+ * its signature, until no request arrives for server_timeout seconds.
+ */
+static int serve_jvm(JavaVM *jvm, const char *libjvm_path, size_t jvm_argc, const char **jvm_argv) {
+    char *socket_path = server_socket_path(libjvm_path, jvm_argc, jvm_argv);
+    if (socket_path == NULL) FAIL(ERROR_SERVER, "No location for the JVM server socket");
+    int fd = server_listen("JVM", socket_path);
+    if (fd < 0) {
+        free(socket_path);
+        return ERROR_SERVER;
+    }
+    server_socket = socket_path;
+    fprintf(stderr, "Jaunch JVM server listening at %s (idle timeout %d seconds)\n",
+        socket_path, server_timeout);
+
+    const int timeout_ms = server_timeout > INT_MAX / 1000 ? INT_MAX : server_timeout * 1000;
+    while (1) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        int ready = poll(&pfd, 1, timeout_ms);
+        if (ready == -1 && errno == EINTR) continue;
+        if (ready <= 0) break;
+        int client = accept(fd, NULL, NULL);
+        if (client < 0) continue;
+        server_no_sigpipe(client);
+        server_handle(jvm, client);
+        close(client);
+    }
+
+    LOG_INFO("SERVER", "JVM server idle for %d seconds; shutting down", server_timeout);
+    close(fd);
+    unlink(socket_path);
+    server_socket = NULL;
+    free(socket_path);
+    return SUCCESS;
+}
+
+#endif
+
+#endif
@@ -2,6 +2,7 @@
 #define _JAUNCH_THREAD_H
 
 #include <errno.h>    // for EDEADLK, EPERM
+#include <limits.h>   // for PTHREAD_STACK_MIN
 #include <pthread.h>  // for pthread_mutex, pthread_cond, etc.
 #include <stdlib.h>   // for NULL, size_t, free
 
@@ -20,6 +21,23 @@ typedef enum {
     STATE_COMPLETE     // All directive processing is complete
 } ThreadState;
 
+// Suffix of a directive name marking it as asynchronous (see process_directives).
+#define ASYNC_MARKER '&'
+
+// Maximum number of worker threads executing asynchronous directives at once.
+#define ASYNC_WORKERS 4
+
+typedef int (*DirectiveFunc)(const char *, size_t, const char **);
+
+// An asynchronous directive, queued for a worker thread (see ctx_submit_async).
+typedef struct {
+    DirectiveFunc execute;
+    const char *directive;
+    size_t argc;
+    const char **argv;
+    int result;
+} AsyncDirective;
+
 static inline char *thread_state(ThreadState state) {
   if (state == STATE_WAITING) return "WAITING";
   if (state == STATE_EXECUTING) return "EXECUTING";
@@ -50,10 +68,11 @@ static inline char *thread_state(ThreadState state) {
  *    These functions assume the caller does *not* have the lock, and perform
  *    their operations bracketed with ctx_lock() and ctx_unlock() internally.
  *
- * 5. Thread ID fields (thread_id_main, thread_id_directives) - These are set
- *    once during initialization and are effectively read-only thereafter. The
- *    thread_name() function reads these without locking to avoid deadlock in
- *    logging paths.
+ * 5. Thread ID fields (thread_id_main, thread_id_directives, thread_id_runtime,
+ *    thread_id_workers) - These are set once during initialization (or, for
+ *    the runtime and worker threads, once per thread) and are effectively
+ *    read-only thereafter. The thread_name() function reads these without
+ *    locking to avoid deadlock in logging paths.
  *
  * For all other accesses, use ctx_lock() and ctx_unlock() to protect field reads
  * and writes. This ensures thread safety and prevents data races.
@@ -76,9 +95,22 @@ typedef struct {
     // Runloop configuration.
     const char *runloop_mode;
 
+    // Queue of asynchronous directives, and the worker threads executing them.
+    // Directives before async_next have been taken by a worker; async_done
+    // counts those which have finished.
+    AsyncDirective *async_queue;
+    size_t async_count;
+    size_t async_capacity;
+    size_t async_next;
+    size_t async_done;
+    int async_workers;
+    pthread_cond_t async_cond;
+
     // Bookmarked thread IDs, for use with thread_name function.
     pthread_t thread_id_main;
     pthread_t thread_id_directives;
+    pthread_t thread_id_runtime;
+    pthread_t thread_id_workers[ASYNC_WORKERS];
 
     // Exit code to use at process conclusion.
     int exit_code;
@@ -109,6 +141,10 @@ static inline ThreadContext *ctx() {
 const char *thread_name(pthread_t thread_id) {
     CHECK_THREAD_ID(thread_id, ctx()->thread_id_main, "main");
     CHECK_THREAD_ID(thread_id, ctx()->thread_id_directives, "directives");
+    CHECK_THREAD_ID(thread_id, ctx()->thread_id_runtime, "runtime");
+    for (int w = 0; w < ASYNC_WORKERS; w++) {
+        CHECK_THREAD_ID(thread_id, ctx()->thread_id_workers[w], "worker");
+    }
     return "unknown";
 }
 
@@ -142,7 +178,16 @@ static inline void ctx_create() {
     ctx->directive_result = 0;
     ctx->thread_id_main = pthread_self();
     ctx->thread_id_directives = 0;
+    ctx->thread_id_runtime = 0;
+    for (int w = 0; w < ASYNC_WORKERS; w++) ctx->thread_id_workers[w] = 0;
     ctx->runloop_mode = NULL;
+    ctx->async_queue = NULL;
+    ctx->async_count = 0;
+    ctx->async_capacity = 0;
+    ctx->async_next = 0;
+    ctx->async_done = 0;
+    ctx->async_workers = 0;
+    pthread_cond_init(&ctx->async_cond, NULL);
     ctx->exit_code = 0;
 
     context = ctx;
@@ -153,6 +198,8 @@ static inline void ctx_destroy() {
     if (context == NULL) return;
     pthread_mutex_destroy(&context->mutex);
     pthread_cond_destroy(&context->cond);
+    pthread_cond_destroy(&context->async_cond);
+    free(context->async_queue);
     free(context);
     context = NULL;
 }
@@ -295,4 +342,164 @@ int ctx_request_main_execution(const char *directive, size_t dir_argc, const cha
     return result;
 }
 
+// ======================
+// ASYNCHRONOUS DIRECTIVES
+// ======================
+
+static void *run_async_worker(void *unused) {
+    ctx_lock();
+    int slot = 0;
+    while (slot < ASYNC_WORKERS && ctx()->thread_id_workers[slot]) slot++;
+    if (slot < ASYNC_WORKERS) ctx()->thread_id_workers[slot] = pthread_self();
+
+    // Execute queued directives until none are left.
+    while (ctx()->async_next < ctx()->async_count) {
+        size_t i = ctx()->async_next++;
+        AsyncDirective job = ctx()->async_queue[i];
+        ctx_unlock();
+
+        LOG_INFO("JAUNCH", "Executing %s directive on worker thread", job.directive);
+        int result = job.execute(job.directive, job.argc, job.argv);
+
+        ctx_lock();
+        ctx()->async_queue[i].result = result;
+        ctx()->async_done++;
+        pthread_cond_broadcast(&ctx()->async_cond);
+    }
+
+    if (slot < ASYNC_WORKERS) ctx()->thread_id_workers[slot] = 0;
+    ctx()->async_workers--;
+    pthread_cond_broadcast(&ctx()->async_cond);
+    ctx_unlock();
+    return NULL;
+}
+
+/*
+ * Queue the given directive for execution by a worker thread, concurrently
+ * with the caller, starting another worker if fewer than ASYNC_WORKERS run.
+ * If no worker thread can be started, executes the directive right away.
+ * Thread-safe operation that handles locking internally.
+ */
+void ctx_submit_async(DirectiveFunc execute, const char *directive, size_t dir_argc, const char **dir_argv) {
+    ctx_lock();
+    if (ctx()->async_count == ctx()->async_capacity) {
+        ctx()->async_capacity = ctx()->async_capacity == 0 ? 8 : 2 * ctx()->async_capacity;
+        AsyncDirective *grown = (AsyncDirective *)realloc(ctx()->async_queue,
+            ctx()->async_capacity * sizeof(AsyncDirective));
+        if (grown == NULL) DIE(ERROR_REALLOC, "Failed to reallocate memory (async queue)");
+        ctx()->async_queue = grown;
+    }
+    AsyncDirective job = { execute, directive, dir_argc, dir_argv, SUCCESS };
+    ctx()->async_queue[ctx()->async_count++] = job;
+
+    // NB: Running workers are all busy, since they exit once the queue is empty.
+    int started = 1;
+    if (ctx()->async_workers < ASYNC_WORKERS) {
+        pthread_t worker;
+        started = pthread_create(&worker, NULL, run_async_worker, NULL) == 0;
+        if (started) {
+            pthread_detach(worker);
+            ctx()->async_workers++;
+        }
+    }
+    int workers = ctx()->async_workers;
+    ctx_unlock();
+
+    if (!started && workers == 0) {
+        LOG_INFO("JAUNCH", "Failed to start worker thread; executing %s directive directly", directive);
+        ctx_lock();
+        ctx()->async_workers++;
+        ctx_unlock();
+        run_async_worker(NULL);
+    }
+}
+
+/*
+ * Wait for all asynchronous directives queued so far to finish, and empty the queue.
+ * Returns their error codes combined in queue order, as process_directives does
+ * for the synchronous ones, so that the result does not depend on which finishes first.
+ * Thread-safe operation that handles locking internally.
+ */
+int ctx_await_async() {
+    ctx_lock();
+    while (ctx()->async_done < ctx()->async_count || ctx()->async_workers > 0) {
+        pthread_cond_wait(&ctx()->async_cond, &ctx()->mutex);
+    }
+    int exit_code = SUCCESS;
+    for (size_t i = 0; i < ctx()->async_count; i++) {
+        AsyncDirective *job = &ctx()->async_queue[i];
+        if (job->result == SUCCESS) continue;
+        LOG_INFO("JAUNCH", "%s directive failed with code %d", job->directive, job->result);
+        exit_code |= job->result; // Remember non-zero error code bits.
+    }
+    ctx()->async_count = 0;
+    ctx()->async_next = 0;
+    ctx()->async_done = 0;
+    ctx_unlock();
+    return exit_code;
+}
+
+// ==============
+// RUNTIME THREAD
+// ==============
+
+// NB: Thread stacks are rounded up to this granularity, a multiple of the
+// page size on all supported platforms, as some pthreads implementations
+// reject stack sizes which are not a multiple of the page size.
+#define RUNTIME_STACK_GRANULARITY 65536
+
+typedef struct {
+    LaunchFunc launch_runtime;
+    size_t argc;
+    const char **argv;
+    int result;
+} RuntimeLaunch;
+
+static void *run_runtime_thread(void *arg) {
+    RuntimeLaunch *runtime = (RuntimeLaunch *)arg;
+    ctx_lock();
+    ctx()->thread_id_runtime = pthread_self();
+    ctx_unlock();
+
+    runtime->result = runtime->launch_runtime(runtime->argc, runtime->argv);
+
+    ctx_lock();
+    if (pthread_equal(ctx()->thread_id_runtime, pthread_self())) ctx()->thread_id_runtime = 0;
+    ctx_unlock();
+    return NULL;
+}
+
+/*
+ * Run the given launch function on a new runtime thread with a stack of the
+ * given size in bytes, and wait for it to finish, like the java command runs
+ * the main method on a new thread sized by -Xss. The calling thread -- main
+ * or directives, whichever executes the directive -- keeps its state meanwhile.
+ * Returns the result of the launch function.
+ * Thread-safe operation that handles locking internally.
+ */
+int ctx_run_runtime_thread(const LaunchFunc launch_runtime, size_t stack_size,
+    const size_t argc, const char **argv)
+{
+#ifdef PTHREAD_STACK_MIN
+    if (stack_size < PTHREAD_STACK_MIN) stack_size = PTHREAD_STACK_MIN;
+#endif
+    stack_size = (stack_size + RUNTIME_STACK_GRANULARITY - 1) / RUNTIME_STACK_GRANULARITY * RUNTIME_STACK_GRANULARITY;
+
+    LOG_INFO("JAUNCH", "Starting runtime thread with %zu byte stack", stack_size);
+    RuntimeLaunch runtime = { launch_runtime, argc, argv, SUCCESS };
+    pthread_t runtime_thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+    int result = pthread_attr_setstacksize(&attr, stack_size);
+    if (result == 0) result = pthread_create(&runtime_thread, &attr, run_runtime_thread, &runtime);
+    pthread_attr_destroy(&attr);
+    if (result != 0) {
+        FAIL(ERROR_THREAD_CREATE, "Failed to start runtime thread with %zu byte stack (error %d)",
+            stack_size, result);
+    }
+    pthread_join(runtime_thread, NULL);
+    return runtime.result;
+}
+
 #endif
@@ -0,0 +1,104 @@
+#ifndef _JAUNCH_TRACE_H
+#define _JAUNCH_TRACE_H
+
+#include <pthread.h>  // for pthread_self
+#include <stdint.h>   // for uintptr_t
+#include <stdio.h>    // for FILE, fopen, fprintf, fputs, fputc, fflush, ftell, fseek
+#include <stdlib.h>   // for NULL, getenv
+#include <unistd.h>   // for getpid
+
+#include "logging.h"
+#include "common.h"
+
+/*
+ * This is the logic implementing Jaunch's startup trace.
+ *
+ * When the JAUNCH_TRACE environment variable names a file, the launcher
+ * appends to it one Chrome trace event per startup phase, in the JSON Array
+ * Format understood by chrome://tracing and https://ui.perfetto.dev/:
+ *
+ *     [
+ *     {"name":"run_command","cat":"launcher","ph":"X","ts":...,"dur":...,"pid":...,"tid":...},
+ *     ...
+ *
+ * The configurator inherits the variable, and appends its own phases to the
+ * same file (see trace.kt). Timestamps are in microseconds of the system-wide
+ * monotonic clock, so that events of both processes line up. The closing `]`
+ * is deliberately omitted, which the trace format permits, so that further
+ * events -- including those of subsequent launches -- can always be appended.
+ */
+
+#define TRACE_ENV "JAUNCH_TRACE"
+
+// -- GLOBAL STATE DECLARATIONS --
+
+extern FILE *trace_file;
+extern long long trace_origin;
+
+// -- FUNCTIONS --
+
+/* Writes the given string as a JSON string literal. */
+static void trace_write_json_string(const char *s) {
+    fputc('"', trace_file);
+    for (; *s != '\0'; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') fprintf(trace_file, "\\%c", c);
+        else if (c < 0x20) fprintf(trace_file, "\\u%04x", c);
+        else fputc(c, trace_file);
+    }
+    fputc('"', trace_file);
+}
+
+/* Starts tracing, if requested via the JAUNCH_TRACE environment variable. */
+void trace_init() {
+    trace_origin = monotonic_micros();
+    const char *trace_path = getenv(TRACE_ENV);
+    if (trace_path == NULL || trace_path[0] == '\0') return;
+
+    trace_file = fopen(trace_path, "a");
+    if (trace_file == NULL) {
+        LOG_WARN("Cannot write trace file %s", trace_path);
+        return;
+    }
+    fseek(trace_file, 0, SEEK_END);
+    if (ftell(trace_file) == 0) fputs("[\n", trace_file);
+    fprintf(trace_file,
+        "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"jaunch launcher\"}},\n",
+        (int)getpid());
+    fflush(trace_file);
+    LOG_INFO("TRACE", "Writing startup trace to %s", trace_path);
+}
+
+/* Gets the start time of a phase to trace, or 0 when not tracing. */
+long long trace_now() {
+    return trace_file == NULL ? 0 : monotonic_micros();
+}
+
+/*
+ * Records a phase which started at the given time (see trace_now) and ends now.
+ * The optional detail (e.g. a library path) is attached to the event's args.
+ */
+void trace_span(const char *category, const char *name, long long start, const char *detail) {
+    if (trace_file == NULL) return;
+    long long end = monotonic_micros();
+    fprintf(trace_file,
+        "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":%d,\"tid\":%llu",
+        name, category, start, end - start, (int)getpid(),
+        (unsigned long long)(uintptr_t)pthread_self());
+    if (detail != NULL) {
+        fputs(",\"args\":{\"detail\":", trace_file);
+        trace_write_json_string(detail);
+        fputc('}', trace_file);
+    }
+    fputs("},\n", trace_file);
+    fflush(trace_file);
+}
+
+/* Stops tracing. */
+void trace_close() {
+    if (trace_file == NULL) return;
+    fclose(trace_file);
+    trace_file = NULL;
+}
+
+#endif
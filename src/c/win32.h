@@ -10,6 +10,7 @@
 #define OS_NAME "windows"
 #define SLASH "\\"
 #define EXE_SUFFIX ".exe"
+#define LIB_SUFFIX ".dll"
 
 #ifdef __aarch64__
     // Kotlin Native does not yet support targeting windows-arm64.
@@ -25,27 +26,83 @@
 //                      HELPER FUNCTIONS
 // ===========================================================
 
-void write_line(HANDLE stdinWrite, const char *input) {
-    // Copy the input string and add a newline.
-    size_t inputLength = strlen(input);
-    char *line = (char *)malloc_or_die(inputLength + 2, "line buffer"); // +1 for newline, +1 for null terminator
-    strcpy(line, input);
-    strcat(line, "\n");
-
-    // Write the string with newline to the pipe.
-    DWORD bytesWritten;
-    if (!WriteFile(stdinWrite, line, inputLength + 1, &bytesWritten, NULL)) {
-        DIE(ERROR_PIPE, "Failed writing to stdin: %lu", GetLastError());
+void write_all(HANDLE stdinWrite, const char *data, size_t length) {
+    while (length > 0) {
+        DWORD bytesWritten;
+        DWORD chunk = length > 0x40000000 ? 0x40000000 : (DWORD)length;
+        if (!WriteFile(stdinWrite, data, chunk, &bytesWritten, NULL)) {
+            DIE(ERROR_PIPE, "Failed writing to stdin: %lu", GetLastError());
+        }
+        data += bytesWritten;
+        length -= bytesWritten;
     }
-
-    // Free allocated memory.
-    free(line);
 }
 
 int file_exists(const char *path) {
     return GetFileAttributesA(path) != INVALID_FILE_ATTRIBUTES;
 }
 
+/*
+ * Describe the given file's identity as "<mtime>:<size>:<inode>", or "-" if it
+ * does not exist, with the mtime in nanoseconds since the epoch, as in posix.h.
+ * Windows has no inodes, so that part is always 0. Sizes of
+ * directories are reported as 0. The configurator's stamps (see cache.kt)
+ * must be formatted identically.
+ */
+void file_stamp(const char *path, char *stamp, size_t len) {
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &data)) {
+        snprintf(stamp, len, "-");
+        return;
+    }
+    ULONGLONG ticks = ((ULONGLONG)data.ftLastWriteTime.dwHighDateTime << 32) |
+        data.ftLastWriteTime.dwLowDateTime;
+    // Convert 100-nanosecond ticks since 1601 into nanoseconds since 1970.
+    long long mtime = ((long long)ticks - 116444736000000000LL) * 100LL;
+    long long size = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ? 0 :
+        (long long)(((ULONGLONG)data.nFileSizeHigh << 32) | data.nFileSizeLow);
+    snprintf(stamp, len, "%lld:%lld:0", mtime, size);
+}
+
+/*
+ * Reads the given file into the file cache. Windows has no advisory
+ * read-ahead for whole files, so this reads it sequentially, discarding
+ * the data, and thus only returns once the file has been read.
+ */
+void file_prefetch(const char *path) {
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) return;
+    char *buffer = malloc_or_die(256 * 1024, "prefetch buffer");
+    DWORD bytes_read;
+    while (ReadFile(file, buffer, 256 * 1024, &bytes_read, NULL) && bytes_read > 0) {}
+    free(buffer);
+    CloseHandle(file);
+}
+
+/*
+ * Sets the last access time of the given file to now, leaving its last write
+ * time (and thus its stamp; see file_stamp) alone.
+ */
+void file_mark_used(const char *path) {
+    HANDLE file = CreateFileA(path, FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return;
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    SetFileTime(file, NULL, &now, NULL);
+    CloseHandle(file);
+}
+
+/* Microseconds since an arbitrary, but system-wide, point in time. */
+long long monotonic_micros() {
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (long long)(counter.QuadPart / frequency.QuadPart * 1000000LL +
+        counter.QuadPart % frequency.QuadPart * 1000000LL / frequency.QuadPart);
+}
+
 /**
  * Get the parent directory of a path.
  * Returns a newly allocated string, or NULL if there is no parent.
@@ -310,6 +367,19 @@ void teardown() {
     // corresponding FreeConsole() here to dispose of it.
 }
 
+/* The Windows way of locating the per-user cache directory: %LOCALAPPDATA%\jaunch. */
+char *cache_dir() {
+    char *override = cache_dir_override();
+    if (override != NULL) return override;
+    const char *local_app_data = getenv("LOCALAPPDATA");
+    if (local_app_data == NULL) return NULL;
+    const char *subdir = "\\jaunch";
+    char *dir = malloc_or_die(strlen(local_app_data) + strlen(subdir) + 1, "cache dir");
+    strcpy(dir, local_app_data);
+    strcat(dir, subdir);
+    return dir;
+}
+
 void *lib_open(const char *path) {
     // On Windows, add the DLL's directory to the PATH environment variable.
     // This ensures that dependent DLLs can be found via the standard LoadLibrary
@@ -349,6 +419,8 @@ void *lib_open(const char *path) {
 
     return lib;
 }
+// NB: Windows has no global symbol namespace, so every library is local.
+void *lib_open_local(const char *path) { return lib_open(path); }
 void *lib_sym(void *library, const char *symbol) { return GetProcAddress(library, symbol); }
 void lib_close(void *library) { FreeLibrary(library); }
 char *lib_error() {
@@ -420,12 +492,14 @@ void run_command(const char *command,
 
     // Add CREATE_NO_WINDOW flag to prevent console window from appearing.
     DWORD createFlags = CREATE_NO_WINDOW;
-    char *commandPlusDash = malloc_or_die(strlen(command) + 3, "command plus dash");
+    // NB: We pass a "-" argument to indicate to the jaunch configurator
+    // that it should harvest the actual input arguments from the stdin
+    // stream, in the binary protocol. We do this to avoid issues with quoting.
+    const char *dashArgs = " - " PROTOCOL_FLAG;
+    char *commandPlusDash = malloc_or_die(strlen(command) + strlen(dashArgs) + 1, "command plus dash");
     strcpy(commandPlusDash, command);
-    // NB: We pass a single "-" argument to indicate to the jaunch
-    // configurator that it should harvest the actual input arguments
-    // from the stdin stream. We do this to avoid issues with quoting.
-    strcat(commandPlusDash, " -");
+    strcat(commandPlusDash, dashArgs);
+    long long trace_start = trace_now();
     if (!CreateProcess(NULL, (LPSTR)commandPlusDash, NULL, NULL, TRUE,
         createFlags, NULL, NULL, &si, &pi))
     {
@@ -433,6 +507,7 @@ void run_command(const char *command,
         DIE(ERROR_EXEC, "Failed to create process: %lu", GetLastError());
     }
     free(commandPlusDash);
+    trace_span("launcher", "CreateProcess", trace_start, NULL);
 
     // Close unnecessary handles.
     CloseHandle(stdinRead);
@@ -440,35 +515,40 @@ void run_command(const char *command,
     CloseHandle(stderrWrite);
 
     // Write to the child process's stdin.
+    trace_start = trace_now();
     LOG_DEBUG("WIN32", "Writing to subprocess stdin");
-    // Passing the input line count as the first line tells the child process what
+    // Passing the record count up front tells the child process what
     // to expect, so that it can stop reading from stdin once it has received
-    // those lines, even though the pipe is not yet closed. This avoids deadlocks.
-    char *numInputString = (char *)malloc_or_die(21, "input line count");
-    snprintf(numInputString, 21, "%zu", numInput);
-    write_line(stdinWrite, numInputString);
-    free(numInputString);
-    for (size_t i = 0; i < numInput; i++) {
-        write_line(stdinWrite, input[i]);
-    }
+    // those records, even though the pipe is not yet closed. This avoids deadlocks.
+    size_t inputLength;
+    char *inputBuffer = encode_records(numInput, input, &inputLength);
+    write_all(stdinWrite, inputBuffer, inputLength);
+    free(inputBuffer);
 
     // Close the stdin write handle to signal end of input.
     CloseHandle(stdinWrite);
     LOG_DEBUG("WIN32", "Closed subprocess stdin stream");
+    trace_span("launcher", "write input", trace_start, NULL);
 
     // Read from the child process's stderr in its own thread.
     HANDLE hThread = CreateThread(NULL, 0, ReadStderrThread, stderrRead, 0, NULL);
 
     // Read from the child process's stdout.
-    char buffer[1024];
+    trace_start = trace_now();
     DWORD bytesRead;
     size_t totalBytesRead = 0;
-    size_t bufferSize = 1024;
+    size_t bufferSize = 65536;
     char *outputBuffer = malloc_or_die(bufferSize, "output buffer");
 
-    while (ReadFile(stdoutRead, buffer, sizeof(buffer), &bytesRead, NULL) && bytesRead > 0) {
-        append_to_buffer(&outputBuffer, &bufferSize, &totalBytesRead, buffer, bytesRead);
+    // Read straight into the output buffer, which keeps room for a terminator.
+    while (1) {
+        reserve_buffer(&outputBuffer, &bufferSize, totalBytesRead, 1);
+        size_t room = bufferSize - totalBytesRead - 1;
+        DWORD chunk = room > 0x40000000 ? 0x40000000 : (DWORD)room;
+        if (!ReadFile(stdoutRead, outputBuffer + totalBytesRead, chunk, &bytesRead, NULL) || bytesRead == 0) break;
+        totalBytesRead += bytesRead;
     }
+    trace_span("launcher", "read output", trace_start, NULL);
 
     // Wait for stderr thread to terminate.
     if (hThread != NULL) {
@@ -487,14 +567,62 @@ void run_command(const char *command,
     CloseHandle(pi.hThread);
     LOG_DEBUG("WIN32", "All handles closed");
 
-    // Return the output buffer and the number of lines.
-    *output = NULL;
-    *numOutput = 0;
-    if (totalBytesRead > 0) {
-        outputBuffer[totalBytesRead] = '\0'; // Null-terminate before parsing.
-        split_lines(outputBuffer, "\r\n", output, numOutput);
+    // Return the output strings, parsed in place within the output buffer.
+    // NB: The configurator's final record, if any, ends the output; see parse_output.
+    *output = parse_output(outputBuffer, totalBytesRead, numOutput);
+}
+
+// NB: run_command reads the configurator's output to the end, so there is nothing to wait for.
+void run_command_wait() {}
+
+/*
+ * Appends the given argument to a command line, quoted as the C runtime's
+ * argument parsing expects: backslashes are literal, except before a quote.
+ */
+static void append_quoted(char **line, size_t *size, size_t *length, const char *arg) {
+    if (*length > 0) append_to_buffer(line, size, length, " ", 1);
+    append_to_buffer(line, size, length, "\"", 1);
+    size_t backslashes = 0;
+    for (const char *c = arg; *c != '\0'; c++) {
+        if (*c == '\\') { backslashes++; continue; }
+        // Double the backslashes before a quote, then escape the quote too.
+        for (size_t b = 0; b < (*c == '"' ? 2 * backslashes + 1 : backslashes); b++) {
+            append_to_buffer(line, size, length, "\\", 1);
+        }
+        backslashes = 0;
+        append_to_buffer(line, size, length, c, 1);
+    }
+    // Double the trailing backslashes, which precede the closing quote.
+    for (size_t b = 0; b < 2 * backslashes; b++) append_to_buffer(line, size, length, "\\", 1);
+    append_to_buffer(line, size, length, "\"", 1);
+}
+
+/*
+ * Runs the given command -- a full path, with the given NULL-terminated
+ * arguments, starting with the command itself -- as a separate process
+ * sharing the launcher's standard streams, and waits for it to finish.
+ * Returns its exit code.
+ */
+int run_process(const char *command, const char *argv[]) {
+    size_t size = 256, length = 0;
+    char *line = malloc_or_die(size, "command line");
+    for (size_t i = 0; argv[i] != NULL; i++) append_quoted(&line, &size, &length, argv[i]);
+    append_to_buffer(&line, &size, &length, "", 1);
+
+    STARTUPINFO si = { sizeof(STARTUPINFO) };
+    PROCESS_INFORMATION pi;
+    if (!CreateProcess(command, line, NULL, NULL, TRUE, 0, NULL, NULL, &si, &pi)) {
+        free(line);
+        FAIL(ERROR_EXEC, "Failed to run %s: %lu", command, GetLastError());
     }
-    free(outputBuffer);
+    free(line);
+    CloseHandle(pi.hThread);
+
+    DWORD exitCode = ERROR_WAITPID;
+    WaitForSingleObject(pi.hProcess, INFINITE);
+    if (!GetExitCodeProcess(pi.hProcess, &exitCode)) LOG_ERROR("Failed to get the exit code of %s", command);
+    CloseHandle(pi.hProcess);
+    return (int)exitCode;
 }
 
 void runloop_config(const char *directive) {}
@@ -0,0 +1,335 @@
+// Caches sparing the configurator from redoing expensive work on every launch.
+//
+// 1. The launch cache, of the launch directives emitted by the configurator.
+//
+// When the native launcher passes --jaunch-cache=<file>, the configurator
+// records into that file its emitted directives, plus everything they depend
+// on: input arguments, working directory, consulted environment variables,
+// and stamps of the config files, .cfg files, and runtime directories it
+// examined. On subsequent launches, the native launcher validates those
+// dependencies itself and, if nothing changed, executes the recorded
+// directives without spawning the configurator. See cache.h for details.
+//
+// 2. Installation indices, of metadata about discovered runtime installations,
+// so that e.g. probe JVMs need not be started unless an installation changed.
+//
+// 3. Configuration snapshots, of the merged TOML configuration; see snapshot.kt.
+
+import kotlinx.cinterop.ExperimentalForeignApi
+import platform.posix.time
+
+private const val CACHE_HEADER = "JAUNCH-CACHE-1"
+
+/** Configurator-side directives whose effects are fully captured by the cache. */
+val CACHE_SAFE_DIRECTIVES = setOf("apply-update")
+
+/**
+ * Whether the output of this run may be reused by later launches.
+ * Runs with side effects beyond the emitted directives -- printing
+ * information, issuing warnings, etc. -- must happen anew every time.
+ */
+var launchCacheable = true
+
+private var cacheFile: File? = null
+private var cacheCwd: String = ""
+private var cacheInputs: List<String> = emptyList()
+private val cacheEnv = linkedMapOf<String, String?>()
+private val cacheStamps = linkedMapOf<String, String>()
+private val cacheOutput = mutableListOf<String>()
+private var dependencyRecorder: MutableSet<String>? = null
+// NB: Dependencies may be recorded while probing installations concurrently.
+private val cacheLock = SpinLock()
+
+/** Begins recording the launch cache, if the native launcher asked for one. */
+fun initLaunchCache(args: List<String>, cachePath: String?) {
+    if (cachePath == null) return
+    cacheFile = File(cachePath)
+    cacheCwd = getcwd()
+    cacheInputs = args.filter { !it.startsWith("--jaunch-cache=") }
+}
+
+/** Records that the launch directives depend on the given files (present or not). */
+fun cacheDependsOn(vararg files: File) {
+    dependencyRecorder?.let { recorder -> cacheLock.withLock { files.forEach { recorder += it.path } } }
+    if (cacheFile == null) return
+    for (file in files) {
+        if (cacheLock.withLock { file.path in cacheStamps }) continue
+        val stamp = fileStamp(file)
+        cacheLock.withLock { cacheStamps.getOrPut(file.path) { stamp } }
+    }
+}
+
+/**
+ * Runs the given block, collecting the paths of all files it declares a dependency on
+ * via [cacheDependsOn], regardless of whether a launch cache is being recorded.
+ */
+fun <T> recordingDependencies(block: () -> T): Pair<T, Set<String>> {
+    val recorder = linkedSetOf<String>()
+    val previous = dependencyRecorder
+    dependencyRecorder = recorder
+    try {
+        return Pair(block(), recorder)
+    }
+    finally {
+        dependencyRecorder = previous
+        previous?.addAll(recorder)
+    }
+}
+
+/** Records that the launch directives depend on the given environment variable. */
+fun cacheDependsOnEnv(name: String, value: String?) {
+    if (cacheFile == null) return
+    cacheLock.withLock { if (name !in cacheEnv) cacheEnv[name] = value }
+}
+
+/** Records a line emitted to the native launcher. */
+fun cacheEmission(line: String) {
+    if (cacheFile != null) cacheOutput += line
+}
+
+/** Writes out the launch cache, if one was requested and this run qualifies. */
+fun saveLaunchCache() {
+    val file = cacheFile ?: return
+    // NB: A launch with logging enabled must run the configurator, to log.
+    cacheDependsOnEnv("DEBUG", getenv("DEBUG"))
+    cacheDependsOnEnv("JAUNCH_LOGFILE", getenv("JAUNCH_LOGFILE"))
+    if (!launchCacheable || dryRunMode || debugMode) {
+        if (file.exists) file.rm()
+        return
+    }
+
+    val lines = buildList {
+        add(CACHE_HEADER)
+        add(cacheCwd)
+        add(cacheInputs.size.toString())
+        addAll(cacheInputs)
+        add(cacheEnv.size.toString())
+        cacheEnv.forEach { (name, value) -> add(if (value == null) name else "$name=$value") }
+        add(cacheStamps.size.toString())
+        cacheStamps.forEach { (path, stamp) -> add(path); add(stamp) }
+        add(cacheOutput.size.toString())
+        addAll(cacheOutput)
+    }
+    // The native launcher reads the cache line by line, skipping empty lines.
+    if (lines.any { it.isEmpty() || '\n' in it || '\r' in it }) return
+
+    writeCacheFile(file, lines)
+}
+
+/** Formats the stamp of a file identically to `file_stamp` of posix.h and win32.h. */
+fun fileStamp(file: File): String {
+    if (!file.exists) return "-"
+    val size = if (file.isDirectory) 0 else file.length
+    return "${file.lastModifiedNanos}:$size:${file.inode}"
+}
+
+/**
+ * Computes a short key identifying the given values, e.g. for naming cache files.
+ * The key is the 64-bit FNV-1a hash of the values, as 16 hexadecimal digits.
+ */
+fun cacheKey(values: List<String>): String {
+    var hash = 0xcbf29ce484222325UL
+    for (value in values) {
+        for (b in value.encodeToByteArray()) {
+            hash = (hash xor b.toUByte().toULong()) * 0x100000001b3UL
+        }
+        // Separate values, so that e.g. ["ab", "c"] and ["a", "bc"] differ.
+        hash = hash * 0x100000001b3UL
+    }
+    return hash.toString(16).padStart(16, '0')
+}
+
+/**
+ * Prunes cache files of [dir] named for the application [appId] beyond the [keep] most
+ * recently used ones, plus those of any application not used for [maxAge] seconds.
+ * The [current] file is never pruned, nor are recent temporary files, which may be in the
+ * middle of being written. Keeping several files per application, rather than only the
+ * current one, spares the files of other launches of the same application with other
+ * arguments, which may be running or starting concurrently.
+ */
+fun pruneCacheFiles(dir: File, appId: String, current: File, keep: Int, maxAge: Long) {
+    if (!dir.isDirectory) return
+    val now = currentTimeSeconds()
+    val files = dir.ls().filter { it.isFile && it.path != current.path }
+    val aged = files.filter { now - lastUsed(it) > maxAge }
+    val agedPaths = aged.map { it.path }.toSet()
+    val surplus = files
+        .filter { it.name.startsWith("$appId-") && !it.name.endsWith(".tmp") && it.path !in agedPaths }
+        .sortedByDescending { lastUsed(it) }
+        .drop(maxOf(0, keep - 1))
+    for (file in aged + surplus) {
+        debug("Pruning stale cache file ", file)
+        file.rm()
+    }
+}
+
+/**
+ * When the given cache file was last used, in seconds since the epoch: its access
+ * time, which the launcher updates whenever it passes the file to a runtime
+ * (see prefetch.h), or else its modification time. Unlike the modification time,
+ * the access time is not part of the file's stamp (see [fileStamp]), so updating
+ * it does not invalidate launch caches that depend on the file.
+ */
+private fun lastUsed(file: File): Long = maxOf(file.lastModified, file.lastAccessed)
+
+/** Seconds since the epoch, comparable with [File.lastModified]. */
+@OptIn(ExperimentalForeignApi::class)
+fun currentTimeSeconds(): Long = time(null).toLong()
+
+/**
+ * Writes the given lines to a cache file, replacing it atomically.
+ * Failures are logged but otherwise ignored, since caches are merely an optimization.
+ */
+private fun writeCacheFile(file: File, lines: List<String>) {
+    writeCacheFile(file, lines.joinToString("\n", postfix = "\n").encodeToByteArray())
+}
+
+/** Writes the given bytes to a cache file, replacing it atomically, as above. */
+fun writeCacheFile(file: File, data: ByteArray) {
+    try {
+        val cacheDir = file.dir
+        if (!cacheDir.exists) cacheDir.dir.mkdir() && cacheDir.mkdir()
+        val tmpFile = File("${file.path}.tmp")
+        if (tmpFile.exists) tmpFile.rm()
+        tmpFile.writeBytes(data)
+        tmpFile.mv(file)
+    }
+    catch (exc: RuntimeException) {
+        debug("Failed to write cache file ", file, ": ", exc.message ?: exc)
+    }
+}
+
+// -- Installation index --
+
+private const val INDEX_HEADER = "JAUNCH-INDEX-1"
+
+/** The metadata sections recorded for one indexed installation. */
+typealias IndexSections = Map<String, Map<String, String>>
+
+private class IndexEntry(
+    val stamps: Map<String, String>,
+    val sections: MutableMap<String, Map<String, String>> = linkedMapOf(),
+)
+
+/**
+ * A persistent index of runtime installation metadata, kept in the per-user [CACHE_DIR].
+ *
+ * Each entry belongs to an installation root path, and holds named sections of key/value
+ * metadata (e.g. a release file, or system properties) which are expensive to discover.
+ * An entry stays valid only as long as the stamps of its key files (see [fileStamp]) are
+ * unchanged; as soon as one differs, the installation is examined again from scratch.
+ */
+class InstallationIndex(name: String) {
+    val file: File? = CACHE_DIR?.let { File(it) / "$name.txt" }
+    private val entries: MutableMap<String, IndexEntry> by lazy { load() }
+    private var dirty = false
+    // NB: Installations may be probed concurrently; see firstMatchConcurrently.
+    private val lock = SpinLock()
+
+    /**
+     * Gets the indexed sections for the given installation, if none of the key files
+     * recorded for it have changed. The given key files must be among those recorded.
+     */
+    fun lookup(rootPath: String, keyFiles: List<File>): IndexSections? {
+        val entry = lock.withLock { entries[rootPath] } ?: return null
+        if (keyFiles.any { it.path !in entry.stamps }) return null
+        return if (isCurrent(entry)) lock.withLock { entry.sections.toMap() } else null
+    }
+
+    /** Records a section of metadata for the given installation, keyed on the given files. */
+    fun store(rootPath: String, keyFiles: List<File>, section: String, values: Map<String, String>) {
+        if (file == null) return
+        if (values.any { (k, v) -> '\n' in k || '\r' in k || '=' in k || '\n' in v || '\r' in v }) return
+        val stamps = stamps(keyFiles)
+        lock.withLock {
+            val entry = entries[rootPath]?.takeIf { it.stamps == stamps } ?: IndexEntry(stamps)
+            entry.sections[section] = values
+            entries[rootPath] = entry
+            dirty = true
+        }
+    }
+
+    /** Writes out the index, if anything changed, forgetting installations that no longer exist. */
+    fun save() {
+        val indexFile = file ?: return
+        if (!dirty) return
+        val lines = mutableListOf(INDEX_HEADER)
+        for ((rootPath, entry) in entries) {
+            if (!File(rootPath).isDirectory) continue
+            lines += rootPath
+            lines += entry.stamps.size.toString()
+            entry.stamps.forEach { (path, stamp) -> lines += path; lines += stamp }
+            lines += entry.sections.size.toString()
+            for ((section, values) in entry.sections) {
+                lines += section
+                lines += values.size.toString()
+                values.forEach { (k, v) -> lines += "$k=$v" }
+            }
+        }
+        writeCacheFile(indexFile, lines)
+        dirty = false
+    }
+
+    /** Deletes the index, both in memory and on disk. */
+    fun clear() {
+        entries.clear()
+        dirty = false
+        file?.takeIf { it.exists }?.rm()
+    }
+
+    override fun toString(): String {
+        if (entries.isEmpty()) return "<empty>"
+        return entries.entries.joinToString(NL) { (rootPath, entry) ->
+            buildString {
+                append("$rootPath${if (isCurrent(entry)) "" else " (stale)"}")
+                entry.sections.forEach { (section, values) -> append("$NL* $section: ${values.size} entries") }
+            }
+        }
+    }
+
+    private fun isCurrent(entry: IndexEntry): Boolean {
+        return entry.stamps.all { (path, stamp) -> fileStamp(File(path)) == stamp }
+    }
+
+    private fun stamps(keyFiles: List<File>): Map<String, String> {
+        return keyFiles.associate { it.path to fileStamp(it) }
+    }
+
+    private fun load(): MutableMap<String, IndexEntry> {
+        val result = linkedMapOf<String, IndexEntry>()
+        val indexFile = file
+        if (indexFile == null || !indexFile.exists) return result
+        val lines = indexFile.lines().map { it.trimEnd('\r', '\n') }
+        if (lines.firstOrNull() != INDEX_HEADER) {
+            debug("Ignoring index file with unknown format: ", indexFile)
+            return result
+        }
+
+        // NB: Any malformed content invalidates the remainder of the file.
+        var i = 1
+        fun next(): String? = if (i < lines.size) lines[i++] else null
+        fun count(): Int? = next()?.toIntOrNull()?.takeIf { it >= 0 }
+        parse@ while (i < lines.size) {
+            val rootPath = next() ?: break
+            if (rootPath.isEmpty()) break
+            val stamps = linkedMapOf<String, String>()
+            repeat(count() ?: break@parse) {
+                val path = next() ?: return result
+                stamps[path] = next() ?: return result
+            }
+            val entry = IndexEntry(stamps)
+            repeat(count() ?: break@parse) {
+                val section = next() ?: return result
+                val values = linkedMapOf<String, String>()
+                repeat(count() ?: return result) {
+                    val (k, v) = (next() ?: return result) bisect '='
+                    values[k] = v ?: return result
+                }
+                entry.sections[section] = values
+            }
+            result[rootPath] = entry
+        }
+        debug("Read ", result.size, " entries from index file ", indexFile)
+        return result
+    }
+}
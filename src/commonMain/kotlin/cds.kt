@@ -0,0 +1,150 @@
+// Management of class data archives, which speed up the JVM's startup.
+//
+// Most of a JVM launch is spent loading and linking classes. Java can record
+// the classes an application loads into an archive, and map that archive
+// into memory on subsequent launches, rather than parsing and verifying the
+// same classes from the same JAR files every time. Such an archive is only
+// valid for one particular JVM and classpath, though, so when the
+// jvm.class-data-cache option is enabled, Jaunch keys each archive on the
+// Java installation, the finalized classpath -- including the stamps of its
+// JAR files -- and the module and agent options (see [classDataKeyArgs]),
+// and keeps the archives in the per-user [CACHE_DIR], pruning old ones.
+//
+// * Java 25+ records an ahead-of-time cache at the end of a first run
+//   (-XX:AOTCacheOutput), which later runs then use (-XX:AOTCache).
+// * Java 19+ creates or refreshes a dynamic CDS archive automatically
+//   (-XX:SharedArchiveFile with -XX:+AutoCreateSharedArchive).
+// * Older versions of Java are launched without an archive.
+
+/** Subdirectory of [CACHE_DIR] in which class data archives are kept. */
+private const val CDS_DIR = "cds"
+
+/** Archives older than this many seconds are pruned, to be created anew if still needed. */
+private const val CDS_MAX_AGE = 30L * 24 * 60 * 60
+
+/** How many archives to keep per application, e.g. for launches with differing options. */
+private const val CDS_KEEP = 4
+
+/** JVM arguments by which the user already controls class data sharing. */
+private val CDS_ARG_PREFIXES = listOf(
+    "-Xshare:",
+    "-XX:SharedArchiveFile=",
+    "-XX:ArchiveClassesAtExit=",
+    "-XX:+AutoCreateSharedArchive",
+    "-XX:AOTCache=",
+    "-XX:AOTCacheOutput=",
+    "-XX:AOTConfiguration=",
+    "-XX:AOTMode=",
+)
+
+/**
+ * JVM options on which the validity of a class data archive depends, besides
+ * the JVM and classpath: those shaping the module graph, and agents, which
+ * may transform classes. Other options, e.g. heap sizes or system properties,
+ * do not invalidate an archive, so they must not split the cache.
+ */
+private val CDS_KEY_OPTIONS = listOf(
+    "-p", "--module-path", "--upgrade-module-path",
+    "--add-modules", "--limit-modules", "--patch-module",
+)
+private val CDS_KEY_PREFIXES = listOf("-javaagent:", "-agentlib:", "-agentpath:", "--enable-preview")
+
+/** The directory of class data archives, or null if there is no cache directory. */
+val CDS_CACHE: File? = CACHE_DIR?.let { File(it) / CDS_DIR }
+
+/** Gets the file suffix of class data archives for the given major version of Java. */
+fun classDataSuffix(majorVersion: Int): String? {
+    return when {
+        majorVersion >= 25 -> "aot"
+        majorVersion >= 19 -> "jsa"
+        else -> null
+    }
+}
+
+/**
+ * Gets the JVM arguments which use -- or, if it does not exist yet, create --
+ * the given class data archive, for the given major version of Java.
+ */
+fun classDataArgs(majorVersion: Int, archive: File): List<String> {
+    return when {
+        majorVersion >= 25 ->
+            if (archive.exists) listOf("-XX:AOTCache=${archive.path}")
+            else listOf("-XX:AOTCacheOutput=${archive.path}")
+        majorVersion >= 19 ->
+            listOf("-XX:SharedArchiveFile=${archive.path}", "-XX:+AutoCreateSharedArchive")
+        else -> emptyList()
+    }
+}
+
+/** Gets those of the given JVM arguments which affect the validity of a class data archive. */
+fun classDataKeyArgs(args: List<String>): List<String> {
+    val keyArgs = mutableListOf<String>()
+    var i = 0
+    while (i < args.size) {
+        val arg = args[i++]
+        if (CDS_KEY_PREFIXES.any { arg.startsWith(it) }) keyArgs += arg
+        else if (CDS_KEY_OPTIONS.any { arg.startsWith("$it=") }) keyArgs += arg
+        else if (arg in CDS_KEY_OPTIONS) {
+            keyArgs += arg
+            if (i < args.size) keyArgs += args[i++]
+        }
+    }
+    return keyArgs
+}
+
+/**
+ * Adds arguments using a class data archive to the given JVM arguments, if possible.
+ *
+ * @param appId Identifies the launched application, independently of its classpath.
+ * Only the most recent archives of each application are kept.
+ */
+fun applyClassDataCache(java: JavaInstallation, appId: String, classpath: List<String>, args: MutableList<String>) {
+    val cacheDir = CDS_CACHE ?: return debug("No cache directory; skipping class data archive")
+    val majorVersion = java.majorVersion ?: return debug("Unknown Java version; skipping class data archive")
+    val suffix = classDataSuffix(majorVersion)
+        ?: return debug("Java $majorVersion does not support automatic class data archives")
+    if (args.any { arg -> CDS_ARG_PREFIXES.any { arg.startsWith(it) } }) {
+        return debug("Class data sharing is configured explicitly; skipping class data archive")
+    }
+    // NB: Java refuses to archive classes loaded from non-empty directories.
+    val classpathFiles = classpath.map(::File)
+    if (classpathFiles.any { it.isDirectory }) {
+        return debug("Classpath includes directories; skipping class data archive")
+    }
+
+    // Key the archive on everything which determines its validity.
+    cacheDependsOn(*classpathFiles.toTypedArray())
+    val key = cacheKey(buildList {
+        add(java.rootPath)
+        add(java.version ?: "")
+        add(java.libjvmPath ?: "")
+        addAll(classDataKeyArgs(args))
+        classpathFiles.forEach { add(it.path); add(fileStamp(it)) }
+    })
+    val archive = cacheDir / "$appId-$key.$suffix"
+    pruneCacheFiles(cacheDir, appId, archive, CDS_KEEP, CDS_MAX_AGE)
+
+    if (!cacheDir.exists && !(cacheDir.dir.mkdir() && cacheDir.mkdir())) {
+        return debug("Cannot create class data cache directory ", cacheDir)
+    }
+    // NB: Whether the archive exists can affect the arguments; see classDataArgs.
+    cacheDependsOn(archive)
+    val archiveArgs = classDataArgs(majorVersion, archive)
+    debugList("Class data archive arguments:", archiveArgs)
+    args += archiveArgs
+}
+
+/** Deletes all class data archives. */
+fun clearClassDataCache() {
+    val cacheDir = CDS_CACHE ?: return
+    if (!cacheDir.isDirectory) return
+    cacheDir.ls().filter { it.isFile }.forEach { it.rm() }
+}
+
+/** Describes the class data archives, for the print-class-data-cache directive. */
+fun classDataCacheInfo(): String {
+    val cacheDir = CDS_CACHE ?: return "<no cache directory>"
+    val archives = if (cacheDir.isDirectory) cacheDir.ls().filter { it.isFile } else emptyList()
+    if (archives.isEmpty()) return "$cacheDir:$NL<empty>"
+    return "$cacheDir:$NL" + archives.joinToString(NL) { "${it.name} (${it.length} bytes)" }
+}
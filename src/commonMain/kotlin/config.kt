@@ -77,6 +77,12 @@ data class JaunchConfig (
     /** Arguments to pass to the Python program itself. */
     val pythonMainArgs: Array<String> = emptyArray(),
 
+    /** Modules for a Python zygote to import once, ahead of the launches it serves. */
+    val pythonPreloadModules: Array<String> = emptyArray(),
+
+    /** If true, launches may be served by, or start, a Python zygote. */
+    val pythonZygote: Boolean? = null,
+
     // -- JVM-specific configuration fields --
 
     /** If true, search for suitable JVM installations. */
@@ -115,6 +121,18 @@ data class JaunchConfig (
     /** Maximum amount of memory for the Java heap to consume. */
     val jvmMaxHeap: String? = null,
 
+    /** Stack size of the thread running the Java main method. */
+    val jvmMainStackSize: String? = null,
+
+    /** How the launcher exits after the Java main method: normal or fast. */
+    val jvmExitMode: String? = null,
+
+    /** Whether to pass the classpath to Java via a pathing JAR, rather than verbatim. */
+    val jvmPathingJar: Boolean? = null,
+
+    /** Whether to keep and reuse class data archives, for faster JVM startup. */
+    val jvmClassDataCache: Boolean? = null,
+
     /** Arguments to pass to the JVM. */
     val jvmRuntimeArgs: Array<String> = emptyArray(),
 
@@ -168,6 +186,8 @@ data class JaunchConfig (
             pythonRuntimeArgs = config.pythonRuntimeArgs + pythonRuntimeArgs,
             pythonScriptPath = merge(config.pythonScriptPath, pythonScriptPath),
             pythonMainArgs = config.pythonMainArgs + pythonMainArgs,
+            pythonPreloadModules = merge(config.pythonPreloadModules, pythonPreloadModules),
+            pythonZygote = config.pythonZygote ?: pythonZygote,
 
             jvmEnabled = config.jvmEnabled ?: jvmEnabled,
             jvmRecognizedArgs = merge(config.jvmRecognizedArgs, jvmRecognizedArgs),
@@ -180,6 +200,10 @@ data class JaunchConfig (
             jvmLibSuffixes = merge(config.jvmLibSuffixes, jvmLibSuffixes),
             jvmClasspath = merge(config.jvmClasspath, jvmClasspath),
             jvmMaxHeap = config.jvmMaxHeap ?: jvmMaxHeap,
+            jvmMainStackSize = config.jvmMainStackSize ?: jvmMainStackSize,
+            jvmExitMode = config.jvmExitMode ?: jvmExitMode,
+            jvmPathingJar = config.jvmPathingJar ?: jvmPathingJar,
+            jvmClassDataCache = config.jvmClassDataCache ?: jvmClassDataCache,
             jvmRuntimeArgs = config.jvmRuntimeArgs + jvmRuntimeArgs,
             jvmMainClass = merge(config.jvmMainClass, jvmMainClass),
             jvmMainArgs = config.jvmMainArgs + jvmMainArgs,
@@ -202,6 +226,7 @@ fun readConfig(
 ): JaunchConfig {
     var theConfig = config ?: JaunchConfig()
     val theVisited = visited ?: mutableSetOf()
+    cacheDependsOn(tomlFile)
     if (!tomlFile.exists) warn("Included config file does not exist: $tomlFile")
     if (!tomlFile.exists || tomlFile.path in theVisited) return theConfig
 
@@ -228,6 +253,8 @@ fun readConfig(
     var pythonRuntimeArgs: List<String>? = null
     var pythonScriptPath: List<String>? = null
     var pythonMainArgs: List<String>? = null
+    var pythonPreloadModules: List<String>? = null
+    var pythonZygote: Boolean? = null
     var jvmEnabled: Boolean? = null
     var jvmRecognizedArgs: List<String>? = null
     var jvmAllowWeirdRuntimes: Boolean? = null
@@ -239,6 +266,10 @@ fun readConfig(
     var jvmLibSuffixes: List<String>? = null
     var jvmClasspath: List<String>? = null
     var jvmMaxHeap: String? = null
+    var jvmMainStackSize: String? = null
+    var jvmExitMode: String? = null
+    var jvmPathingJar: Boolean? = null
+    var jvmClassDataCache: Boolean? = null
     var jvmRuntimeArgs: List<String>? = null
     var jvmMainClass: List<String>? = null
     var jvmMainArgs: List<String>? = null
@@ -285,6 +316,8 @@ fun readConfig(
                     "python.runtime-args" -> pythonRuntimeArgs = asList(value)
                     "python.script-path" -> pythonScriptPath = asList(value)
                     "python.main-args" -> pythonMainArgs = asList(value)
+                    "python.preload-modules" -> pythonPreloadModules = asList(value)
+                    "python.zygote" -> pythonZygote = asBoolean(value)
                     "jvm.enabled" -> jvmEnabled = asBoolean(value)
                     "jvm.recognized-args" -> jvmRecognizedArgs = asList(value)
                     "jvm.allow-weird-runtimes" -> jvmAllowWeirdRuntimes = asBoolean(value)
@@ -296,6 +329,10 @@ fun readConfig(
                     "jvm.lib-suffixes" -> jvmLibSuffixes = asList(value)
                     "jvm.classpath" -> jvmClasspath = asList(value)
                     "jvm.max-heap" -> jvmMaxHeap = asString(value)
+                    "jvm.main-stack-size" -> jvmMainStackSize = asString(value)
+                    "jvm.exit-mode" -> jvmExitMode = asString(value)
+                    "jvm.pathing-jar" -> jvmPathingJar = asBoolean(value)
+                    "jvm.class-data-cache" -> jvmClassDataCache = asBoolean(value)
                     "jvm.runtime-args" -> jvmRuntimeArgs = asList(value)
                     "jvm.main-class" -> jvmMainClass = asList(value)
                     "jvm.main-args" -> jvmMainArgs = asList(value)
@@ -345,6 +382,8 @@ fun readConfig(
         pythonRuntimeArgs = asArray(pythonRuntimeArgs),
         pythonScriptPath = asArray(pythonScriptPath),
         pythonMainArgs = asArray(pythonMainArgs),
+        pythonPreloadModules = asArray(pythonPreloadModules),
+        pythonZygote = pythonZygote,
         jvmEnabled = jvmEnabled,
         jvmRecognizedArgs = asArray(jvmRecognizedArgs),
         jvmAllowWeirdRuntimes = jvmAllowWeirdRuntimes,
@@ -356,6 +395,10 @@ fun readConfig(
         jvmLibSuffixes = asArray(jvmLibSuffixes),
         jvmClasspath = asArray(jvmClasspath),
         jvmMaxHeap = jvmMaxHeap,
+        jvmMainStackSize = jvmMainStackSize,
+        jvmExitMode = jvmExitMode,
+        jvmPathingJar = jvmPathingJar,
+        jvmClassDataCache = jvmClassDataCache,
         jvmRuntimeArgs = asArray(jvmRuntimeArgs),
         jvmMainClass = asArray(jvmMainClass),
         jvmMainArgs = asArray(jvmMainArgs),
@@ -0,0 +1,179 @@
+// Expansion of glob patterns into matching file paths.
+//
+// Patterns such as `${app-dir}/jars/**/*.jar` in jvm.classpath, or
+// `~/.sdkman/candidates/java/*` in jvm.root-paths, are expanded on every
+// launch. So a pattern is compiled once into its path components, each of
+// which is matched against directory entries without regular expressions,
+// and directory entries are listed along with their types (see [listDir]),
+// so that no file needs to be examined individually just to learn whether
+// it is a directory.
+//
+// Pattern syntax, per path component:
+//
+// * `*` matches any sequence of characters, including none.
+// * `**` on its own matches any number of nested directories, including none.
+//   As the last component, `**` matches all files and directories beneath.
+// * Every other character matches itself; nothing needs escaping.
+//
+// Results are returned in depth-first order of the pattern's components,
+// with the entries of each directory sorted by name.
+
+/** An entry of a directory listing, as returned by [listDir]. */
+data class DirEntry(
+    val name: String,
+    /** Whether the entry is a directory, or null if the listing does not tell (e.g. symlinks). */
+    val isDirectory: Boolean?,
+)
+
+/**
+ * Lists the entries of the given directory, excluding `.` and `..`, in no particular order.
+ * @return The entries, or null if the path is not a directory or cannot be read.
+ */
+expect fun listDir(path: String): List<DirEntry>?
+
+/** A compiled pattern for one path component, in which `*` matches any run of characters. */
+class NamePattern(val pattern: String) {
+    private val parts = pattern.split('*')
+    private val head = parts.first()
+    private val tail = parts.last()
+    private val middle = parts.subList(1, parts.size - 1).filter { it.isNotEmpty() }
+    private val minLength = parts.sumOf { it.length }
+
+    val isLiteral: Boolean get() = parts.size == 1
+
+    fun matches(name: String): Boolean {
+        if (isLiteral) return name == pattern
+        if (name.length < minLength || !name.startsWith(head) || !name.endsWith(tail)) return false
+        // Match the middle parts leftmost-first, which suffices when only `*` is special.
+        var pos = head.length
+        val end = name.length - tail.length
+        for (part in middle) {
+            val at = name.indexOf(part, pos)
+            if (at < 0 || at + part.length > end) return false
+            pos = at + part.length
+        }
+        return true
+    }
+
+    override fun toString(): String = pattern
+}
+
+/** A glob pattern, compiled into the literal directory where it starts, plus path components. */
+class GlobPattern(pattern: String) {
+    private sealed interface Segment
+    /** One or more literal path components, checked with a single existence check. */
+    private class Literal(val path: String) : Segment
+    private class Wildcard(val pattern: NamePattern) : Segment
+    private object Recursive : Segment
+
+    /** The directory in which to begin matching, or null if the pattern has no wildcards. */
+    val base: String?
+    private val segments: List<Segment>
+
+    init {
+        val star = pattern.indexOf('*')
+        if (star < 0) {
+            base = null
+            segments = emptyList()
+        }
+        else {
+            // Start with the directory prefix before the first wildcard.
+            // If there is no prefix before the first glob, it must be a relative path.
+            // Or we're on Windows and they did `*:\...`, which I refuse to support. :-P
+            val slash = pattern.lastIndexOf(SLASH, star)
+            base = File(if (slash < 0) "." else pattern.substring(0, slash)).path
+            val names = (if (slash < 0) pattern else pattern.substring(slash + 1))
+                .split(SLASH).filter { it.isNotEmpty() }
+            segments = compile(names)
+        }
+    }
+
+    private fun compile(names: List<String>): List<Segment> {
+        val result = mutableListOf<Segment>()
+        val literal = mutableListOf<String>()
+        fun flushLiteral() {
+            if (literal.isEmpty()) return
+            result += Literal(literal.joinToString(SLASH))
+            literal.clear()
+        }
+        for (name in names) {
+            when {
+                name == "**" -> {
+                    flushLiteral()
+                    if (result.lastOrNull() != Recursive) result += Recursive
+                }
+                '*' in name -> {
+                    flushLiteral()
+                    result += Wildcard(NamePattern(name))
+                }
+                else -> literal += name
+            }
+        }
+        flushLiteral()
+        // A trailing ** matches everything beneath.
+        if (result.lastOrNull() == Recursive) result += Wildcard(NamePattern("*"))
+        return result
+    }
+
+    /** Finds the paths matching this pattern. */
+    fun expand(): List<String> {
+        val start = base ?: return emptyList()
+        val hits = mutableListOf<String>()
+        // NB: With **, the same directory may be listed for several segments.
+        val listings = mutableMapOf<String, List<DirEntry>?>()
+        expand(start, 0, hits, listings)
+        return hits
+    }
+
+    private fun expand(dir: String, index: Int, hits: MutableList<String>, listings: MutableMap<String, List<DirEntry>?>) {
+        if (index == segments.size) {
+            hits += dir
+            return
+        }
+        when (val segment = segments[index]) {
+            is Literal -> {
+                val file = File("$dir$SLASH${segment.path}")
+                cacheDependsOn(file)
+                if (file.exists) expand(file.path, index + 1, hits, listings)
+            }
+            is Wildcard -> {
+                val entries = list(dir, listings) ?: return
+                val last = index == segments.size - 1
+                for (entry in entries) {
+                    if (!segment.pattern.matches(entry.name)) continue
+                    val path = "$dir$SLASH${entry.name}"
+                    // Descend into anything that may be a directory; listing a file just fails.
+                    if (last) hits += path
+                    else if (entry.isDirectory != false) expand(path, index + 1, hits, listings)
+                }
+            }
+            is Recursive -> {
+                expand(dir, index + 1, hits, listings)
+                val entries = list(dir, listings) ?: return
+                // NB: Symlinked directories are not followed, lest they form cycles.
+                for (entry in entries) {
+                    if (entry.isDirectory == true) expand("$dir$SLASH${entry.name}", index, hits, listings)
+                }
+            }
+        }
+    }
+
+    private fun list(dir: String, listings: MutableMap<String, List<DirEntry>?>): List<DirEntry>? {
+        return listings.getOrPut(dir) {
+            cacheDependsOn(File(dir))
+            listDir(dir)?.sortedBy { it.name }
+        }
+    }
+}
+
+/** Expands the given path, which may contain `~` and glob wildcards, into the matching paths. */
+fun glob(path: String): List<String> {
+    // Expand tilde home character.
+    val expanded = path.replace("~", USER_HOME ?: fail("USER_HOME variable is unset?!"))
+    // Standardize slashes.
+    val p = expanded.replace("/", SLASH).replace("\\", SLASH)
+
+    val pattern = GlobPattern(p)
+    if (pattern.base == null) return listOf(p) // No glob -- just return what we have.
+    return pattern.expand()
+}
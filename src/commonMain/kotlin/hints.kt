@@ -0,0 +1,141 @@
+// Hints, and the rules of config lines which depend on them.
+//
+// Config lines may be prefixed by rules, e.g. `--foo|OS:LINUX|!JAVA:8|value`,
+// meaning the line applies only when all rules are satisfied: every hint
+// named by a rule must be active, except for negated rules, whose hints must
+// not be. Hints are activated by the target platform, by supported options
+// given on the command line, by modes, and by the selected runtimes.
+//
+// Rules are compiled once per config array (see [HintRules]), with each hint
+// name interned to a small integer, so that evaluating a line only tests bits
+// of the active hints. Version hints of runtimes -- `JAVA:11+`, `PYTHON:3.9+` --
+// are evaluated as ranges against the runtime's version (see [Hints.setVersion]),
+// rather than by activating one hint per satisfied version.
+
+/** Interned hint names, shared by all [Hints] and [HintRules]. */
+private object HintNames {
+    private val ids = HashMap<String, Int>()
+    private val names = ArrayList<String>()
+    private val lock = SpinLock()
+
+    fun id(name: String): Int = lock.withLock { ids.getOrPut(name) { names.add(name); names.size - 1 } }
+    fun name(id: Int): String = lock.withLock { names[id] }
+}
+
+/**
+ * A range hint such as `JAVA:11+` or `PYTHON:3.9+`, satisfied by versions of the named runtime
+ * which share all but the last component, and are at least as large in the last component.
+ */
+class VersionRange(val runtime: String, val version: IntArray) {
+    fun includes(v: IntArray): Boolean {
+        if (v.size < version.size) return false
+        for (i in 0 until version.size - 1) if (v[i] != version[i]) return false
+        return v[version.size - 1] >= version.last()
+    }
+
+    override fun toString(): String = "$runtime:${version.joinToString(".")}+"
+
+    companion object {
+        /** Parses a range hint, or returns null if the given hint is not one. */
+        fun parse(hint: String): VersionRange? {
+            if (!hint.endsWith('+')) return null
+            val colon = hint.indexOf(':')
+            if (colon <= 0) return null
+            val version = hint.substring(colon + 1, hint.length - 1).split('.').map { it.toIntOrNull() }
+            if (version.any { it == null || it < 0 }) return null
+            return VersionRange(hint.substring(0, colon), version.map { it!! }.toIntArray())
+        }
+    }
+}
+
+/** The set of active hints, as a bitset over interned hint names, plus runtime versions. */
+class Hints(vararg initial: String) {
+    private var bits = LongArray(2)
+    // NB: Insertion order is kept for the sake of debugging output.
+    private val order = mutableListOf<Int>()
+    private val versions = linkedMapOf<String, IntArray>()
+
+    init {
+        initial.forEach { this += it }
+    }
+
+    operator fun contains(hint: String): Boolean {
+        return has(HintNames.id(hint)) || VersionRange.parse(hint)?.let(::satisfies) == true
+    }
+
+    operator fun plusAssign(hint: String) {
+        val id = HintNames.id(hint)
+        if (has(id)) return
+        if (id >= 64 * bits.size) bits = bits.copyOf(maxOf(2 * bits.size, id / 64 + 1))
+        bits[id / 64] = bits[id / 64] or (1L shl (id % 64))
+        order += id
+    }
+
+    operator fun minusAssign(hint: String) {
+        val id = HintNames.id(hint)
+        if (!has(id)) return
+        bits[id / 64] = bits[id / 64] and (1L shl (id % 64)).inv()
+        order -= id
+    }
+
+    /**
+     * Activates the hints of the given runtime version: the exact version hint,
+     * e.g. `JAVA:21` or `PYTHON:3.12`, plus all satisfied range hints, e.g. `JAVA:11+`.
+     */
+    fun setVersion(runtime: String, vararg version: Int) {
+        this += "$runtime:${version.joinToString(".")}"
+        versions[runtime] = version
+    }
+
+    fun has(id: Int): Boolean = id < 64 * bits.size && (bits[id / 64] and (1L shl (id % 64))) != 0L
+
+    fun satisfies(range: VersionRange): Boolean = versions[range.runtime]?.let(range::includes) == true
+
+    override fun toString(): String = order.joinToString(", ", "[", "]") { HintNames.name(it) }
+}
+
+/**
+ * Config lines, each with its rules compiled into a decision table.
+ * The rules of line `i` are the entries from `offsets[i]` until `offsets[i + 1]`.
+ */
+class HintRules(lines: Array<String>) {
+    private val values: Array<String>
+    private val offsets = IntArray(lines.size + 1)
+    private val hintIds: IntArray
+    private val negated: BooleanArray
+    private val ranges: Array<VersionRange?>
+
+    init {
+        val ids = mutableListOf<Int>()
+        val negations = mutableListOf<Boolean>()
+        val rangeList = mutableListOf<VersionRange?>()
+        values = Array(lines.size) { i ->
+            val tokens = lines[i].split('|')
+            for (rule in tokens.subList(0, tokens.lastIndex)) {
+                val negation = rule.startsWith('!')
+                val hint = if (negation) rule.substring(1) else rule
+                ids += HintNames.id(hint)
+                negations += negation
+                rangeList += VersionRange.parse(hint)
+            }
+            offsets[i + 1] = ids.size
+            tokens.last()
+        }
+        hintIds = ids.toIntArray()
+        negated = negations.toBooleanArray()
+        ranges = rangeList.toTypedArray()
+    }
+
+    /** Gets the values of the lines whose rules are all satisfied by the given hints, in order. */
+    fun evaluate(hints: Hints): List<String> {
+        val result = ArrayList<String>(values.size)
+        line@ for (i in values.indices) {
+            for (r in offsets[i] until offsets[i + 1]) {
+                val active = hints.has(hintIds[r]) || ranges[r]?.let(hints::satisfies) == true
+                if (active == negated[r]) continue@line
+            }
+            result += values[i]
+        }
+        return result
+    }
+}
@@ -1,6 +1,13 @@
 // Logic for discovery and inspection of Java Virtual Machine (JVM) installations.
 
-import kotlin.math.min
+/** Persistent index of Java installation metadata, keyed on `release` file and libjvm. */
+val JVM_INDEX = InstallationIndex("jvm-index")
+
+/** JVM argument through which the launcher learns the stack size of the main thread. */
+private const val MAIN_STACK_SIZE_ARG = "-Djaunch.main-stack-size="
+
+/** JVM argument through which the launcher learns how to exit after the main method. */
+private const val EXIT_MODE_ARG = "-Djaunch.exit-mode="
 
 data class JvmConstraints(
     val configDir: File,
@@ -22,29 +29,43 @@ class JvmRuntimeConfig(recognizedArgs: Array<String>) :
     private var java: JavaInstallation? = null
     private var defaultClasspath: List<String> = emptyList()
     private var defaultMaxHeap: String? = null
+    private var mainStackSize: String? = null
+    private var exitMode: String? = null
+    private var appId = ""
+    private var usePathingJar = false
+    private var useClassDataCache = false
+    private var pathingJar: String? = null
+    private var pathingClasspath: List<String> = emptyList()
     private var skipRunLoop = false
 
     override val supportedDirectives: DirectivesMap = mutableMapOf(
         "print-class-path" to { args -> printlnErr(classpath(args) ?: "<none>") },
         "print-java-home" to { _ -> printlnErr(javaHome()) },
         "print-java-info" to { _ -> printlnErr(javaInfo()) },
+        "print-jvm-cache" to { _ -> printlnErr(jvmCache()) },
+        "clear-jvm-cache" to { _ -> JVM_INDEX.clear() },
+        "print-class-data-cache" to { _ -> printlnErr(classDataCacheInfo()) },
+        "clear-class-data-cache" to { _ -> clearClassDataCache() },
     )
 
     override fun configure(
         configDir: File,
         config: JaunchConfig,
-        hints: MutableSet<String>,
+        hints: Hints,
         vars: Vars
     ) {
         // Calculate all the places to search for Java.
         val appDir = vars["app-dir"] as String
         val jvmRootPaths = vars.calculate(config.jvmRootPaths, hints)
                 .flatMap { glob(it) }
+                .also { prefetchStats(it) }
                 .map {
                     // Relativize beneath app-dir as appropriate.
                     if (File(it).isDirectory) it
                     else (File(appDir) / it).path
                 }
+                .also { prefetchStats(it) }
+                .onEach { cacheDependsOn(File(it)) }
                 .filter { File(it).isDirectory }
                 .toSet()
 
@@ -72,23 +93,23 @@ class JvmRuntimeConfig(recognizedArgs: Array<String>) :
             config.targetOS, config.targetArch,
         )
 
-        // Discover Java.
+        // Discover Java. Candidates are probed concurrently,
+        // but the first conforming one in priority order wins.
         debug()
         debug("Discovering Java installations...")
-        var java: JavaInstallation? = null
-        for (jvmPath in jvmRootPaths) {
-            debug("Analyzing candidate JVM directory: '", jvmPath, "'")
-            val javaCandidate = JavaInstallation(jvmPath, constraints)
-            if (javaCandidate.conforms) {
-                // Installation looks good! Moving on.
-                java = javaCandidate
-                break
-            }
+        val javaCandidates = jvmRootPaths.map { JavaInstallation(it, constraints) }
+        val javaIndex = firstMatchConcurrently(javaCandidates) { javaCandidate ->
+            debug("Analyzing candidate JVM directory: '", javaCandidate.rootPath, "'")
+            cacheDependsOn(File(javaCandidate.rootPath) / "release")
+            traced("probe JVM", javaCandidate.rootPath) { javaCandidate.conforms }
         }
+        JVM_INDEX.save()
+        val java = javaCandidates.getOrNull(javaIndex)
         if (java == null) {
             debug("No Java installation found.")
             return
         }
+        java.libjvmPath?.let { cacheDependsOn(File(it)) }
         debug("Successfully discovered Java installation:")
         debug("* rootPath -> ", java.rootPath)
         debug("* libjvmPath -> ", java.libjvmPath ?: "<null>")
@@ -96,12 +117,7 @@ class JvmRuntimeConfig(recognizedArgs: Array<String>) :
 
         // Apply JAVA: hints.
         val mv = java.majorVersion
-        if (mv != null) {
-            hints += "JAVA:$mv"
-            // If Java version is OVER 9000, something went wrong in the parsing.
-            // Let's not explode the hints set with too many bogus values.
-            for (v in 0..min(mv, 9000)) hints += "JAVA:$v+"
-        }
+        if (mv != null) hints.setVersion("JAVA", mv)
         debug("* hints -> ", hints)
 
         // Calculate classpath.
@@ -112,6 +128,24 @@ class JvmRuntimeConfig(recognizedArgs: Array<String>) :
         defaultMaxHeap = vars.calculate(config.jvmMaxHeap, hints)
         debug("Default max heap: $defaultMaxHeap")
 
+        // Save the main thread stack size.
+        mainStackSize = vars.calculate(config.jvmMainStackSize, hints)
+        debug("Main stack size: $mainStackSize")
+
+        // Save the exit mode.
+        exitMode = vars.calculate(config.jvmExitMode, hints)
+        if (exitMode != null && exitMode != "normal" && exitMode != "fast") {
+            warn("Ignoring invalid jvm.exit-mode '$exitMode'")
+            exitMode = null
+        }
+        debug("Exit mode: ${exitMode ?: "normal"}")
+
+        // Identify the application, for its pathing JAR and class data archive.
+        usePathingJar = config.jvmPathingJar ?: false
+        useClassDataCache = config.jvmClassDataCache ?: false
+        appId = cacheKey(listOf(vars["executable"]?.toString() ?: appDir, configDir.path))
+        debug("Application ID: $appId")
+
         // Calculate JVM arguments.
         runtimeArgs += vars.calculate(config.jvmRuntimeArgs, hints)
         debugList("JVM arguments calculated:", runtimeArgs)
@@ -197,6 +231,20 @@ class JvmRuntimeConfig(recognizedArgs: Array<String>) :
             debug("Added maxHeap arg: ${args.last()}")
         }
 
+        // Tell the launcher how big a stack to run the main method with.
+        // NB: The launcher consumes this argument, rather than passing it to the JVM;
+        // and an explicit -Xss argument takes precedence, as with the java command.
+        if (mainStackSize != null && args.none { it.startsWith(MAIN_STACK_SIZE_ARG) }) {
+            args += "$MAIN_STACK_SIZE_ARG$mainStackSize"
+            debug("Added main stack size arg: ${args.last()}")
+        }
+
+        // Tell the launcher to exit straight after the main method, if so configured.
+        if (exitMode == "fast" && args.none { it.startsWith(EXIT_MODE_ARG) }) {
+            args += "${EXIT_MODE_ARG}fast"
+            debug("Added exit mode arg: ${args.last()}")
+        }
+
         // Squash multiple memory arguments.
         val argCountBefore = args.size
         squashExtraArgs(args, "-Xms")
@@ -215,6 +263,35 @@ class JvmRuntimeConfig(recognizedArgs: Array<String>) :
                 args[i] = expanded
             }
         }
+
+        // Resolve the complete classpath, including any elements passed explicitly.
+        val cpPrefix = "-Djava.class.path="
+        val cpIndex = args.indexOfFirst { it.startsWith(cpPrefix) }
+        val fullClasspath =
+            if (cpIndex < 0) emptyList()
+            else args[cpIndex].substring(cpPrefix.length).split(COLON).filter { it.isNotEmpty() }
+
+        // Replace the classpath with a pathing JAR, if enabled.
+        if (usePathingJar && fullClasspath.isNotEmpty()) {
+            debug()
+            debug("Finalizing pathing JAR...")
+            val jar = pathingJar(appId, fullClasspath)
+            if (jar != null) {
+                args[cpIndex] = "$cpPrefix${jar.path}"
+                pathingJar = jar.path
+                pathingClasspath = fullClasspath
+                debug("Classpath of ${fullClasspath.size} elements replaced by: ${args[cpIndex]}")
+            }
+            else debug("No pathing JAR available; keeping the classpath as is")
+        }
+
+        // Use a class data archive, if enabled.
+        val java = java
+        if (java != null && useClassDataCache) {
+            debug()
+            debug("Finalizing class data archive...")
+            applyClassDataCache(java, appId, fullClasspath, args)
+        }
     }
 
     override fun launch(args: ProgramArgs, directiveArg: String?): Pair<String, List<String>> {
@@ -257,7 +334,10 @@ class JvmRuntimeConfig(recognizedArgs: Array<String>) :
     fun classpath(args: ProgramArgs, divider: String = NL): String? {
         val prefix = "-Djava.class.path="
         val classpathArg = args.runtime.firstOrNull { it.startsWith(prefix) } ?: return null
-        return classpathArg.substring(prefix.length).replace(COLON, divider)
+        val classpath = classpathArg.substring(prefix.length)
+        // NB: List the elements behind a pathing JAR, rather than the JAR itself.
+        if (classpath == pathingJar) return pathingClasspath.joinToString(divider)
+        return classpath.replace(COLON, divider)
     }
 
     fun javaHome(): String {
@@ -265,7 +345,14 @@ class JvmRuntimeConfig(recognizedArgs: Array<String>) :
     }
 
     fun javaInfo(): String {
-        return java?.toString() ?: fail("No matching Java installations found.")
+        val info = java?.toString() ?: fail("No matching Java installations found.")
+        // NB: Listing all properties may have required probing the installation further.
+        JVM_INDEX.save()
+        return info
+    }
+
+    fun jvmCache(): String {
+        return "${JVM_INDEX.file ?: "<no cache directory>"}:$NL$JVM_INDEX"
     }
 }
 
@@ -298,7 +385,9 @@ class JvmRuntimeConfig(recognizedArgs: Array<String>) :
  * configuration tool to launch Java as needed to extract Java system properties.
  *
  * The logic is coded so that less expensive techniques are tried first, and metadata
- * is cached, so that more expensive techniques only trigger when necessary.
+ * is cached, so that more expensive techniques only trigger when necessary. The release
+ * info and properties are furthermore recorded in the persistent [JVM_INDEX], so that
+ * subsequent runs need not examine the installation again until it actually changes.
  */
 class JavaInstallation(
     rootPath: String,
@@ -310,8 +399,8 @@ class JavaInstallation(
     val distro: String? by lazy { guessDistribution() }
     val osName: String? by lazy { guessOperatingSystemName() }
     val cpuArch: String? by lazy { guessCpuArchitecture() }
-    val releaseInfo: Map<String, String>? by lazy { readReleaseInfo() }
-    val props: Map<String, String>? by lazy { askJavaForProperties() }
+    val releaseInfo: Map<String, String>? by lazy { indexed("release") { readReleaseInfo() } }
+    val props: Map<String, String>? by lazy { indexed("props") { askJavaForProperties() } }
 
     /**
      * Gets the major version digit (i.e. "Java product version") of the Java installation.
@@ -389,7 +478,9 @@ class JavaInstallation(
     }
 
     private fun findLibjvm(): String? {
-        return constraints.libSuffixes.map { File("$rootPath$SLASH$it") }.firstOrNull { it.exists }?.path
+        val candidates = constraints.libSuffixes.map { File("$rootPath$SLASH$it") }
+        prefetchStats(candidates.map { it.path })
+        return candidates.firstOrNull { it.exists }?.path
     }
 
     private fun findBinJava(targetOS: String): String? {
@@ -432,6 +523,18 @@ class JavaInstallation(
         }
     }
 
+    /** Gets a section of metadata from the [JVM_INDEX], or computes and records it. */
+    private fun indexed(section: String, compute: () -> Map<String, String>?): Map<String, String>? {
+        val keyFiles = listOfNotNull(File("$rootPath${SLASH}release"), libjvmPath?.let(::File))
+        JVM_INDEX.lookup(rootPath, keyFiles)?.get(section)?.let {
+            debug("Using indexed $section metadata")
+            return it
+        }
+        val values = compute() ?: return null
+        JVM_INDEX.store(rootPath, keyFiles, section, values)
+        return values
+    }
+
     /** Reads metadata from the `release` file. */
     private fun readReleaseInfo(): Map<String, String>? {
         debug("Reading release file...")
@@ -447,24 +550,21 @@ class JavaInstallation(
             debug("Java executable does not exist.")
             return null
         }
-
-        // NB: Temporarily change the current working directory to the one containing
-        // the Props.class helper program. This lets us invoke the java executable
-        // in a simpler way, without needing to pass something like `-cp $configDir`,
-        // which creates more quoting complexity, especially on Windows.
-        val cwd = getcwd()
-        setcwd(constraints.configDir.path)
-
+        // NB: No need to launch a process, if a better installation has already won.
+        if (probeAbandoned()) return null
+
+        // NB: Run the java executable from the directory containing the Props.class
+        // helper program. This lets us invoke it in a simpler way, without needing to pass
+        // something like `-cp $configDir`, which creates more quoting complexity, especially
+        // on Windows. We do not change our own working directory to do so, because other
+        // installations may be probed concurrently (see [firstMatchConcurrently]).
         debug("Invoking `\"", javaExe, "\" Props`...")
-        val propsExists = File("Props.class").exists
+        val propsExists = (constraints.configDir / "Props.class").exists
         if (!propsExists) warn("Props.class not found at: ", constraints.configDir.path)
         val stdout: List<String>? =
-            if (propsExists) execute("\"$javaExe\" Props")
+            if (propsExists) execute("\"$javaExe\" Props", constraints.configDir.path)
             else null
 
-        // NB: Restore original working directory.
-        setcwd(cwd)
-
         return if (stdout == null) null else linesToMap(stdout, "=")
     }
 
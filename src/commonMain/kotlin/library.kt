@@ -0,0 +1,63 @@
+// Entry point of the configurator when built as a shared library.
+//
+// When passed --jaunch-library, the native launcher loads the library and
+// calls jaunch_configure in-process, sparing the spawning of a separate
+// configurator process. The library then stays loaded for the life of the
+// process, since Kotlin Native cannot be unloaded. See configurator.h.
+
+import kotlin.experimental.ExperimentalNativeApi
+import kotlinx.cinterop.*
+import platform.posix.malloc
+import platform.posix.size_t
+import platform.posix.size_tVar
+
+/**
+ * Runs the configurator on the given arguments -- the same ones the configurator
+ * executable receives on stdin -- collecting the lines it would emit on stdout.
+ *
+ * The lines are stored into [outArgv] as one `malloc`ed block, holding the array
+ * of string pointers followed by the strings themselves, so that the caller can
+ * release it all with a single call to `free`; see parse_output in common.h.
+ *
+ * @return 0 on success, or nonzero if the configurator failed unexpectedly.
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("jaunch_configure")
+fun jaunchConfigure(
+    argc: size_t,
+    argv: CPointer<CPointerVar<ByteVar>>?,
+    outArgc: CPointer<size_tVar>?,
+    outArgv: CPointer<CPointerVar<CPointerVar<ByteVar>>>?,
+): Int {
+    if (argv == null || outArgc == null || outArgv == null) return 1
+    captureOutput()
+    try {
+        configure(List(argc.toInt()) { argv[it]?.toKString() ?: "" })
+    }
+    catch (exc: ConfigurationEnded) {
+        // The configurator ended early, having emitted its directives (e.g. ERROR).
+    }
+    catch (t: Throwable) {
+        printlnErr("[ERROR] In-process configuration failed: ${t.message ?: t}")
+        return 2
+    }
+
+    val lines = capturedOutput().map { it.encodeToByteArray() }
+    outArgc.pointed.value = lines.size.convert()
+    outArgv.pointed.value = null
+    if (lines.isEmpty()) return 0
+
+    val arraySize = lines.size * sizeOf<CPointerVar<ByteVar>>()
+    val arena = malloc((arraySize + lines.sumOf { it.size + 1L }).convert())?.reinterpret<ByteVar>() ?: return 3
+    val strings = arena.reinterpret<CPointerVar<ByteVar>>()
+    var offset = arraySize
+    lines.forEachIndexed { i, bytes ->
+        val s = (arena + offset)!!
+        bytes.forEachIndexed { j, b -> s[j] = b }
+        s[bytes.size] = 0
+        strings[i] = s
+        offset += bytes.size + 1
+    }
+    outArgv.pointed.value = strings
+    return 0
+}
@@ -1,5 +1,6 @@
 // Functions for emitting log messages.
 
+import kotlin.native.concurrent.ThreadLocal
 import platform.posix.exit
 
 private const val EXIT_CODE_ON_FAIL = 20
@@ -8,6 +9,19 @@ var debugMode = getenv("DEBUG") !in listOf(null, "", "0", "false", "FALSE")
 var logFilePath = getenv("JAUNCH_LOGFILE")
 private val logLines = mutableListOf<String>()
 private var logFile: File? = null
+// NB: Messages may be reported from several threads. Each line is queued under
+// the lock, then written out by whichever thread is not already writing, so that
+// the lock is never held across file I/O.
+private val logLock = SpinLock()
+private val logQueue = ArrayDeque<String>()
+private var logWriting = false
+
+/** Reports held back by the current thread rather than written out; see [holdingReports]. */
+@ThreadLocal
+private var heldReports: MutableList<HeldReport>? = null
+
+/** A report held back by [holdingReports], to be written out later via [replayReports]. */
+class HeldReport(val prefix: String, val line: String)
 
 /**
  * If true, directives should *not actually do anything* and instead print
@@ -34,9 +48,34 @@ fun debugBanner(message: String) {
 
 fun dryRun(vararg args: Any) { if (dryRunMode) report("DRY-RUN", *args) }
 
-fun warn(vararg args: Any) { report("WARNING", *args) }
+/** How many warnings have been issued so far. */
+var warningCount = 0
+    private set
+
+fun warn(vararg args: Any) = report("WARNING", *args)
+
+/**
+ * Runs the given block, holding back whatever it reports into the given list
+ * instead of writing it out. Held warnings do not count as issued (see
+ * [warningCount]) unless and until they are passed to [replayReports].
+ */
+fun <T> holdingReports(held: MutableList<HeldReport>, block: () -> T): T {
+    val outer = heldReports
+    heldReports = held
+    try {
+        return block()
+    }
+    finally {
+        heldReports = outer
+    }
+}
+
+/** Writes out reports held back by [holdingReports], as though reported just now. */
+fun replayReports(held: List<HeldReport>) = held.forEach { deliver(it.prefix, it.line) }
 
 fun fail(message: String): Nothing {
+    // Reports held back by this thread would otherwise be lost on exit.
+    heldReports?.let { held -> heldReports = null; replayReports(held) }
     val lines = message.split(NL)
     if (debugMode) {
         // In debug mode, print the error lines on stderr also,
@@ -53,15 +92,32 @@ fun fail(message: String): Nothing {
     lines.forEach { doOutput(it) }
     if (dryRunMode) {
         emit("ABORT")
-        exit(0)
+        terminate(0)
     }
-    exit(EXIT_CODE_ON_FAIL)
+    terminate(EXIT_CODE_ON_FAIL)
+}
+
+/** Thrown to end an in-process configuration early, in place of exiting the process. */
+class ConfigurationEnded(val exitCode: Int) : Exception("Configuration ended with exit code $exitCode")
+
+/**
+ * Ends the configuration after writing out any pending output: by exiting the
+ * process, or when running in-process, by returning to the native launcher.
+ */
+fun terminate(exitCode: Int): Nothing {
+    flushOutput()
+    if (outputMode == OutputMode.LIBRARY) throw ConfigurationEnded(exitCode)
+    exit(exitCode)
     // Unreachable code, but satisfies the Kotlin compiler.
-    throw IllegalStateException(message)
+    throw IllegalStateException("Exit failed")
 }
 
 fun emit(vararg lines: Any) {
-    lines.forEach { println(it) }
+    lines.forEach {
+        val line = it.toString()
+        if (outputMode == OutputMode.TEXT) println(line) else emitRecord(line)
+        cacheEmission(line)
+    }
 }
 
 private fun report(prefix: String, vararg args: Any) {
@@ -69,6 +125,30 @@ private fun report(prefix: String, vararg args: Any) {
         append("[$prefix] ")
         args.forEach { append(it) }
     }
+    deliver(prefix, s)
+}
+
+private fun deliver(prefix: String, s: String) {
+    heldReports?.let { it += HeldReport(prefix, s); return }
+    if (prefix == "WARNING") {
+        // Warnings should be seen on every launch, not just the first one.
+        launchCacheable = false
+        warningCount++
+    }
+    val writer = logLock.withLock {
+        logQueue.addLast(s)
+        !logWriting.also { logWriting = true }
+    }
+    if (!writer) return
+    while (true) {
+        val line = logLock.withLock {
+            logQueue.removeFirstOrNull().also { if (it == null) logWriting = false }
+        } ?: return
+        reportLine(line)
+    }
+}
+
+private fun reportLine(s: String) {
     printlnErr(s)
 
     // Also log the line to the appropriate log file.
@@ -53,11 +53,38 @@ fun main(args: Array<String>) {
         exit(1)
     }
 
-    val (exeFile, internalFlags, inputArgs) = parseArguments(args)
+    // If a `-` argument was given on the CLI, read the arguments from stdin:
+    // as binary records if the native launcher asked for them, or else as text lines.
+    val theArgs = when {
+        args.size == 2 && args[0] == "-" && args[1] == PROTOCOL_FLAG -> stdinRecords()
+        args.size == 1 && args[0] == "-" -> stdinLines()
+        else -> args.toList()
+    }
+    configure(theArgs)
+    flushOutput()
+}
+
+/**
+ * Configures the launch for the given arguments: the path to the calling executable,
+ * followed by the input arguments. Emits the resulting directives via [emit].
+ */
+fun configure(args: List<String>) {
+    val traceStart = traceNow()
+    StatCache.clear()
+
+    val (exeFile, internalFlags, inputArgs) = traced("parse arguments") { parseArguments(args) }
     val (appDir, configuratorDir) = discernDirectories(exeFile, internalFlags)
-    val configFile = findConfigFile(appDir, configuratorDir, exeFile)
+    val configFile = traced("find config") { findConfigFile(appDir, configuratorDir, exeFile) }
     if (debugMode && logFilePath == null) logFilePath = (appDir / "${configFile.base.name}.log").path
-    val config = readConfig(configFile, internalFlags)
+    val config = traced("read config", configFile.path) { loadConfig(configFile, internalFlags) }
+
+    if (internalFlags.containsKey("config-compile")) {
+        // Only the config snapshot was wanted; see snapshot.kt.
+        printlnErr("Config snapshot: ${configSnapshotFile(configFile) ?: "<none>"}")
+        launchCacheable = false
+        emit("ABORT")
+        return
+    }
 
     val configVersion = config.jaunchVersion
     val jaunchVersion = versionDigits(JAUNCH_VERSION)[0]
@@ -79,11 +106,12 @@ fun main(args: Array<String>) {
 
     // Sort out the arguments, keeping the user-specified runtime and main arguments in a struct. At this point,
     // it may yet be ambiguous whether certain user args belong with the runtime, the main program, or neither.
-    val userArgs = classifyArguments(inputArgs, supportedOptions, vars, hints)
+    val userArgs = traced("classify arguments") { classifyArguments(inputArgs, supportedOptions, vars, hints) }
 
     applyModeHints(config.modes, hints, vars)
 
-    val (launchDirectives, configDirectives) = calculateDirectives(config, hints, vars)
+    val (launchDirectives, configDirectives) = traced("calculate directives") { calculateDirectives(config, hints, vars) }
+    if (configDirectives.any { it !in CACHE_SAFE_DIRECTIVES }) launchCacheable = false
 
     // Declare the global (runtime-agnostic) directives.
     val globalDirectiveFunctions: DirectivesMap = mutableMapOf(
@@ -100,7 +128,9 @@ fun main(args: Array<String>) {
     val nonGlobalDirectives = executeGlobalDirectives(globalDirectiveFunctions,
         configDirectives, userArgs)
 
-    val runtimes = configureRuntimes(config, configFile.dir, configDirectives, launchDirectives, hints, vars)
+    val runtimes = traced("configure runtimes") {
+        configureRuntimes(config, configFile.dir, configDirectives, launchDirectives, hints, vars)
+    }
 
     debugBanner("BUILDING ARGUMENT LISTS")
 
@@ -135,23 +165,30 @@ fun main(args: Array<String>) {
     }
 
     // Finally, execute all the remaining directives! \^_^/
-    executeDirectives(config, nonGlobalDirectives, launchDirectives, runtimes, argsInContext)
+    traced("execute directives") {
+        executeDirectives(config, nonGlobalDirectives, launchDirectives, runtimes, argsInContext)
+    }
+
+    // The launch directives are complete; let the launcher get going while we tidy up.
+    finalizeOutput()
+
+    // Remember the emitted directives, so that identical launches can skip all of the above.
+    saveLaunchCache()
+    traceSpan("configurator", traceStart)
 
     debugBanner("JAUNCH CONFIGURATION COMPLETE")
 }
 
 // -- Program flow functions --
 
-private fun parseArguments(args: Array<String>): Triple<File?, Map<String, String?>, List<String>> {
-    // If a sole `-` argument was given on the CLI, read the arguments from stdin.
-    val theArgs = if (args.size == 1 && args[0] == "-") stdinLines() else args
-
+private fun parseArguments(theArgs: List<String>): Triple<File?, Map<String, String?>, List<String>> {
     // The first argument is the path to the calling executable.
     val executable = theArgs.getOrNull(0)
 
     // Separate internal Jaunch arguments from user arguments.
     val (internalArgs, inputArgs) = theArgs.slice(1..<theArgs.size).partition { arg -> arg.startsWith("--jaunch-") }
     val internalFlags: Map<String, String?> = internalArgs.map { it.substring(9) }.associate { it bisect '=' }
+    initLaunchCache(theArgs, internalFlags["cache"])
 
     // Enable debug mode when --debug flag is present.
     debugMode = inputArgs.contains("--debug") || internalFlags.containsKey("debug")
@@ -180,6 +217,7 @@ private fun discernDirectories(exeFile: File?, internalFlags: Map<String, String
     if (configuratorPath != null) {
         val configuratorFile = File(configuratorPath)
         val configuratorDir = configuratorFile.dir
+        cacheDependsOn(configuratorFile)
         val appDir = discernAppDirFromConfigDir(configuratorDir)
         debug("configuratorFile -> ", configuratorFile)
         debug("configuratorDir -> ", configuratorDir)
@@ -255,6 +293,7 @@ private fun findConfigFileInDirectory(configDir: File, exeFile: File?): File? {
     }.firstNotNullOfOrNull { fileName ->
         val configFile = configDir / "$fileName.toml"
         debug("Looking for config file: $configFile")
+        cacheDependsOn(configFile)
         configFile.takeIf { it.exists }
     }
 }
@@ -290,8 +329,8 @@ private fun parseSupportedOptions(supportedOptions: Iterable<String>): JaunchOpt
  * Initially populated with hints for the current operating system and CPU architecture,
  * but it will grow over the course of the configuration process below.
  */
-private fun createHints(config: JaunchConfig): MutableSet<String> {
-    val hints = mutableSetOf(
+private fun createHints(config: JaunchConfig): Hints {
+    val hints = Hints(
         // Kotlin knows these CPU architectures:
         //   UNKNOWN, ARM32, ARM64, X86, X64, MIPS32, MIPSEL32, WASM32
         //
@@ -335,7 +374,7 @@ private fun classifyArguments(
     inputArgs: List<String>,
     supportedOptions: JaunchOptions,
     vars: Vars,
-    hints: MutableSet<String>
+    hints: Hints
 ): ProgramArgs {
     val userArgs = ProgramArgs()
     val divider = inputArgs.indexOf("--")
@@ -404,7 +443,7 @@ private fun classifyArguments(
 
 private fun applyModeHints(
     modes: Array<String>,
-    hints: MutableSet<String>,
+    hints: Hints,
     vars: Vars
 ) {
     for (mode in vars.calculate(modes, hints)) {
@@ -424,7 +463,7 @@ private fun configureRuntimes(
     configDir: File,
     configDirectives: List<String>,
     launchDirectives: List<String>,
-    hints: MutableSet<String>,
+    hints: Hints,
     vars: Vars
 ): List<RuntimeConfig> {
     // Build the list of enabled runtimes.
@@ -436,11 +475,11 @@ private fun configureRuntimes(
     for (r in runtimes) {
         // Check if this runtime will be used for any launch or config directives.
         if (
-            r.directive in launchDirectives ||
+            launchDirectives.any { launchDirectiveName(it) == r.directive } ||
             configDirectives.any { r.supportedDirectives.containsKey(it) }
         ) {
             debugBanner("CONFIGURING RUNTIME: ${r.directive}")
-            r.configure(configDir, config, hints, vars)
+            traced("configure ${r.directive}") { r.configure(configDir, config, hints, vars) }
         }
         else {
             debugBanner("SKIPPING DORMANT RUNTIME: ${r.directive}")
@@ -455,7 +494,7 @@ private fun configureRuntimes(
         }
         if (needed) {
             debugBanner("CONFIGURING RUNTIME DEPENDENCY: ${r.directive}")
-            r.configure(configDir, config, hints, vars)
+            traced("configure ${r.directive}") { r.configure(configDir, config, hints, vars) }
         }
         else {
             debugBanner("SKIPPING UNNEEDED RUNTIME: ${r.directive}")
@@ -465,10 +504,29 @@ private fun configureRuntimes(
     return runtimes
 }
 
+/** Suffix of a launch directive's name marking it to run concurrently with the ones after it. */
+private const val ASYNC_MARKER = '&'
+
+/** Gets the name of the given launch directive, without argument or [ASYNC_MARKER]. */
+private fun launchDirectiveName(directive: String): String {
+    return directive.substringBefore(':').removeSuffix(ASYNC_MARKER.toString())
+}
+
+/** Marks the last directive block of the given emissions -- the runtime's launch -- as asynchronous. */
+private fun markAsync(emissions: List<String>): List<String> {
+    var last = 0
+    var i = 0
+    while (i < emissions.size) {
+        last = i
+        i += 2 + emissions[i + 1].toInt()
+    }
+    return emissions.toMutableList().also { it[last] += ASYNC_MARKER }
+}
+
 /** Discern directives to perform. */
 private fun calculateDirectives(
     config: JaunchConfig,
-    hints: MutableSet<String>,
+    hints: Hints,
     vars: Vars
 ): Pair<List<String>, List<String>> {
     debugBanner("CALCULATING DIRECTIVES")
@@ -672,7 +730,7 @@ private fun executeDirectives(
     for (directive in configDirectives) {
         var success = false
         val (activatedRuntimes, dormantRuntimes) =
-            runtimes.partition { it.directive in launchDirectives }
+            runtimes.partition { r -> launchDirectives.any { launchDirectiveName(it) == r.directive } }
 
         // First, we try the activated runtimes.
         for (runtime in activatedRuntimes) {
@@ -714,13 +772,16 @@ private fun executeDirectives(
 
         // Parse directive and argument ("SETCWD:/somewhere" -> "SETCWD", "/somewhere").
         val colon = directive.indexOf(':')
-        val directiveName = if (colon >= 0) directive.substring(0, colon) else directive
+        val directiveName = launchDirectiveName(directive)
         val directiveArg = if (colon >= 0) directive.substring(colon + 1) else null
+        // A trailing & asks the launcher to run the directive concurrently ("JVM&").
+        val async = directive.substringBefore(':').endsWith(ASYNC_MARKER)
 
         // Try to match the directive to a runtime.
         val runtime = runtimes.firstOrNull { it.directive == directiveName }
         if (runtime == null) {
             // No associated runtime; just emit the directive directly.
+            if (async) warn("Ignoring $ASYNC_MARKER marker of non-runtime directive $directiveName")
             if (go) {
                 if (directiveArg == null) emit(directiveName, "0")
                 else emit(directiveName, "1", directiveArg)
@@ -729,7 +790,7 @@ private fun executeDirectives(
             // Ask the runtime exactly what should be emitted.
             val (dryRun, emissions) = runtime.launch(argsInContext[runtime.prefix]!!, directiveArg)
             dryRun(dryRun)
-            if (go) emit(*emissions.toTypedArray())
+            if (go) emit(*(if (async) markAsync(emissions) else emissions).toTypedArray())
         }
     }
     if (abort) emit("ABORT")
@@ -762,6 +823,7 @@ private fun printDir(dir: File, dirName: String) {
 
 /** Recursively move over all files in the update subdir. */
 private fun applyUpdate(appDir: File, updateSubDir: File) {
+    cacheDependsOn(updateSubDir)
     if (!updateSubDir.exists) return
 
     fun emit(s: String) { dryRun(s); debug(s) }
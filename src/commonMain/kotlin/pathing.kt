@@ -0,0 +1,178 @@
+// Pathing JARs, which stand in for very long classpaths.
+//
+// Applications with many hundreds of JAR files produce enormous
+// -Djava.class.path arguments, which must travel through the launcher,
+// the launch cache, and debug output, only for the JVM to split them up
+// again. When the jvm.pathing-jar option is enabled, Jaunch instead writes
+// the finalized classpath into the Class-Path attribute of the manifest of
+// an otherwise empty JAR file, and passes only that JAR to the JVM.
+//
+// Pathing JARs are kept in the per-user [CACHE_DIR], named after a key of
+// the classpath elements and their stamps (see [fileStamp]), so that one
+// is only written anew after the classpath or any of its files changes.
+// Only the most recent pathing JARs of each application are kept.
+
+import kotlin.math.min
+
+/** Subdirectory of [CACHE_DIR] in which pathing JARs are kept. */
+private const val PATHING_DIR = "classpath"
+
+/** Pathing JARs older than this many seconds are pruned, to be written anew if still needed. */
+private const val PATHING_MAX_AGE = 30L * 24 * 60 * 60
+
+/** How many pathing JARs to keep per application, e.g. for launches with differing classpaths. */
+private const val PATHING_KEEP = 4
+
+/** Maximum length in bytes of a manifest line, excluding the line break. */
+private const val MANIFEST_LINE_LENGTH = 72
+
+/** The directory of pathing JARs, or null if there is no cache directory. */
+val PATHING_CACHE: File? = CACHE_DIR?.let { File(it) / PATHING_DIR }
+
+/**
+ * Gets a pathing JAR referencing the given classpath elements, writing it if needed.
+ *
+ * @param appId Identifies the launched application, independently of its classpath.
+ * Only the most recent pathing JARs of each application are kept.
+ * @return The pathing JAR, or null if it could not be written.
+ */
+fun pathingJar(appId: String, classpath: List<String>): File? {
+    val cacheDir = PATHING_CACHE ?: return null
+    val classpathFiles = classpath.map(::File)
+    cacheDependsOn(*classpathFiles.toTypedArray())
+    val key = cacheKey(classpathFiles.flatMap { listOf(it.path, fileStamp(it)) })
+    val jar = cacheDir / "$appId-$key.jar"
+
+    // NB: Other launches of the application may be using other pathing JARs
+    // right now, e.g. for other options, so prune only beyond a few of them.
+    pruneCacheFiles(cacheDir, appId, jar, PATHING_KEEP, PATHING_MAX_AGE)
+
+    if (!jar.exists) {
+        debug("Writing pathing JAR ", jar)
+        try {
+            if (!cacheDir.exists && !(cacheDir.dir.mkdir() && cacheDir.mkdir())) return null
+            val manifest = pathingManifest(classpathFiles.map { fileUrl(it.path, it.isDirectory) })
+            val tmpJar = File("${jar.path}.tmp")
+            if (tmpJar.exists) tmpJar.rm()
+            tmpJar.writeBytes(zip("META-INF/MANIFEST.MF", manifest.encodeToByteArray()))
+            if (!tmpJar.mv(jar)) return null
+        }
+        catch (exc: RuntimeException) {
+            debug("Failed to write pathing JAR ", jar, ": ", exc.message ?: exc)
+            return null
+        }
+    }
+    // NB: If the pathing JAR vanishes, the configurator must write it again.
+    cacheDependsOn(jar)
+    return jar
+}
+
+/** Gets the manifest of a pathing JAR whose Class-Path attribute lists the given URLs. */
+fun pathingManifest(urls: List<String>): String {
+    val sb = StringBuilder()
+    sb.append("Manifest-Version: 1.0\r\n")
+    sb.append("Created-By: Jaunch\r\n")
+    // Lines are limited in length; continuation lines begin with a space.
+    val classPath = "Class-Path: ${urls.joinToString(" ")}"
+    sb.append(classPath.substring(0, min(classPath.length, MANIFEST_LINE_LENGTH))).append("\r\n")
+    var i = MANIFEST_LINE_LENGTH
+    while (i < classPath.length) {
+        val end = min(classPath.length, i + MANIFEST_LINE_LENGTH - 1)
+        sb.append(' ').append(classPath, i, end).append("\r\n")
+        i = end
+    }
+    sb.append("\r\n")
+    return sb.toString()
+}
+
+/**
+ * Converts the given absolute path into a `file:` URL, as expected by the Class-Path
+ * manifest attribute. Directory URLs end in a slash, or the JVM treats them as JARs.
+ */
+fun fileUrl(path: String, isDirectory: Boolean): String {
+    var p = path.replace(SLASH, "/")
+    if (!p.startsWith("/")) p = "/$p" // e.g. C:/... on Windows
+    if (isDirectory && !p.endsWith("/")) p += "/"
+    val sb = StringBuilder("file:")
+    for (b in p.encodeToByteArray()) {
+        val c = b.toInt().toChar()
+        if (c in 'A'..'Z' || c in 'a'..'z' || c in '0'..'9' || c in "-._~/:") sb.append(c)
+        else sb.append('%').append(HEX_DIGITS[b.toInt() shr 4 and 0xf]).append(HEX_DIGITS[b.toInt() and 0xf])
+    }
+    return sb.toString()
+}
+
+private const val HEX_DIGITS = "0123456789ABCDEF"
+
+// -- ZIP writing --
+
+/** Creates a ZIP archive containing the given data, uncompressed, as its only entry. */
+fun zip(name: String, data: ByteArray): ByteArray {
+    val nameBytes = name.encodeToByteArray()
+    val crc = crc32(data)
+    val out = ZipWriter()
+
+    // Local file header.
+    out.u32(0x04034b50)
+    out.entryInfo(crc, data.size, nameBytes.size)
+    out.bytes(nameBytes)
+    out.bytes(data)
+
+    // Central directory.
+    val centralStart = out.size
+    out.u32(0x02014b50)
+    out.u16(20) // version made by
+    out.entryInfo(crc, data.size, nameBytes.size)
+    out.u16(0) // comment length
+    out.u16(0) // disk number
+    out.u16(0) // internal attributes
+    out.u32(0) // external attributes
+    out.u32(0) // offset of local header
+    out.bytes(nameBytes)
+    val centralSize = out.size - centralStart
+
+    // End of central directory record.
+    out.u32(0x06054b50)
+    out.u16(0) // this disk
+    out.u16(0) // disk with central directory
+    out.u16(1) // entries on this disk
+    out.u16(1) // entries in total
+    out.u32(centralSize)
+    out.u32(centralStart)
+    out.u16(0) // comment length
+    return out.toByteArray()
+}
+
+/** Computes the CRC-32 checksum of the given data, as used by ZIP archives. */
+fun crc32(data: ByteArray): Int {
+    var crc = -1
+    for (b in data) {
+        crc = crc xor (b.toInt() and 0xff)
+        repeat(8) { crc = if ((crc and 1) != 0) (crc ushr 1) xor 0xedb88320.toInt() else crc ushr 1 }
+    }
+    return crc.inv()
+}
+
+private class ZipWriter {
+    private val buffer = mutableListOf<Byte>()
+    val size: Int get() = buffer.size
+
+    fun u16(value: Int) { repeat(2) { buffer += (value ushr (8 * it)).toByte() } }
+    fun u32(value: Int) { repeat(4) { buffer += (value ushr (8 * it)).toByte() } }
+    fun bytes(data: ByteArray) { buffer += data.asList() }
+    fun toByteArray(): ByteArray = buffer.toByteArray()
+
+    /** Writes the fields shared by local file headers and central directory entries. */
+    fun entryInfo(crc: Int, size: Int, nameLength: Int) {
+        u16(10)         // version needed to extract
+        u16(0)          // flags
+        u16(0)          // compression method: stored
+        u16(0)          // modification time
+        u16(0x21)       // modification date: 1980-01-01
+        u32(crc)
+        u32(size)       // compressed size
+        u32(size)       // uncompressed size
+        u16(nameLength)
+        u16(0)          // extra field length
+    }
+}
@@ -4,7 +4,11 @@ import kotlin.experimental.ExperimentalNativeApi
 
 expect val BUILD_TARGET: String
 
-expect fun execute(command: String): List<String>?
+/**
+ * Runs the given shell command, returning its standard output lines, or null on failure.
+ * If [workingDir] is given, the command runs there, leaving the current directory untouched.
+ */
+expect fun execute(command: String, workingDir: String? = null): List<String>?
 
 expect fun getcwd(): String
 
@@ -14,7 +18,13 @@ expect fun getenv(name: String): String?
 
 expect fun printlnErr(s: String = "")
 
-expect fun stdinLines(): Array<String>
+expect fun stdinLines(): List<String>
+
+/** Reads the next bytes of stdin into the buffer, returning how many were read; 0 at the end of input. */
+expect fun readStdin(buffer: ByteArray): Int
+
+/** Writes the first [length] bytes to stdout, with no buffering nor newline translation. */
+expect fun writeStdout(bytes: ByteArray, length: Int)
 
 expect fun mkdir(path: String): Boolean
 
@@ -22,8 +32,19 @@ data class MemoryInfo(var total: Long? = null, var free: Long? = null)
 
 expect fun memInfo(): MemoryInfo
 
+/** Microseconds since an arbitrary, but system-wide, point in time; see `monotonic_micros` in the C code. */
+expect fun monotonicMicros(): Long
+
+expect fun processId(): Int
+
 expect val USER_HOME: String?
 
+/** The per-user directory where Jaunch keeps its caches, or null if none can be determined. */
+expect val CACHE_DIR: String?
+
+/** The cache directory named by the `JAUNCH_CACHE_DIR` variable, overriding the platform's [CACHE_DIR]. */
+val CACHE_DIR_OVERRIDE: String? = getenv("JAUNCH_CACHE_DIR")?.takeIf { it.isNotEmpty() }
+
 /** The platform-specific symbol for separating elements in a file path: `/` on POSIX or `\` on Windows. */
 expect val SLASH: String
 
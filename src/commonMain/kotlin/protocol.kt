@@ -0,0 +1,154 @@
+// The binary protocol between the native launcher and the configurator.
+//
+// When the native launcher passes PROTOCOL_FLAG after its `-` argument, the
+// input arguments arrive on stdin as length-prefixed records, and the output
+// is emitted in the same way, so that strings may contain any characters --
+// newlines included -- and huge argument lists take linear time to transfer.
+// Otherwise, input and output are text lines; see stdinLines and emit.
+// For details of the format, see the protocol section of common.h.
+//
+// When the configurator runs in-process instead, as a shared library called
+// by the native launcher (see library.kt), no streams are involved at all.
+
+const val PROTOCOL_FLAG = "--jaunch-protocol=2"
+private val PROTOCOL_HEADER = "\u0000JAUNCH2".encodeToByteArray()
+
+/** Binary output record declaring the preceding records final; see [finalizeOutput]. */
+private const val PROTOCOL_FINAL = "\u0000FINAL"
+
+/** How emitted lines reach the native launcher. */
+enum class OutputMode {
+    /** As text lines on stdout. */
+    TEXT,
+    /** As binary records on stdout. */
+    BINARY,
+    /** Returned from an in-process call; see [jaunchConfigure]. */
+    LIBRARY,
+}
+
+var outputMode = OutputMode.TEXT
+    private set
+
+private val output = RecordWriter()
+private val libraryOutput = mutableListOf<String>()
+
+/** Reads the input arguments from stdin as binary records, and switches output to binary records. */
+fun stdinRecords(): List<String> {
+    val records = readRecords(::readStdin)
+    outputMode = OutputMode.BINARY
+    output.header()
+    return records
+}
+
+/** Switches output to collecting lines in memory, for returning them from an in-process call. */
+fun captureOutput() {
+    outputMode = OutputMode.LIBRARY
+    libraryOutput.clear()
+}
+
+/** Gets the lines collected since [captureOutput]. */
+fun capturedOutput(): List<String> = libraryOutput.toList()
+
+/** Appends a record to the output, which is written out by [flushOutput]. */
+fun emitRecord(s: String) {
+    if (outputMode == OutputMode.LIBRARY) libraryOutput += s
+    else output.record(s)
+}
+
+/** Writes out all output records emitted so far. */
+fun flushOutput() {
+    if (outputMode != OutputMode.BINARY) return
+    writeStdout(output.bytes, output.size)
+    output.clear()
+}
+
+/**
+ * Writes out all output records emitted so far, followed by a marker declaring them final,
+ * so that the native launcher can begin the launch while the configurator finishes up.
+ * The launcher ignores anything emitted afterward.
+ */
+fun finalizeOutput() {
+    if (outputMode != OutputMode.BINARY) return
+    output.record(PROTOCOL_FINAL)
+    flushOutput()
+}
+
+/**
+ * Decodes binary protocol input: the header, a record count, and that many records.
+ * The [read] function supplies the next bytes of input, as [readStdin] does.
+ */
+fun readRecords(read: (ByteArray) -> Int): List<String> {
+    val reader = RecordReader(read)
+    val header = reader.bytes(PROTOCOL_HEADER.size)
+    if (header == null || !header.contentEquals(PROTOCOL_HEADER)) fail("Unsupported input protocol")
+    val count = reader.u32() ?: fail("Expected input record count")
+    val records = ArrayList<String>(minOf(count, BUFFER_SIZE))
+    repeat(count) {
+        val length = reader.u32() ?: fail("Truncated input: expected $count records but got ${records.size}")
+        val bytes = reader.bytes(length) ?: fail("Truncated input record #${records.size}")
+        records += bytes.decodeToString()
+    }
+    return records
+}
+
+/** Buffered reading of exact byte counts from a stream. */
+private class RecordReader(private val read: (ByteArray) -> Int) {
+    private val buffer = ByteArray(BUFFER_SIZE)
+    private var pos = 0
+    private var end = 0
+
+    /** Gets the next [count] bytes, or null if the input ends before then. */
+    fun bytes(count: Int): ByteArray? {
+        val result = ByteArray(count)
+        var filled = 0
+        while (filled < count) {
+            if (pos == end) {
+                // NB: Only read once more bytes are needed, so as not to block needlessly.
+                end = read(buffer)
+                pos = 0
+                if (end <= 0) return null
+            }
+            val n = minOf(count - filled, end - pos)
+            buffer.copyInto(result, filled, pos, pos + n)
+            pos += n
+            filled += n
+        }
+        return result
+    }
+
+    /** Gets the next little-endian u32, or null if the input ends or the value exceeds Int.MAX_VALUE. */
+    fun u32(): Int? {
+        val b = bytes(4) ?: return null
+        val value = (0..3).fold(0L) { acc, i -> acc or ((b[i].toLong() and 0xff) shl (8 * i)) }
+        return if (value > Int.MAX_VALUE) null else value.toInt()
+    }
+}
+
+/** A growing buffer of binary protocol output. */
+class RecordWriter {
+    var bytes = ByteArray(BUFFER_SIZE)
+        private set
+    var size = 0
+        private set
+
+    fun header() = append(PROTOCOL_HEADER)
+
+    fun record(s: String) {
+        val data = s.encodeToByteArray()
+        val length = data.size
+        append(ByteArray(4) { i -> (length ushr (8 * i)).toByte() })
+        append(data)
+    }
+
+    fun clear() { size = 0 }
+
+    private fun append(data: ByteArray) {
+        if (size + data.size > bytes.size) {
+            var capacity = bytes.size
+            while (size + data.size > capacity) capacity *= 2
+            bytes = bytes.copyOf(capacity)
+        }
+        data.copyInto(bytes, size)
+        size += data.size
+    }
+}
@@ -1,6 +1,7 @@
 // Logic for discovery and inspection of Python installations.
 
-import kotlin.math.min
+/** Persistent index of Python installation properties, keyed on the interpreter and its packages. */
+val PYTHON_INDEX = InstallationIndex("python-index")
 
 data class PythonConstraints(
     val configDir: File,
@@ -18,6 +19,9 @@ class PythonRuntimeConfig(recognizedArgs: Array<String>) :
     RuntimeConfig("python", "PYTHON", recognizedArgs)
 {
     var python: PythonInstallation? = null
+    /** The script of the Python zygote, or null if the zygote is disabled (see python.zygote). */
+    var zygoteScript: File? = null
+    val preloadModules = mutableListOf<String>()
 
     override val supportedDirectives: DirectivesMap = mutableMapOf(
         "print-python-home" to { _ -> printlnErr(pythonHome()) },
@@ -27,18 +31,21 @@ class PythonRuntimeConfig(recognizedArgs: Array<String>) :
     override fun configure(
         configDir: File,
         config: JaunchConfig,
-        hints: MutableSet<String>,
+        hints: Hints,
         vars: Vars
     ) {
         // Calculate all the places to search for Python.
         val appDir = vars["app-dir"] as String
         val pythonRootPaths = vars.calculate(config.pythonRootPaths, hints)
                 .flatMap { glob(it) }
+                .also { prefetchStats(it) }
                 .map {
                     // Relativize beneath app-dir as appropriate.
                     if (File(it).isDirectory) it
                     else (File(appDir) / it).path
                 }
+                .also { prefetchStats(it) }
+                .onEach { cacheDependsOn(File(it)) }
                 .filter { File(it).isDirectory }
                 .toSet()
 
@@ -63,23 +70,23 @@ class PythonRuntimeConfig(recognizedArgs: Array<String>) :
             osAliases, archAliases, config.targetOS, config.targetArch,
         )
 
-        // Discover Python.
+        // Discover Python. Candidates are probed concurrently,
+        // but the first conforming one in priority order wins.
         debug()
         debug("Discovering Python installations...")
-        var python: PythonInstallation? = null
-        for (pythonPath in pythonRootPaths) {
-            debug("Analyzing candidate Python directory: '", pythonPath, "'")
-            val pythonCandidate = PythonInstallation(pythonPath, constraints)
-            if (pythonCandidate.conforms) {
-                // Installation looks good! Moving on.
-                python = pythonCandidate
-                break
-            }
+        val pythonCandidates = pythonRootPaths.map { PythonInstallation(it, constraints) }
+        val pythonIndex = firstMatchConcurrently(pythonCandidates) { pythonCandidate ->
+            debug("Analyzing candidate Python directory: '", pythonCandidate.rootPath, "'")
+            pythonCandidate.binPython?.let { cacheDependsOn(File(it)) }
+            traced("probe Python", pythonCandidate.rootPath) { pythonCandidate.conforms }
         }
+        PYTHON_INDEX.save()
+        val python = pythonCandidates.getOrNull(pythonIndex)
         if (python == null) {
             debug("No Python installation found.")
             return
         }
+        python.libPythonPath?.let { cacheDependsOn(File(it)) }
         debug("Successfully discovered Python installation:")
         debug("* rootPath -> ", python.rootPath)
         debug("* binPython -> ", python.binPython ?: "<null>")
@@ -89,10 +96,7 @@ class PythonRuntimeConfig(recognizedArgs: Array<String>) :
         val majorMinor = python.majorMinorVersion
         if (majorMinor != null) {
             val (major, minor) = majorMinor
-            hints += "PYTHON:$major.$minor"
-            // If minor version is OVER 9000, something went wrong in the parsing.
-            // Let's not explode the hints set with too many bogus values.
-            for (v in 0..min(minor, 9000)) hints += "PYTHON:$major.$v+"
+            hints.setVersion("PYTHON", major, minor)
         }
         debug("* hints -> ", hints)
 
@@ -111,6 +115,17 @@ class PythonRuntimeConfig(recognizedArgs: Array<String>) :
         mainArgs += vars.calculate(config.pythonMainArgs, hints)
         debugList("Main arguments calculated:", mainArgs)
 
+        // Calculate the zygote, and the modules for it to preload.
+        if (config.pythonZygote == true) {
+            val script = configDir / "zygote.py"
+            cacheDependsOn(script)
+            if (script.exists) zygoteScript = script
+            else warn("zygote.py not found at: ", configDir.path)
+        }
+        debug("Python zygote: ", zygoteScript ?: "<disabled>")
+        preloadModules += vars.calculate(config.pythonPreloadModules, hints)
+        debugList("Preload modules calculated:", preloadModules)
+
         this.python = python
         configured = true
     }
@@ -119,7 +134,8 @@ class PythonRuntimeConfig(recognizedArgs: Array<String>) :
         return listOf(
             config.pythonRuntimeArgs,
             config.pythonScriptPath,
-            config.pythonMainArgs
+            config.pythonMainArgs,
+            config.pythonPreloadModules,
         )
     }
 
@@ -151,6 +167,11 @@ class PythonRuntimeConfig(recognizedArgs: Array<String>) :
         val lines = buildList {
             add(libPythonPath)
             add(binPython)
+            // NB: The zygote lines are the zygote script, then its preload modules.
+            val zygote = zygoteScript?.let { listOf(it.path) + preloadModules } ?: emptyList()
+            add(zygote.size.toString())
+            addAll(zygote)
+            add(args.runtime.size.toString())
             addAll(args.runtime)
             if (mainProgram != null) add(mainProgram!!)
             addAll(args.main)
@@ -176,6 +197,11 @@ class PythonRuntimeConfig(recognizedArgs: Array<String>) :
  *
  * This class contains heuristics for discerning the Python installation's version
  * and installed packages, by invoking the Python binary and reading the output.
+ *
+ * Because invoking Python is slow -- especially with many packages installed --
+ * the output is recorded in the persistent [PYTHON_INDEX], keyed on the Python
+ * binary plus its site-packages and `*.dist-info` directories, so that it is
+ * only harvested again once the interpreter or its installed packages change.
  */
 class PythonInstallation(
     rootPath: String,
@@ -187,7 +213,7 @@ class PythonInstallation(
     val osName: String? by lazy { guessOperatingSystemName() }
     val cpuArch: String? by lazy { guessCpuArchitecture() }
     val packages: Map<String, String> by lazy { guessInstalledPackages() }
-    val props: Map<String, String>? by lazy { askPythonForProperties() }
+    val props: Map<String, String>? by lazy { indexedProperties() }
 
     /** Gets the major.minor version digits of the Python installation. */
     val majorMinorVersion: Pair<Int, Int>?
@@ -253,6 +279,7 @@ class PythonInstallation(
     }
 
     private fun findBinPython(): String? {
+        prefetchStats(constraints.exeSuffixes.map { "$rootPath$SLASH$it" })
         for (candidate in constraints.exeSuffixes) {
             val pythonFile = File("$rootPath$SLASH$candidate")
             if (pythonFile.exists) return pythonFile.path
@@ -289,6 +316,34 @@ class PythonInstallation(
         return guess("installed packages") { extractPackages(props) }
     }
 
+    /** Gets the Python properties from the [PYTHON_INDEX], or harvests and records them. */
+    private fun indexedProperties(): Map<String, String>? {
+        val pythonExe = binPython
+        // NB: PYTHONPATH changes the visible packages without touching any key file.
+        val pythonPath = getenv("PYTHONPATH")
+        cacheDependsOnEnv("PYTHONPATH", pythonPath)
+        if (pythonExe == null || pythonPath != null) return askPythonForProperties()
+
+        val propsScript = constraints.configDir / "props.py"
+        PYTHON_INDEX.lookup(rootPath, listOf(File(pythonExe), propsScript))?.get("props")?.let {
+            debug("Using indexed Python properties")
+            return it
+        }
+        val props = askPythonForProperties() ?: return null
+        PYTHON_INDEX.store(rootPath, indexKeyFiles(pythonExe, propsScript, props), "props", props)
+        return props
+    }
+
+    /** Files whose stamps reveal changes to the interpreter or its installed packages. */
+    private fun indexKeyFiles(pythonExe: String, propsScript: File, props: Map<String, String>): List<File> {
+        // NB: Missing site directories are key files too, in case they get created later.
+        val siteDirs = listOfNotNull(props["paths.purelib"], props["paths.platlib"], props["site.user_site"])
+            .filter { it != "None" }.distinct().map(::File)
+        val distInfoDirs = siteDirs.filter { it.isDirectory }
+            .flatMap { dir -> dir.ls().filter { it.name.endsWith(".dist-info") } }
+        return listOf(File(pythonExe), propsScript) + siteDirs + distInfoDirs
+    }
+
     /** Calls `python props.py` to receive Python environment details from the boss. */
     private fun askPythonForProperties(): Map<String, String>? {
         val pythonExe = binPython
@@ -296,23 +351,20 @@ class PythonInstallation(
             debug("Python executable does not exist.")
             return null
         }
+        // NB: No need to launch a process, if a better installation has already won.
+        if (probeAbandoned()) return null
 
-        // NB: Temporarily change the current working directory to the one containing
-        // the props.py helper program. This lets us invoke the python executable
-        // in a simpler way, avoiding quoting complexity, especially on Windows.
-        val cwd = getcwd()
-        setcwd(constraints.configDir.path)
-
+        // NB: Run the python executable from the directory containing the props.py
+        // helper program. This lets us invoke it in a simpler way, avoiding quoting
+        // complexity, especially on Windows. We do not change our own working directory
+        // to do so, because other installations may be probed concurrently.
         debug("Invoking `\"", pythonExe, "\" props.py`...")
-        val propsExists = File("props.py").exists
+        val propsExists = (constraints.configDir / "props.py").exists
         if (!propsExists) warn("props.py not found at: ", constraints.configDir.path)
         val stdout: List<String>? =
-            if (propsExists) execute("\"$pythonExe\" props.py")
+            if (propsExists) execute("\"$pythonExe\" props.py", constraints.configDir.path)
             else null
 
-        // NB: Restore original working directory.
-        setcwd(cwd)
-
         return if (stdout == null) null else linesToMap(stdout, "=")
     }
 
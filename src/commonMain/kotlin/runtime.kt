@@ -17,6 +17,7 @@ abstract class RuntimeConfig(
     val mainArgs = mutableListOf<String>()
     var mainProgram: String? = null
     var configured = false
+    private val recognizedIndex by lazy { ArgumentIndex(recognizedArgs) }
 
     /** Dictionary of supported directives and their associated implementations. */
     abstract val supportedDirectives: DirectivesMap
@@ -34,7 +35,7 @@ abstract class RuntimeConfig(
     abstract fun configure(
         configDir: File,
         config: JaunchConfig,
-        hints: MutableSet<String>,
+        hints: Hints,
         vars: Vars
     )
 
@@ -64,13 +65,7 @@ abstract class RuntimeConfig(
      *
      * @return a non-negative integer as described above.
      */
-    fun recognizes(arg: String): Int {
-        return recognizedArgs.map {
-            val tokens = it.split(" ")
-            val number = tokens.size
-            if (number > 0 && argMatches(tokens[0], arg)) number else 0
-        }.firstOrNull { it > 0 } ?: 0
-    }
+    fun recognizes(arg: String): Int = recognizedIndex.arity(arg)
 
     /**
      * Check if this runtime depends on the given dependency runtime.
@@ -102,17 +97,61 @@ abstract class RuntimeConfig(
     protected fun maybeAssign(vars: Vars, key: String, value: Any?) {
         if (value != null) vars["$prefix.$key"] = value
     }
+}
 
-    private fun argMatches(expected: String, actual: String): Boolean {
-        return when {
-            expected.isEmpty() -> false
-            expected.endsWith("*") -> {
-                val prefix = expected.substring(0, expected.length - 1)
-                actual.startsWith(prefix)
+/**
+ * An index of recognized arguments, such as `-Xmx*` or `-c cmd`, for classifying
+ * user arguments in time proportional to their length, however many are recognized.
+ *
+ * Each recognized argument is a pattern -- either exact, or ending in `*` to match
+ * any argument with that prefix -- followed by the names of its space-separated
+ * parameters, if any. When several patterns match, the first one listed wins.
+ */
+class ArgumentIndex(recognizedArgs: Array<String>) {
+    /** A match: the position of the pattern among the recognized arguments, and its arity. */
+    private class Entry(val order: Int, val arity: Int)
+
+    /** A node of the prefix trie, holding the first wildcard pattern ending there. */
+    private class Node {
+        val children = HashMap<Char, Node>()
+        var entry: Entry? = null
+    }
+
+    private val exact = HashMap<String, Entry>()
+    private val prefixes = Node()
+
+    init {
+        recognizedArgs.forEachIndexed { order, recognized ->
+            val tokens = recognized.split(" ")
+            val pattern = tokens[0]
+            val entry = Entry(order, tokens.size)
+            when {
+                pattern.isEmpty() -> {}
+                pattern.endsWith("*") -> {
+                    var node = prefixes
+                    for (c in pattern.substring(0, pattern.length - 1)) node = node.children.getOrPut(c) { Node() }
+                    if (node.entry == null) node.entry = entry
+                }
+                pattern !in exact -> exact[pattern] = entry
             }
-            else -> expected == actual
         }
     }
+
+    /**
+     * Gets the number of arguments taken by the given argument, i.e. 1 plus its number
+     * of parameters, or 0 if it is not recognized; see [RuntimeConfig.recognizes].
+     */
+    fun arity(arg: String): Int {
+        var best = exact[arg]
+        var node: Node? = prefixes
+        var i = 0
+        while (node != null) {
+            val entry = node.entry
+            if (entry != null && (best == null || entry.order < best.order)) best = entry
+            node = if (i < arg.length) node.children[arg[i++]] else null
+        }
+        return best?.arity ?: 0
+    }
 }
 
 abstract class RuntimeInstallation(
@@ -0,0 +1,262 @@
+// Configuration snapshots, sparing the configurator from parsing TOML on every launch.
+//
+// Reading the configuration means tokenizing every TOML file, following its
+// includes -- globs included -- and merging the results, even though the
+// files almost never change. So after reading them, the configurator stores
+// the merged JaunchConfig as a snapshot in the per-user [CACHE_DIR], along
+// with the stamps (see [fileStamp]) of every file and directory the reading
+// visited. As long as none of those stamps change, later runs load the
+// snapshot with a single read instead.
+//
+// Snapshots are written whenever the configuration is read without warnings,
+// and can be written ahead of time, e.g. at installation, by passing the
+// --jaunch-config-compile flag; see [loadConfig].
+//
+// The snapshot format is a sequence of length-prefixed records, as written
+// by [RecordWriter]: a header, the Jaunch version, the dependencies with their
+// stamps, then each JaunchConfig field, in declaration order, as a tagged value.
+
+/** Subdirectory of [CACHE_DIR] in which configuration snapshots are kept. */
+private const val SNAPSHOT_DIR = "config"
+
+private const val SNAPSHOT_HEADER = "JAUNCH-CONFIG-4"
+
+// Tags of snapshot values.
+private const val TAG_NULL = 'n'
+private const val TAG_STRING = 's'
+private const val TAG_BOOLEAN = 'b'
+private const val TAG_INT = 'i'
+private const val TAG_LIST = 'l'
+private const val TAG_MAP = 'm'
+
+/** The directory of configuration snapshots, or null if there is no cache directory. */
+val SNAPSHOT_CACHE: File? = CACHE_DIR?.let { File(it) / SNAPSHOT_DIR }
+
+/** Gets the snapshot file for the given configuration file, or null if there is no cache directory. */
+fun configSnapshotFile(configFile: File): File? {
+    // NB: The home directory matters, since includes may contain `~`.
+    return SNAPSHOT_CACHE?.let { it / "${cacheKey(listOf(configFile.path, USER_HOME ?: ""))}.bin" }
+}
+
+/**
+ * Reads the configuration rooted at the given TOML file, from its snapshot if still valid,
+ * or else from the TOML files themselves, in which case a new snapshot is written.
+ *
+ * If the `config-compile` internal flag is set, the TOML files are always read,
+ * and a failure to write the snapshot is reported.
+ */
+fun loadConfig(configFile: File, internalFlags: Map<String, String?>): JaunchConfig {
+    val snapshotFile = configSnapshotFile(configFile)
+    val compile = internalFlags.containsKey("config-compile")
+    if (snapshotFile != null && !compile) {
+        val snapshot = readConfigSnapshot(snapshotFile)
+        if (snapshot != null) {
+            val (config, dependencies) = snapshot
+            debug("Loaded config snapshot: ", snapshotFile)
+            cacheDependsOn(*dependencies.map(::File).toTypedArray())
+            return config.copy(internalFlags = internalFlags)
+        }
+    }
+
+    val warnings = warningCount
+    val (config, dependencies) = recordingDependencies { readConfig(configFile, internalFlags) }
+    // NB: Warnings about the configuration should be seen on every launch.
+    if (snapshotFile == null || warningCount != warnings) {
+        if (compile) warn("Not writing config snapshot for $configFile")
+        return config
+    }
+    debug("Writing config snapshot: ", snapshotFile)
+    try {
+        writeCacheFile(snapshotFile, encodeConfigSnapshot(config, dependencies.associateWith { fileStamp(File(it)) }))
+    }
+    catch (exc: IllegalArgumentException) {
+        debug("Failed to encode config snapshot: ", exc.message ?: exc)
+    }
+    if (compile && !snapshotFile.exists) warn("Failed to write config snapshot: $snapshotFile")
+    return config
+}
+
+/**
+ * Reads the given snapshot, if its stamps are all current.
+ * @return The configuration, without internal flags, plus the paths it depends on;
+ * or null if the snapshot is missing, stale, or malformed.
+ */
+fun readConfigSnapshot(snapshotFile: File): Pair<JaunchConfig, List<String>>? {
+    if (!snapshotFile.isFile) return null
+    val bytes = try {
+        snapshotFile.readBytes()
+    }
+    catch (exc: RuntimeException) {
+        debug("Failed to read config snapshot ", snapshotFile, ": ", exc.message ?: exc)
+        return null
+    }
+    val (config, stamps) = decodeConfigSnapshot(bytes) ?: run {
+        debug("Ignoring malformed config snapshot: ", snapshotFile)
+        return null
+    }
+    val stale = stamps.entries.firstOrNull { (path, stamp) -> fileStamp(File(path)) != stamp }
+    if (stale != null) {
+        debug("Config snapshot is stale due to ", stale.key)
+        return null
+    }
+    return Pair(config, stamps.keys.toList())
+}
+
+/** Encodes the given configuration, minus its internal flags, plus the stamps it depends on. */
+fun encodeConfigSnapshot(config: JaunchConfig, stamps: Map<String, String>): ByteArray {
+    val out = RecordWriter()
+    out.record(SNAPSHOT_HEADER)
+    out.record("$JAUNCH_VERSION/$JAUNCH_BUILD")
+    out.record(stamps.size.toString())
+    stamps.forEach { (path, stamp) -> out.record(path); out.record(stamp) }
+    with(config) {
+        listOf(
+            jaunchVersion, programName, includes, supportedOptions, osAliases, archAliases,
+            modes, directives, allowUnrecognizedArgs,
+            pythonEnabled, pythonRecognizedArgs, pythonRootPaths, pythonExeSuffixes,
+            pythonVersionMin, pythonVersionMax, pythonPackages, pythonRuntimeArgs,
+            pythonScriptPath, pythonMainArgs, pythonPreloadModules, pythonZygote,
+            jvmEnabled, jvmRecognizedArgs, jvmAllowWeirdRuntimes, jvmVersionMin, jvmVersionMax,
+            jvmDistrosAllowed, jvmDistrosBlocked, jvmRootPaths, jvmLibSuffixes, jvmClasspath,
+            jvmMaxHeap, jvmMainStackSize, jvmExitMode, jvmPathingJar, jvmClassDataCache,
+            jvmRuntimeArgs, jvmMainClass, jvmMainArgs,
+            cfgVars,
+        ).forEach { out.value(it) }
+    }
+    return out.bytes.copyOf(out.size)
+}
+
+/**
+ * Decodes a snapshot written by [encodeConfigSnapshot] of this same Jaunch build.
+ * @return The configuration plus its stamps, or null if the snapshot is malformed or foreign.
+ */
+fun decodeConfigSnapshot(bytes: ByteArray): Pair<JaunchConfig, Map<String, String>>? {
+    val r = SnapshotReader(bytes)
+    return try {
+        if (r.record() != SNAPSHOT_HEADER || r.record() != "$JAUNCH_VERSION/$JAUNCH_BUILD") return null
+        val stamps = linkedMapOf<String, String>()
+        repeat(r.count()) { stamps[r.record()] = r.record() }
+        val config = JaunchConfig(
+            jaunchVersion = r.int(),
+            programName = r.string(),
+            includes = r.array(),
+            supportedOptions = r.array(),
+            osAliases = r.array(),
+            archAliases = r.array(),
+            modes = r.array(),
+            directives = r.array(),
+            allowUnrecognizedArgs = r.boolean(),
+            pythonEnabled = r.boolean(),
+            pythonRecognizedArgs = r.array(),
+            pythonRootPaths = r.array(),
+            pythonExeSuffixes = r.array(),
+            pythonVersionMin = r.string(),
+            pythonVersionMax = r.string(),
+            pythonPackages = r.array(),
+            pythonRuntimeArgs = r.array(),
+            pythonScriptPath = r.array(),
+            pythonMainArgs = r.array(),
+            pythonPreloadModules = r.array(),
+            pythonZygote = r.boolean(),
+            jvmEnabled = r.boolean(),
+            jvmRecognizedArgs = r.array(),
+            jvmAllowWeirdRuntimes = r.boolean(),
+            jvmVersionMin = r.string(),
+            jvmVersionMax = r.string(),
+            jvmDistrosAllowed = r.array(),
+            jvmDistrosBlocked = r.array(),
+            jvmRootPaths = r.array(),
+            jvmLibSuffixes = r.array(),
+            jvmClasspath = r.array(),
+            jvmMaxHeap = r.string(),
+            jvmMainStackSize = r.string(),
+            jvmExitMode = r.string(),
+            jvmPathingJar = r.boolean(),
+            jvmClassDataCache = r.boolean(),
+            jvmRuntimeArgs = r.array(),
+            jvmMainClass = r.array(),
+            jvmMainArgs = r.array(),
+            cfgVars = r.map(),
+        )
+        if (r.atEnd) Pair(config, stamps) else null
+    }
+    catch (exc: MalformedSnapshotException) {
+        null
+    }
+}
+
+/** Appends a tagged value: null, or a string, boolean, integer, array, list or map thereof. */
+private fun RecordWriter.value(v: Any?) {
+    when (v) {
+        null -> record("$TAG_NULL")
+        is String -> record("$TAG_STRING$v")
+        is Boolean -> record("$TAG_BOOLEAN${if (v) 1 else 0}")
+        is Int -> record("$TAG_INT$v")
+        is Array<*> -> value(v.asList())
+        is List<*> -> {
+            record("$TAG_LIST${v.size}")
+            v.forEach { value(it) }
+        }
+        is Map<*, *> -> {
+            record("$TAG_MAP${v.size}")
+            v.forEach { (key, item) -> record(key.toString()); value(item) }
+        }
+        else -> throw IllegalArgumentException("Unsupported snapshot value: $v [${v::class.simpleName}]")
+    }
+}
+
+private class MalformedSnapshotException : RuntimeException()
+
+/** Reads the records of a snapshot, throwing [MalformedSnapshotException] on anything amiss. */
+private class SnapshotReader(private val bytes: ByteArray) {
+    private var pos = 0
+
+    val atEnd: Boolean get() = pos == bytes.size
+
+    fun record(): String {
+        if (bytes.size - pos < 4) throw MalformedSnapshotException()
+        val length = (0..3).fold(0L) { acc, i -> acc or ((bytes[pos + i].toLong() and 0xff) shl (8 * i)) }
+        if (length > bytes.size - pos - 4) throw MalformedSnapshotException()
+        val start = pos + 4
+        pos = start + length.toInt()
+        return bytes.decodeToString(start, pos)
+    }
+
+    fun count(): Int = record().toIntOrNull()?.takeIf { it >= 0 } ?: throw MalformedSnapshotException()
+
+    fun value(): Any? {
+        val r = record()
+        if (r.isEmpty()) throw MalformedSnapshotException()
+        val payload = r.substring(1)
+        return when (r[0]) {
+            TAG_NULL -> null
+            TAG_STRING -> payload
+            TAG_BOOLEAN -> payload == "1"
+            TAG_INT -> payload.toIntOrNull() ?: throw MalformedSnapshotException()
+            TAG_LIST -> List(size(payload)) { value() }
+            TAG_MAP -> buildMap { repeat(size(payload)) { put(record(), value() ?: throw MalformedSnapshotException()) } }
+            else -> throw MalformedSnapshotException()
+        }
+    }
+
+    fun string(): String? = value()?.let { it as? String ?: throw MalformedSnapshotException() }
+    fun boolean(): Boolean? = value()?.let { it as? Boolean ?: throw MalformedSnapshotException() }
+    fun int(): Int? = value()?.let { it as? Int ?: throw MalformedSnapshotException() }
+
+    fun array(): Array<String> {
+        val list = value() as? List<*> ?: throw MalformedSnapshotException()
+        return Array(list.size) { list[it] as? String ?: throw MalformedSnapshotException() }
+    }
+
+    fun map(): Map<String, Any> {
+        val map = value() as? Map<*, *> ?: throw MalformedSnapshotException()
+        return map.entries.associate { (k, v) -> k as String to v!! }
+    }
+
+    private fun size(payload: String): Int {
+        val size = payload.toIntOrNull() ?: throw MalformedSnapshotException()
+        // NB: Every element takes at least one record, so a larger size must be bogus.
+        if (size < 0 || size > bytes.size - pos) throw MalformedSnapshotException()
+        return size
+    }
+}
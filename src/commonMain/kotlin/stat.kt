@@ -0,0 +1,81 @@
+// Per-run cache of file metadata, beneath the File class.
+//
+// Discovering runtime installations means checking many candidate paths --
+// root paths, libjvm suffixes, python executables -- and asking each of them
+// several questions: does it exist, is it a directory, what are its stamps.
+// Rather than one system call per question, each path is examined once per
+// configurator run, with a single `stat` (or its Windows equivalent), and the
+// answers are remembered in the [StatCache]. Jaunch's own modifications of
+// files (writing, moving, deleting) discard the affected entries.
+//
+// On slow file systems, such as network-mounted home directories, examining
+// many paths one after another adds up; see [prefetchStats].
+
+/** Metadata of a path, as gathered by one examination; see [statPath]. */
+data class FileStat(
+    val exists: Boolean,
+    val isFile: Boolean,
+    val isDirectory: Boolean,
+    val length: Long,
+    /** Time of last modification, in seconds since the epoch. */
+    val lastModified: Long,
+    /** Time of last modification, in nanoseconds since the epoch, as precise as the platform records it. */
+    val lastModifiedNanos: Long,
+    /** Time of last access, in seconds since the epoch, as far as the file system keeps track. */
+    val lastAccessed: Long,
+    /** File serial number (inode), or 0 if the platform has none. */
+    val inode: Long,
+) {
+    companion object {
+        val MISSING = FileStat(false, false, false, 0, 0, 0, 0, 0)
+    }
+}
+
+/** Examines the given path afresh, bypassing the [StatCache]. */
+expect fun statPath(path: String): FileStat
+
+/** Examinations taking longer than this many microseconds suggest a slow file system. */
+private const val SLOW_STAT_MICROS = 1000L
+
+/** The file metadata gathered during this configurator run, keyed on canonical path. */
+object StatCache {
+    private val entries = HashMap<String, FileStat>()
+    // NB: Installations may be probed concurrently; see firstMatchConcurrently.
+    private val lock = SpinLock()
+
+    /** Gets the metadata of the given path, examining it only if not yet known. */
+    operator fun get(path: String): FileStat {
+        lock.withLock { entries[path] }?.let { return it }
+        val stat = statPath(path)
+        return lock.withLock { entries.getOrPut(path) { stat } }
+    }
+
+    operator fun contains(path: String): Boolean = lock.withLock { path in entries }
+
+    /** Forgets the metadata of the given path, e.g. because it was just modified. */
+    fun invalidate(path: String) {
+        lock.withLock { entries.remove(path) }
+    }
+
+    /** Forgets all metadata. */
+    fun clear() {
+        lock.withLock { entries.clear() }
+    }
+}
+
+/**
+ * Examines the given paths ahead of time, so that subsequent checks of them are answered
+ * from the [StatCache]. If examining the first path not yet known proves slow, the others
+ * are examined concurrently; otherwise, they are left to be examined lazily, as needed,
+ * since sequential checks which stop at the first match are then cheapest.
+ */
+fun prefetchStats(paths: Collection<String>) {
+    val unknown = paths.map { File(it).path }.filter { it !in StatCache }.distinct()
+    if (unknown.size < 2) return
+    val start = monotonicMicros()
+    StatCache[unknown.first()]
+    val elapsed = monotonicMicros() - start
+    if (elapsed < SLOW_STAT_MICROS) return
+    debug("Examining ", unknown.size - 1, " more paths concurrently, after ", elapsed, " us for ", unknown.first())
+    forEachConcurrently(unknown.drop(1)) { StatCache[it] }
+}
@@ -0,0 +1,129 @@
+// Helpers for doing work concurrently within the configurator.
+
+import kotlin.concurrent.atomics.AtomicInt
+import kotlin.concurrent.atomics.ExperimentalAtomicApi
+import kotlin.math.min
+import kotlin.native.concurrent.ObsoleteWorkersApi
+import kotlin.native.concurrent.ThreadLocal
+import kotlin.native.concurrent.TransferMode
+import kotlin.native.concurrent.Worker
+
+/** Maximum number of threads with which to probe runtime installations. */
+const val PROBE_THREADS = 4
+
+/**
+ * A minimal mutual exclusion lock, for guarding brief accesses to shared state.
+ * Waiting threads spin rather than sleep, so never hold it across anything slow,
+ * such as launching a process.
+ */
+@OptIn(ExperimentalAtomicApi::class)
+class SpinLock {
+    private val locked = AtomicInt(0)
+
+    fun <T> withLock(block: () -> T): T {
+        while (!locked.compareAndSet(0, 1)) { /* spin */ }
+        try {
+            return block()
+        }
+        finally {
+            locked.store(0)
+        }
+    }
+}
+
+/**
+ * Finds the first of the given items, in list order, which satisfies the predicate.
+ *
+ * The predicate is evaluated for several items concurrently, using up to [threads]
+ * threads (including the calling one). Items are started in list order, and once
+ * an item is satisfied, no items after it are started anymore; results of items
+ * after it which are already underway are discarded. Hence, the outcome is the
+ * same as when evaluating the items one by one, just sooner. Discarded items can
+ * notice so via [probeAbandoned], to stop early.
+ *
+ * Whatever the predicate reports (see [debug], [warn]) is held back, then written
+ * out once the search is done for the items up to the match only, in list order.
+ * So discarded items neither interleave nor issue warnings.
+ *
+ * @return the index of the first satisfying item, or -1 if there is none.
+ */
+@OptIn(ObsoleteWorkersApi::class)
+fun <T> firstMatchConcurrently(items: List<T>, threads: Int = PROBE_THREADS, predicate: (T) -> Boolean): Int {
+    val search = PrioritySearch(items, predicate)
+    val workers = List((min(threads, items.size) - 1).coerceAtLeast(0)) { Worker.start(name = "jaunch-probe-$it") }
+    val futures = workers.map { it.execute(TransferMode.SAFE, { search }) { s -> s.run() } }
+    search.run()
+    futures.forEach { it.result }
+    workers.forEach { it.requestTermination().result }
+    val last = search.bestIndex.takeIf { it >= 0 } ?: items.lastIndex
+    for (i in 0..last) search.reports[i]?.let(::replayReports)
+    search.failure?.let { throw it }
+    return search.bestIndex
+}
+
+/** The search and item index of the predicate evaluation running on the current thread, if any. */
+@ThreadLocal
+private var currentProbe: Pair<PrioritySearch<*>, Int>? = null
+
+/**
+ * Whether the predicate evaluation running on the current thread, as part of a
+ * [firstMatchConcurrently] search, has been outranked by a match of higher priority,
+ * so that its result will be discarded. Slow predicates can check this before each
+ * expensive step, and give up.
+ */
+fun probeAbandoned(): Boolean = currentProbe?.let { (search, i) -> search.outranked(i) } ?: false
+
+/**
+ * Performs the given action for each of the given items, using up to [threads]
+ * threads (including the calling one). Items are started in list order, but may
+ * finish in any order. If an action fails, its thread stops taking on items,
+ * and the first failure is rethrown once all threads are done.
+ */
+fun <T> forEachConcurrently(items: List<T>, threads: Int = PROBE_THREADS, action: (T) -> Unit) {
+    // NB: A search in which no item ever matches visits every item.
+    firstMatchConcurrently(items, threads) { action(it); false }
+}
+
+/** Shared state of a [firstMatchConcurrently] search, consumed by each participating thread. */
+@OptIn(ExperimentalAtomicApi::class)
+private class PrioritySearch<T>(val items: List<T>, val predicate: (T) -> Boolean) {
+    private val next = AtomicInt(0)
+    private val best = AtomicInt(items.size)
+    private val lock = SpinLock()
+    var failure: Throwable? = null
+        private set
+    /** What each started item reported; see [holdingReports]. */
+    val reports = arrayOfNulls<List<HeldReport>>(items.size)
+
+    val bestIndex: Int get() = best.load().let { if (it < items.size) it else -1 }
+
+    fun outranked(i: Int) = i > best.load()
+
+    fun run() {
+        while (true) {
+            val i = next.fetchAndAdd(1)
+            // Stop once there are no more items of higher priority than the best match.
+            if (i >= items.size || outranked(i)) return
+            val held = mutableListOf<HeldReport>()
+            reports[i] = held
+            val outer = currentProbe
+            currentProbe = this to i
+            val satisfied = try {
+                holdingReports(held) { predicate(items[i]) }
+            }
+            catch (t: Throwable) {
+                lock.withLock { if (failure == null) failure = t }
+                return
+            }
+            finally {
+                currentProbe = outer
+            }
+            if (!satisfied) continue
+            // Record the match, unless an item of higher priority has already matched.
+            while (true) {
+                val b = best.load()
+                if (i >= b || best.compareAndSet(b, i)) break
+            }
+        }
+    }
+}
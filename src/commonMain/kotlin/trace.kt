@@ -0,0 +1,80 @@
+// Chrome trace events measuring the configurator's startup phases.
+//
+// When the JAUNCH_TRACE environment variable names a file, the configurator
+// appends one event per phase to it, alongside the events of the native
+// launcher which spawned it. See trace.h for details of the format.
+
+import kotlin.concurrent.atomics.AtomicInt
+import kotlin.concurrent.atomics.ExperimentalAtomicApi
+import kotlin.native.concurrent.ThreadLocal
+
+private val traceFile: File? = getenv("JAUNCH_TRACE")?.takeIf { it.isNotEmpty() }?.let { File(it) }
+private var traceStarted = false
+// NB: Phases may be traced while probing installations concurrently.
+private val traceLock = SpinLock()
+
+@OptIn(ExperimentalAtomicApi::class)
+private val traceThreadCount = AtomicInt(0)
+
+/** Small number identifying the current thread in trace events. */
+@OptIn(ExperimentalAtomicApi::class)
+@ThreadLocal
+private val traceThreadId = traceThreadCount.incrementAndFetch()
+
+/** Gets the start time of a phase to trace, or 0 when not tracing. */
+fun traceNow(): Long = if (traceFile == null) 0 else monotonicMicros()
+
+/**
+ * Records a phase which started at the given time (see [traceNow]) and ends now.
+ * The optional detail (e.g. an installation path) is attached to the event's args.
+ */
+fun traceSpan(name: String, start: Long, detail: String? = null) {
+    val file = traceFile ?: return
+    val end = monotonicMicros()
+    val event = buildString {
+        append("{\"name\":${jsonString(name)},\"cat\":\"configurator\",\"ph\":\"X\"")
+        append(",\"ts\":$start,\"dur\":${end - start},\"pid\":${processId()},\"tid\":$traceThreadId")
+        if (detail != null) append(",\"args\":{\"detail\":${jsonString(detail)}}")
+        append("},\n")
+    }
+    traceLock.withLock {
+        try {
+            if (!traceStarted) {
+                traceStarted = true
+                if (!file.exists || file.length == 0L) file.write("[\n")
+                // NB: When running in-process, the process is the native launcher's.
+                if (outputMode != OutputMode.LIBRARY) {
+                    file.write("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":${processId()}," +
+                        "\"args\":{\"name\":\"jaunch configurator\"}},\n")
+                }
+            }
+            file.write(event)
+        }
+        catch (exc: RuntimeException) {
+            debug("Failed to write trace event: ", exc.message ?: exc)
+        }
+    }
+}
+
+/** Runs the given block, tracing it as a phase of the given name. */
+fun <T> traced(name: String, detail: String? = null, block: () -> T): T {
+    val start = traceNow()
+    try {
+        return block()
+    }
+    finally {
+        traceSpan(name, start, detail)
+    }
+}
+
+private fun jsonString(s: String): String = buildString {
+    append('"')
+    for (c in s) {
+        when {
+            c == '"' || c == '\\' -> append("\\$c")
+            c < ' ' -> append("\\u${c.code.toString(16).padStart(4, '0')}")
+            else -> append(c)
+        }
+    }
+    append('"')
+}
@@ -7,6 +7,8 @@ class Vars(
     cfgVars: Map<String, Any>
 ) {
     private val varMap = mutableMapOf<String, Any>()
+    // NB: Config arrays are compiled once, keyed on array identity.
+    private val compiledRules = HashMap<Array<String>, HintRules>()
 
     init {
         varMap["app-dir"] = appDir.path
@@ -21,6 +23,7 @@ class Vars(
         var cfgName = exeFile?.base?.name
         while (cfgName != null) {
             val cfgFile = configDir / "$cfgName.cfg"
+            cacheDependsOn(cfgFile)
             if (cfgFile.exists) cfgFiles += cfgFile
             val dash = cfgName.lastIndexOf("-")
             cfgName = if (dash < 0) null else cfgName.substring(0, dash)
@@ -37,12 +40,12 @@ class Vars(
         }
     }
 
-    fun calculate(item: String?, hints: Set<String>): String? {
-        return if (item == null) null else calculate(arrayOf(item), hints)[0]
+    fun calculate(item: String?, hints: Hints): String? {
+        return if (item == null) null else evaluate(HintRules(arrayOf(item)), hints).getOrNull(0)
     }
 
-    fun calculate(items: Array<String>, hints: Set<String>): List<String> {
-        return items.mapNotNull { it.evaluate(hints) }.filter { it.isNotEmpty() }
+    fun calculate(items: Array<String>, hints: Hints): List<String> {
+        return evaluate(compiledRules.getOrPut(items) { HintRules(items) }, hints)
     }
 
     fun interpolateInto(args: MutableList<String>) {
@@ -77,20 +80,9 @@ class Vars(
     operator fun set(varName: String, value: Any) { varMap[varName] = value }
     operator fun plusAssign(items: Map<String, Any>) { varMap += items }
 
-    private fun String.evaluate(hints: Set<String>): String? {
-        val tokens = split('|')
-        val rules = tokens.subList(0, tokens.lastIndex)
-        val value = tokens.last()
-
-        // Check that all rules apply.
-        for (rule in rules) {
-            val negation = rule.startsWith('!')
-            val hint = if (negation) rule.substring(1) else rule
-            if (hint in hints == negation) return null
-        }
-
-        // Line matches all rules. Populate variable values and return the result.
-        return interpolate(value)
+    /** Populates variable values into the lines whose rules all apply. */
+    private fun evaluate(rules: HintRules, hints: Hints): List<String> {
+        return rules.evaluate(hints).map { interpolate(it) }.filter { it.isNotEmpty() }
     }
 
     /** Replaces `${var}` expressions with values from the vars map. */
@@ -113,7 +105,7 @@ class Vars(
             // If the variable name is missing from the map, check for an environment variable.
             // If no environment variable either, then just leave the expression alone.
             val name = s.substring(start + 2, end)
-            append(varMap[name] ?: getenv(name) ?: s.substring(start, end + 1))
+            append(varMap[name] ?: env(name) ?: s.substring(start, end + 1))
 
             // Advance the position beyond the variable expression.
             pos = end + 1
@@ -123,4 +115,10 @@ class Vars(
     override fun toString(): String {
         return varMap.toString()
     }
+
+    private fun env(name: String): String? {
+        val value = getenv(name)
+        cacheDependsOnEnv(name, value)
+        return value
+    }
 }
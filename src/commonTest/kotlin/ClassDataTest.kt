@@ -0,0 +1,55 @@
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertNotEquals
+import kotlin.test.assertNull
+
+/** Tests `cds.kt` functions. */
+class ClassDataTest {
+
+    @Test
+    fun testClassDataSuffix() {
+        assertNull(classDataSuffix(8))
+        assertNull(classDataSuffix(17))
+        assertEquals("jsa", classDataSuffix(19))
+        assertEquals("jsa", classDataSuffix(21))
+        assertEquals("aot", classDataSuffix(25))
+    }
+
+    @Test
+    fun testClassDataArgs() {
+        val archive = File("no-such-dir${SLASH}app-0123456789abcdef.jsa")
+        assertEquals(emptyList(), classDataArgs(17, archive))
+        assertEquals(
+            listOf("-XX:SharedArchiveFile=${archive.path}", "-XX:+AutoCreateSharedArchive"),
+            classDataArgs(21, archive)
+        )
+        // Not yet recorded, so the first run records the cache.
+        assertEquals(listOf("-XX:AOTCacheOutput=${archive.path}"), classDataArgs(25, archive))
+    }
+
+    @Test
+    fun testClassDataKeyArgs() {
+        val args = listOf(
+            "-Xmx4g", "-Dfoo=bar", "--add-opens=java.base/java.lang=ALL-UNNAMED", "-Djaunch.exit-mode=fast",
+            "--module-path", "/app/mods", "--add-modules=ALL-MODULE-PATH", "-javaagent:/app/agent.jar",
+            "-Djava.class.path=/app/lib/a.jar",
+        )
+        // Heap sizes, properties and the like must not split the cache.
+        assertEquals(
+            listOf("--module-path", "/app/mods", "--add-modules=ALL-MODULE-PATH", "-javaagent:/app/agent.jar"),
+            classDataKeyArgs(args)
+        )
+        assertEquals(emptyList(), classDataKeyArgs(listOf("-Xmx2g", "-Dfoo=bar")))
+    }
+
+    @Test
+    fun testCacheKey() {
+        val key = cacheKey(listOf("/opt/jdk-21", "21.0.2", "/app/lib/a.jar"))
+        assertEquals(16, key.length)
+        assertEquals(key, cacheKey(listOf("/opt/jdk-21", "21.0.2", "/app/lib/a.jar")))
+        assertNotEquals(key, cacheKey(listOf("/opt/jdk-21", "21.0.3", "/app/lib/a.jar")))
+        assertNotEquals(cacheKey(listOf("ab", "c")), cacheKey(listOf("a", "bc")))
+        // FNV-1a offset basis, for no input at all.
+        assertEquals("cbf29ce484222325", cacheKey(emptyList()))
+    }
+}
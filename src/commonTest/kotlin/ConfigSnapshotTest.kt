@@ -0,0 +1,74 @@
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertNotNull
+import kotlin.test.assertNull
+
+/** Tests `snapshot.kt` functions. */
+class ConfigSnapshotTest {
+
+    private val config = JaunchConfig(
+        jaunchVersion = 2,
+        programName = "Fizzbuzz",
+        supportedOptions = arrayOf("--heap,--mem=<max>|Maximum heap size", ""),
+        allowUnrecognizedArgs = false,
+        jvmEnabled = true,
+        jvmRootPaths = arrayOf("~/.sdkman/candidates/java/*", "line one\nline two"),
+        jvmMaxHeap = "75%",
+        pythonPreloadModules = arrayOf("numpy"),
+        pythonZygote = true,
+        cfgVars = mapOf("cfg.max-heap" to "1g", "cfg.enabled" to true, "cfg.count" to 3, "cfg.list" to listOf("a", 1)),
+        internalFlags = mapOf("debug" to null),
+    )
+
+    private val stamps = mapOf("/app/fizzbuzz.toml" to "1700000000:1234:42", "/app/jaunch" to "-")
+
+    @Test
+    fun testRoundTrip() {
+        val (decoded, decodedStamps) = assertNotNull(decodeConfigSnapshot(encodeConfigSnapshot(config, stamps)))
+        assertEquals(stamps, decodedStamps)
+        assertEquals(2, decoded.jaunchVersion)
+        assertEquals("Fizzbuzz", decoded.programName)
+        assertContentEquals(config.supportedOptions, decoded.supportedOptions)
+        assertEquals(false, decoded.allowUnrecognizedArgs)
+        assertNull(decoded.pythonEnabled)
+        assertEquals(true, decoded.jvmEnabled)
+        assertContentEquals(config.jvmRootPaths, decoded.jvmRootPaths)
+        assertContentEquals(emptyArray(), decoded.jvmClasspath)
+        assertContentEquals(arrayOf("numpy"), decoded.pythonPreloadModules)
+        assertEquals(true, decoded.pythonZygote)
+        assertEquals("75%", decoded.jvmMaxHeap)
+        assertEquals(config.cfgVars, decoded.cfgVars)
+        // Internal flags are per-run, and not part of the snapshot.
+        assertEquals(emptyMap(), decoded.internalFlags)
+    }
+
+    @Test
+    fun testMalformed() {
+        val bytes = encodeConfigSnapshot(config, stamps)
+        assertNull(decodeConfigSnapshot(ByteArray(0)))
+        assertNull(decodeConfigSnapshot(bytes.copyOf(bytes.size - 1)))
+        assertNull(decodeConfigSnapshot(bytes + bytes))
+        assertNull(decodeConfigSnapshot("JAUNCH-CONFIG-4".encodeToByteArray()))
+    }
+
+    @Test
+    fun testStale() {
+        val toml = tempDir / "jaunch-snapshot-${processId()}.toml"
+        val snapshot = File("${toml.path}.bin")
+        try {
+            toml.write("jaunch-version = 2\n")
+            snapshot.writeBytes(encodeConfigSnapshot(config, mapOf(toml.path to fileStamp(toml))))
+            val (loaded, dependencies) = assertNotNull(readConfigSnapshot(snapshot))
+            assertEquals("Fizzbuzz", loaded.programName)
+            assertEquals(listOf(toml.path), dependencies)
+
+            toml.write("program-name = 'Other'\n")
+            assertNull(readConfigSnapshot(snapshot))
+        }
+        finally {
+            if (toml.exists) toml.rm()
+            if (snapshot.exists) snapshot.rm()
+        }
+    }
+}
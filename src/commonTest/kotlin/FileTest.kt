@@ -45,6 +45,17 @@ class FileTest {
         assertFalse(nonExistent.isDirectory)
         assertFalse(nonExistent.isFile)
         assertFalse(nonExistent.isRoot)
+        assertEquals(0, nonExistent.lastModified)
+        assertEquals(0, nonExistent.lastModifiedNanos)
+        assertEquals(0, nonExistent.lastAccessed)
+    }
+
+    @Test
+    fun testLastModified() {
+        assertTrue(File(".").lastModified > 0)
+        assertEquals(File(".").lastModified, File("").lastModified)
+        assertEquals(File(".").lastModified, File(".").lastModifiedNanos / 1_000_000_000L)
+        assertTrue(File(".").lastAccessed > 0)
     }
 
     @Test
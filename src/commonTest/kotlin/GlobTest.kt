@@ -0,0 +1,89 @@
+import kotlin.test.*
+
+/** Tests `glob.kt` behavior. */
+class GlobTest {
+    private fun tempDir(name: String): File {
+        val dir = tempDir / "jaunch-$name-${processId()}"
+        deleteTree(dir)
+        assertTrue(dir.mkdir())
+        return dir
+    }
+
+    private fun deleteTree(file: File) {
+        if (!file.exists) return
+        listDir(file.path)?.forEach { deleteTree(file / it.name) }
+        if (file.isDirectory) file.rmdir() else file.rm()
+    }
+
+    private fun touch(file: File) {
+        if (!file.dir.exists) file.dir.mkdir()
+        file.write("")
+    }
+
+    @Test
+    fun testNamePattern() {
+        assertTrue(NamePattern("*.jar").matches("foo.jar"))
+        assertFalse(NamePattern("*.jar").matches("foo.jar.bak"))
+        assertTrue(NamePattern("lib-*-*.jar").matches("lib-1.2-sources.jar"))
+        assertFalse(NamePattern("lib-*-*.jar").matches("lib-1.2.jar"))
+        assertTrue(NamePattern("a*a").matches("aa"))
+        assertFalse(NamePattern("a*a").matches("a"))
+        assertTrue(NamePattern("*").matches(".hidden"))
+        // Characters other than * are matched literally.
+        assertTrue(NamePattern("[x]+(y)?.jar*").matches("[x]+(y)?.jar"))
+        assertFalse(NamePattern("a.c*").matches("abc"))
+    }
+
+    @Test
+    fun testGlob() {
+        val root = tempDir("glob")
+        try {
+            listOf("a.jar", "b.jar", "c.txt", "sub/d.jar", "sub/deeper/e.jar", "zed/f.jar")
+                .forEach { touch(root / it) }
+            val r = root.path
+
+            assertEquals(listOf("$r${SLASH}a.jar", "$r${SLASH}b.jar"), glob("$r/*.jar"))
+            assertEquals(listOf("$r${SLASH}sub${SLASH}d.jar", "$r${SLASH}zed${SLASH}f.jar"), glob("$r/*/*.jar"))
+            assertEquals(
+                listOf("a.jar", "b.jar", "sub/d.jar", "sub/deeper/e.jar", "zed/f.jar").map { "$r$SLASH${it.replace("/", SLASH)}" },
+                glob("$r/**/*.jar")
+            )
+            assertEquals(listOf("$r${SLASH}sub${SLASH}deeper${SLASH}e.jar"), glob("$r/**/deeper/*.jar"))
+            assertEquals(9, glob("$r/**").size) // 6 files plus 3 directories
+            assertEquals(emptyList(), glob("$r/nothing/*.jar"))
+            assertEquals(listOf("$r${SLASH}plain.jar"), glob("$r/plain.jar"))
+        }
+        finally {
+            deleteTree(root)
+        }
+    }
+
+    /** Microbenchmark: globbing over a tree of 10000 entries. */
+    @Test
+    fun testGlobPerformance() {
+        if (!microbenchmarksEnabled) return
+        val root = tempDir("glob-bench")
+        try {
+            for (d in 0 until 100) {
+                for (f in 0 until 99) touch(root / "dir-$d" / "lib-$f.jar")
+                touch(root / "dir-$d" / "README.txt")
+            }
+            val r = root.path
+            val patterns = mapOf(
+                "$r/**/*.jar" to 9900,
+                "$r/*/lib-1*.jar" to 1100,
+                "$r/dir-42/*" to 100,
+            )
+            val runs = 10
+            for ((pattern, expected) in patterns) {
+                val start = monotonicMicros()
+                repeat(runs) { assertEquals(expected, glob(pattern).size) }
+                val micros = (monotonicMicros() - start) / runs
+                println("glob ${pattern.substring(r.length)}: $expected matches in ${micros / 1000.0} ms")
+            }
+        }
+        finally {
+            deleteTree(root)
+        }
+    }
+}
@@ -0,0 +1,85 @@
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+/** Tests `hints.kt` classes. */
+class HintsTest {
+
+    @Test
+    fun testVersionRange() {
+        val java11 = VersionRange.parse("JAVA:11+")!!
+        assertTrue(java11.includes(intArrayOf(11)))
+        assertTrue(java11.includes(intArrayOf(21)))
+        assertFalse(java11.includes(intArrayOf(8)))
+
+        val python39 = VersionRange.parse("PYTHON:3.9+")!!
+        assertTrue(python39.includes(intArrayOf(3, 9)))
+        assertTrue(python39.includes(intArrayOf(3, 12)))
+        assertFalse(python39.includes(intArrayOf(3, 8)))
+        // Earlier components must match exactly.
+        assertFalse(python39.includes(intArrayOf(4, 10)))
+
+        assertNull(VersionRange.parse("JAVA:11"))
+        assertNull(VersionRange.parse("--foo+"))
+        assertNull(VersionRange.parse("JAVA:x+"))
+    }
+
+    @Test
+    fun testHints() {
+        val hints = Hints("OS:LINUX", "ARCH:X64")
+        hints += "--debug"
+        assertTrue("--debug" in hints)
+        hints -= "--debug"
+        assertFalse("--debug" in hints)
+        assertEquals("[OS:LINUX, ARCH:X64]", hints.toString())
+
+        assertFalse("JAVA:8+" in hints)
+        hints.setVersion("JAVA", 17)
+        assertTrue("JAVA:17" in hints)
+        assertTrue("JAVA:8+" in hints)
+        assertTrue("JAVA:17+" in hints)
+        assertFalse("JAVA:18+" in hints)
+        assertFalse("JAVA:8" in hints)
+    }
+
+    @Test
+    fun testHintRules() {
+        val rules = HintRules(arrayOf(
+            "always",
+            "OS:LINUX|linux",
+            "!OS:LINUX|not-linux",
+            "JAVA:9+|--add-opens=java.base/java.lang=ALL-UNNAMED",
+            "!JAVA:9+|-Djava.ext.dirs=",
+            "--heap|OS:LINUX|JAVA:11+|-Xmx${'$'}{heap}",
+        ))
+        val hints = Hints("OS:LINUX")
+        assertEquals(listOf("always", "linux", "-Djava.ext.dirs="), rules.evaluate(hints))
+        hints.setVersion("JAVA", 21)
+        hints += "--heap"
+        assertEquals(
+            listOf("always", "linux", "--add-opens=java.base/java.lang=ALL-UNNAMED", "-Xmx${'$'}{heap}"),
+            rules.evaluate(hints)
+        )
+    }
+
+    /** Microbenchmark: evaluating thousands of conditional lines. */
+    @Test
+    fun testHintRulesPerformance() {
+        if (!microbenchmarksEnabled) return
+        val lines = Array(5000) { "--opt-${it % 50}|OS:LINUX|!JAVA:${it % 30}+|value-$it" }
+        val start = monotonicMicros()
+        val rules = HintRules(lines)
+        val compiled = monotonicMicros()
+        val hints = Hints("OS:LINUX", "--opt-7", "--opt-42")
+        hints.setVersion("JAVA", 21)
+        val runs = 100
+        var matches = 0
+        repeat(runs) { matches = rules.evaluate(hints).size }
+        val micros = (monotonicMicros() - compiled) / runs
+        // Lines for --opt-7 and --opt-42 apply unless their JAVA:n+ range includes 21.
+        assertEquals(lines.indices.count { (it % 50 == 7 || it % 50 == 42) && it % 30 > 21 }, matches)
+        println("HintRules: compiled ${lines.size} lines in ${compiled - start} us; evaluated in $micros us")
+    }
+}
@@ -0,0 +1,48 @@
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+/** Tests `pathing.kt` functions. */
+class PathingTest {
+
+    @Test
+    fun testFileUrl() {
+        assertEquals("file:/opt/app/jars/a.jar", fileUrl("/opt/app/jars/a.jar", false))
+        assertEquals("file:/opt/app/classes/", fileUrl("/opt/app/classes", true))
+        assertEquals("file:/opt/my%20app/%C3%BCber%23.jar", fileUrl("/opt/my app/über#.jar", false))
+    }
+
+    @Test
+    fun testPathingManifest() {
+        val urls = List(100) { "file:/opt/app/jars/library-$it.jar" }
+        val manifest = pathingManifest(urls)
+        val lines = manifest.split("\r\n")
+        assertEquals("Manifest-Version: 1.0", lines[0])
+        assertTrue(manifest.endsWith("\r\n\r\n"))
+        assertTrue(lines.all { it.length <= 72 })
+        // Unfolding the continuation lines yields the full attribute.
+        val unfolded = manifest.replace("\r\n ", "").split("\r\n")
+        assertEquals("Class-Path: ${urls.joinToString(" ")}", unfolded[2])
+    }
+
+    @Test
+    fun testCrc32() {
+        assertEquals(0, crc32(ByteArray(0)))
+        assertEquals(0xcbf43926.toInt(), crc32("123456789".encodeToByteArray()))
+    }
+
+    @Test
+    fun testZip() {
+        val data = "Manifest-Version: 1.0\r\n\r\n".encodeToByteArray()
+        val bytes = zip("META-INF/MANIFEST.MF", data)
+        fun u32(offset: Int) = (0 until 4).sumOf { (bytes[offset + it].toInt() and 0xff) shl (8 * it) }
+        // Local file header, then name and data, then central directory, then end record.
+        assertEquals(0x04034b50, u32(0))
+        val centralStart = 30 + 20 + data.size
+        assertEquals(0x02014b50, u32(centralStart))
+        val endStart = centralStart + 46 + 20
+        assertEquals(bytes.size, endStart + 22)
+        assertEquals(0x06054b50, u32(endStart))
+        assertEquals(centralStart, u32(endStart + 16))
+    }
+}
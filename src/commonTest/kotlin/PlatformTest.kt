@@ -12,6 +12,26 @@ class PlatformTest {
         assertEquals("hello", result?.get(0))
     }
 
+    @Test
+    fun testExecuteInWorkingDir() {
+        val cwd = getcwd()
+        val result = execute(if (OS_NAME == "WINDOWS") "cd" else "pwd", userHome())
+        assertEquals(File(userHome()).path, result?.get(0)?.let { File(it).path })
+        assertEquals(cwd, getcwd())
+
+        // The working directory must reach the shell verbatim.
+        val dir = tempDir / "jaunch-it's \$HOME %PATH% `x`-${processId()}"
+        assertTrue(dir.exists || dir.mkdir())
+        try {
+            val quoted = execute(if (OS_NAME == "WINDOWS") "cd" else "pwd", dir.path)
+            assertEquals(dir.path, quoted?.get(0)?.let { File(it).path })
+            assertEquals(cwd, getcwd())
+        }
+        finally {
+            dir.rmdir()
+        }
+    }
+
     @Test
     fun testGetenv() {
         val path = getenv("PATH")
@@ -0,0 +1,58 @@
+import kotlin.test.*
+
+/** Tests `protocol.kt` behavior. */
+class ProtocolTest {
+    /** Encodes input as the native launcher does; see encode_records in common.h. */
+    private fun input(records: List<String>): ByteArray {
+        val writer = RecordWriter()
+        writer.header()
+        val count = records.size
+        val prefix = ByteArray(4) { i -> (count ushr (8 * i)).toByte() }
+        val body = RecordWriter()
+        records.forEach { body.record(it) }
+        return writer.bytes.copyOf(writer.size) + prefix + body.bytes.copyOf(body.size)
+    }
+
+    /** Supplies the given bytes in chunks of at most the given size. */
+    private fun reader(bytes: ByteArray, chunkSize: Int): (ByteArray) -> Int {
+        var pos = 0
+        return { buffer ->
+            val n = minOf(chunkSize, buffer.size, bytes.size - pos)
+            bytes.copyInto(buffer, 0, pos, pos + n)
+            pos += n
+            n
+        }
+    }
+
+    @Test
+    fun testRoundTrip() {
+        val records = listOf("/path/to/app", "--jaunch-configurator=/path/to/jaunch", "",
+            "multi\nline", "spaces  ", "ünicöde ☕")
+        val bytes = input(records)
+        for (chunkSize in listOf(1, 3, 7, BUFFER_SIZE)) {
+            assertEquals(records, readRecords(reader(bytes, chunkSize)))
+        }
+    }
+
+    @Test
+    fun testManyRecords() {
+        val records = List(20000) { "/path/to/lib/library-$it.jar" }
+        assertEquals(records, readRecords(reader(input(records), BUFFER_SIZE)))
+    }
+
+    @Test
+    fun testRecordLayout() {
+        val writer = RecordWriter()
+        writer.record("ab")
+        writer.record("")
+        assertContentEquals(byteArrayOf(2, 0, 0, 0, 'a'.code.toByte(), 'b'.code.toByte(), 0, 0, 0, 0),
+            writer.bytes.copyOf(writer.size))
+    }
+
+    @Test
+    fun testRecordLongerThanBuffer() {
+        val classpath = (0..<10000).joinToString(":") { "/path/to/lib/library-$it.jar" }
+        assertTrue(classpath.length > BUFFER_SIZE)
+        assertEquals(listOf(classpath), readRecords(reader(input(listOf(classpath)), 4096)))
+    }
+}
@@ -0,0 +1,53 @@
+import kotlin.test.Test
+import kotlin.test.assertEquals
+
+/** Tests `runtime.kt` classes. */
+class RuntimeTest {
+
+    @Test
+    fun testArgumentIndex() {
+        val index = ArgumentIndex(arrayOf(
+            "-c cmd",
+            "-m mod",
+            "-X*",
+            "-Xlog:* level",
+            "-XX:*",
+            "--add-opens module/package=target",
+            "-Xmx*",
+            "-verbose",
+            "-verbose:* ",
+            "",
+        ))
+        assertEquals(2, index.arity("-c"))
+        assertEquals(0, index.arity("-cx"))
+        assertEquals(1, index.arity("-verbose"))
+        assertEquals(2, index.arity("--add-opens"))
+        // The first matching pattern wins, even when a later one is longer.
+        assertEquals(1, index.arity("-Xlog:gc"))
+        assertEquals(1, index.arity("-XX:+UseZGC"))
+        assertEquals(1, index.arity("-Xmx2g"))
+        assertEquals(2, index.arity("-verbose:gc"))
+        assertEquals(0, index.arity("--unknown"))
+        assertEquals(0, index.arity(""))
+    }
+
+    @Test
+    fun testArgumentIndexPrefixOrder() {
+        // A shorter wildcard listed later does not override an earlier, longer one.
+        val index = ArgumentIndex(arrayOf("-Dfoo=* value", "-D*"))
+        assertEquals(2, index.arity("-Dfoo=bar"))
+        assertEquals(1, index.arity("-Dbar=baz"))
+        assertEquals(1, index.arity("-D"))
+    }
+
+    /** Microbenchmark: classifying many arguments against many recognized arguments. */
+    @Test
+    fun testArgumentIndexPerformance() {
+        if (!microbenchmarksEnabled) return
+        val index = ArgumentIndex(Array(500) { if (it % 2 == 0) "-opt$it" else "-prefix$it:*" })
+        val args = List(50000) { "/data/input/file-$it.tif" }
+        val start = monotonicMicros()
+        assertEquals(0, args.sumOf { index.arity(it) })
+        println("ArgumentIndex: classified ${args.size} arguments in ${monotonicMicros() - start} us")
+    }
+}
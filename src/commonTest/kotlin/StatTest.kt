@@ -0,0 +1,39 @@
+import kotlin.test.*
+
+/** Tests `stat.kt` behavior. */
+class StatTest {
+    @Test
+    fun testMissing() {
+        assertEquals(FileStat.MISSING, statPath(File("sir-not-appearing-in-this-file-system").path))
+    }
+
+    @Test
+    fun testCacheFollowsModifications() {
+        val file = tempDir / "jaunch-stat-${processId()}.txt"
+        if (file.exists) file.rm()
+        try {
+            assertFalse(file.exists)
+            file.write("hello")
+            assertTrue(file.exists)
+            assertTrue(file.isFile)
+            assertFalse(file.isDirectory)
+            assertEquals(5, file.length)
+            file.writeBytes(", world".encodeToByteArray())
+            assertEquals(12, file.length)
+            assertEquals(statPath(file.path), StatCache[file.path])
+        }
+        finally {
+            file.rm()
+        }
+        assertFalse(file.exists)
+    }
+
+    @Test
+    fun testPrefetch() {
+        val paths = listOf(".", "sir-not-appearing-in-this-file-system", SLASH)
+        prefetchStats(paths)
+        assertTrue(File(".").isDirectory)
+        assertFalse(File(paths[1]).exists)
+        assertTrue(File(SLASH).isDirectory)
+    }
+}
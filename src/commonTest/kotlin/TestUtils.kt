@@ -0,0 +1,12 @@
+// Helpers shared by the unit tests.
+
+/** The system's directory for temporary files, in which tests create their scratch files. */
+val tempDir = File(getenv("TMPDIR") ?: getenv("TEMP") ?: "/tmp")
+
+/**
+ * Whether to run the microbenchmarks, which time hot paths of the configurator
+ * and print their timings. They are skipped unless the `JAUNCH_MICROBENCH`
+ * environment variable is set, since they take a while and measure nothing
+ * the other tests do not check; see the Benchmarks section of doc/PERFORMANCE.md.
+ */
+val microbenchmarksEnabled = getenv("JAUNCH_MICROBENCH") !in listOf(null, "", "0", "false", "FALSE")
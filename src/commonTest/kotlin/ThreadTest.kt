@@ -0,0 +1,75 @@
+import kotlin.concurrent.atomics.AtomicInt
+import kotlin.concurrent.atomics.ExperimentalAtomicApi
+import kotlin.test.*
+
+/** Tests `thread.kt` behavior. */
+class ThreadTest {
+    @Test
+    fun testFirstMatchRespectsPriority() {
+        val items = (0..<20).toList()
+        for (threads in 1..6) {
+            assertEquals(7, firstMatchConcurrently(items, threads) { it >= 7 && it % 7 == 0 })
+        }
+    }
+
+    @Test
+    fun testFirstMatchNone() {
+        assertEquals(-1, firstMatchConcurrently((0..<20).toList()) { false })
+        assertEquals(-1, firstMatchConcurrently(emptyList<Int>()) { true })
+    }
+
+    @OptIn(ExperimentalAtomicApi::class)
+    @Test
+    fun testFirstMatchStopsEarly() {
+        val evaluated = AtomicInt(0)
+        val index = firstMatchConcurrently((0..<1000).toList(), 4) {
+            evaluated.fetchAndAdd(1)
+            it == 3
+        }
+        assertEquals(3, index)
+        assertTrue(evaluated.load() < 1000)
+    }
+
+    @OptIn(ExperimentalAtomicApi::class)
+    @Test
+    fun testForEachVisitsAll() {
+        val sum = AtomicInt(0)
+        forEachConcurrently((1..100).toList(), 4) { sum.fetchAndAdd(it) }
+        assertEquals(5050, sum.load())
+    }
+
+    @Test
+    fun testFirstMatchPropagatesFailure() {
+        assertFailsWith<IllegalStateException> {
+            firstMatchConcurrently((0..<10).toList()) { if (it == 2) error("boom") else false }
+        }
+    }
+
+    @Test
+    fun testFirstMatchDropsDiscardedWarnings() {
+        val before = warningCount
+        val index = firstMatchConcurrently((0..<10).toList(), 4) {
+            if (it != 3) warn("probe ", it)
+            it == 3
+        }
+        assertEquals(3, index)
+        // Only the warnings of items up to the match count.
+        assertEquals(before + 3, warningCount)
+    }
+
+    @Test
+    fun testProbeAbandoned() {
+        assertFalse(probeAbandoned())
+        // The match itself is never outranked.
+        assertEquals(0, firstMatchConcurrently(listOf(0)) { !probeAbandoned() })
+    }
+
+    @Test
+    fun testSpinLock() {
+        val lock = SpinLock()
+        assertEquals(42, lock.withLock { 42 })
+        assertFailsWith<IllegalStateException> { lock.withLock { error("boom") } }
+        // The lock must have been released despite the failure.
+        assertEquals("ok", lock.withLock { "ok" })
+    }
+}
@@ -16,3 +16,17 @@ actual fun mkdir(path: String): Boolean {
     }
     return result == 0
 }
+
+@OptIn(ExperimentalForeignApi::class)
+actual fun modificationNanos(statResult: stat): Long {
+    // NB: This function is here, rather than in posixMain/platform.kt,
+    // because Linux calls the field st_mtim, whereas macOS calls it st_mtimespec.
+    return statResult.st_mtim.tv_sec * 1_000_000_000L + statResult.st_mtim.tv_nsec
+}
+
+@OptIn(ExperimentalForeignApi::class)
+actual fun accessSeconds(statResult: stat): Long = statResult.st_atim.tv_sec
+
+actual val CACHE_DIR: String? = CACHE_DIR_OVERRIDE ?:
+    (getenv("XDG_CACHE_HOME")?.takeIf { it.startsWith("/") } ?: USER_HOME?.let { "$it/.cache" })
+        ?.let { "$it/jaunch" }
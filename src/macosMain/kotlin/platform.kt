@@ -16,3 +16,15 @@ actual fun mkdir(path: String): Boolean {
     }
     return result == 0
 }
+
+@OptIn(ExperimentalForeignApi::class)
+actual fun modificationNanos(statResult: stat): Long {
+    // NB: This function is here, rather than in posixMain/platform.kt,
+    // because macOS calls the field st_mtimespec, whereas Linux calls it st_mtim.
+    return statResult.st_mtimespec.tv_sec * 1_000_000_000L + statResult.st_mtimespec.tv_nsec
+}
+
+@OptIn(ExperimentalForeignApi::class)
+actual fun accessSeconds(statResult: stat): Long = statResult.st_atimespec.tv_sec
+
+actual val CACHE_DIR: String? = CACHE_DIR_OVERRIDE ?: USER_HOME?.let { "$it/Library/Caches/jaunch" }
@@ -5,30 +5,18 @@ import platform.posix.*
 actual class File actual constructor(private val rawPath: String) {
 
     actual val path: String = canonicalize(rawPath)
-    actual val exists: Boolean get() = access(path, F_OK) == 0
+    actual val exists: Boolean get() = StatCache[path].exists
     //actual val canRead: Boolean get() = access(path, R_OK) == 0
     //actual val canWrite: Boolean get() = access(path, W_OK) == 0
     //actual val canExecute: Boolean get() = access(path, X_OK) == 0
-    actual val isFile: Boolean get() = isMode(S_IFREG)
-    actual val isDirectory: Boolean get() = isMode(S_IFDIR)
+    actual val isFile: Boolean get() = StatCache[path].isFile
+    actual val isDirectory: Boolean get() = StatCache[path].isDirectory
     actual val isRoot: Boolean = path == SLASH
-
-    @OptIn(ExperimentalForeignApi::class)
-    actual val length: Long get() = memScoped {
-        val statResult = alloc<stat>()
-        stat(path, statResult.ptr)
-        return statResult.st_size
-    }
-
-    @OptIn(ExperimentalForeignApi::class, UnsafeNumber::class)
-    private fun isMode(modeBits: Int): Boolean {
-        val statMode = memScoped {
-            val statResult = alloc<stat>()
-            stat(path, statResult.ptr)
-            statResult.st_mode.toInt()
-        }
-        return (statMode and modeBits) != 0
-    }
+    actual val length: Long get() = StatCache[path].length
+    actual val lastModified: Long get() = StatCache[path].lastModified
+    actual val lastModifiedNanos: Long get() = StatCache[path].lastModifiedNanos
+    actual val lastAccessed: Long get() = StatCache[path].lastAccessed
+    actual val inode: Long get() = StatCache[path].inode
 
     @OptIn(ExperimentalForeignApi::class)
     actual fun ls(): List<File> {
@@ -57,11 +45,17 @@ actual class File actual constructor(private val rawPath: String) {
         memScoped {
             val file = fopen(path, "r") ?: throw RuntimeException("Failed to open file: $this")
             try {
+                val buffer = ByteArray(BUFFER_SIZE)
+                val line = StringBuilder()
                 while (true) {
-                    val buffer = ByteArray(BUFFER_SIZE)
-                    val line = fgets(buffer.refTo(0), FILENAME_MAX, file)?.toKString() ?: break
-                    lines.add(line)
+                    val chunk = fgets(buffer.refTo(0), buffer.size, file)?.toKString() ?: break
+                    // NB: Lines longer than the buffer arrive in several chunks.
+                    line.append(chunk)
+                    if (!chunk.endsWith("\n")) continue
+                    lines.add(line.toString())
+                    line.clear()
                 }
+                if (line.isNotEmpty()) lines.add(line.toString())
             }
             finally {
                 fclose(file)
@@ -70,6 +64,26 @@ actual class File actual constructor(private val rawPath: String) {
         return lines
     }
 
+    @OptIn(ExperimentalForeignApi::class)
+    actual fun readBytes(): ByteArray {
+        val file = fopen(path, "rb") ?: throw RuntimeException("Failed to open file: $this")
+        try {
+            var bytes = ByteArray(BUFFER_SIZE)
+            var size = 0
+            while (true) {
+                if (size == bytes.size) bytes = bytes.copyOf(2 * bytes.size)
+                val n = bytes.usePinned { fread(it.addressOf(size), 1.convert(), (bytes.size - size).convert(), file) }
+                if (n.toLong() <= 0) break
+                size += n.toInt()
+            }
+            if (ferror(file) != 0) throw RuntimeException("Error reading file: $this")
+            return bytes.copyOf(size)
+        }
+        finally {
+            fclose(file)
+        }
+    }
+
     @OptIn(ExperimentalForeignApi::class)
     actual fun write(s: String) {
         val file = fopen(path, "a") ?:
@@ -79,27 +93,43 @@ actual class File actual constructor(private val rawPath: String) {
         }
         finally {
             fclose(file)
+            StatCache.invalidate(path)
+        }
+    }
+
+    @OptIn(ExperimentalForeignApi::class)
+    actual fun writeBytes(bytes: ByteArray) {
+        val file = fopen(path, "ab") ?:
+            throw RuntimeException("Failed to open file: $this")
+        try {
+            if (bytes.isEmpty()) return
+            val written = bytes.usePinned { fwrite(it.addressOf(0), 1.convert(), bytes.size.convert(), file) }
+            if (written.toLong() != bytes.size.toLong()) throw RuntimeException("Error writing to file: $this")
+        }
+        finally {
+            fclose(file)
+            StatCache.invalidate(path)
         }
     }
 
     @OptIn(ExperimentalForeignApi::class)
     actual fun mv(dest: File): Boolean {
         memScoped {
-            return rename(path, dest.path) == 0
+            return (rename(path, dest.path) == 0).also { StatCache.invalidate(path); StatCache.invalidate(dest.path) }
         }
     }
 
     @OptIn(ExperimentalForeignApi::class)
     actual fun rm(): Boolean {
         memScoped {
-            return remove(path) == 0
+            return (remove(path) == 0).also { StatCache.invalidate(path) }
         }
     }
 
     @OptIn(ExperimentalForeignApi::class)
     actual fun rmdir(): Boolean {
         memScoped {
-            return rmdir(path) == 0
+            return (rmdir(path) == 0).also { StatCache.invalidate(path) }
         }
     }
 
@@ -108,6 +138,51 @@ actual class File actual constructor(private val rawPath: String) {
     }
 }
 
+@OptIn(ExperimentalForeignApi::class, UnsafeNumber::class)
+actual fun statPath(path: String): FileStat = memScoped {
+    val statResult = alloc<stat>()
+    if (stat(path, statResult.ptr) != 0) return FileStat.MISSING
+    val mode = statResult.st_mode.toInt() and S_IFMT
+    return FileStat(
+        exists = true,
+        isFile = mode == S_IFREG,
+        isDirectory = mode == S_IFDIR,
+        length = statResult.st_size,
+        lastModified = modificationNanos(statResult).floorDiv(1_000_000_000L),
+        lastModifiedNanos = modificationNanos(statResult),
+        lastAccessed = accessSeconds(statResult),
+        inode = statResult.st_ino.toLong(),
+    )
+}
+
+// NB: The d_type values of dirent.h, which agree between Linux and macOS.
+private const val TYPE_UNKNOWN = 0
+private const val TYPE_DIRECTORY = 4
+private const val TYPE_SYMLINK = 10
+
+@OptIn(ExperimentalForeignApi::class)
+actual fun listDir(path: String): List<DirEntry>? {
+    val directory = opendir(path) ?: return null
+    val entries = mutableListOf<DirEntry>()
+    try {
+        while (true) {
+            val entry = readdir(directory)?.pointed ?: break
+            val name = entry.d_name.toKString()
+            if (name == "." || name == "..") continue
+            val isDirectory = when (entry.d_type.toInt()) {
+                TYPE_DIRECTORY -> true
+                TYPE_UNKNOWN, TYPE_SYMLINK -> null
+                else -> false
+            }
+            entries += DirEntry(name, isDirectory)
+        }
+    }
+    finally {
+        closedir(directory)
+    }
+    return entries
+}
+
 @OptIn(ExperimentalForeignApi::class)
 private fun canonicalize(path: String): String {
     var p = path
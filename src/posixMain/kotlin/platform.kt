@@ -3,10 +3,11 @@ import platform.posix.*
 import platform.posix.getenv as pGetEnv
 
 @OptIn(ExperimentalForeignApi::class)
-actual fun execute(command: String): List<String>? {
+actual fun execute(command: String, workingDir: String?): List<String>? {
     val stdout = mutableListOf<String>()
 
-    val process = popen(command, "r") ?: return null
+    val shellCommand = if (workingDir == null) command else "cd ${shellQuote(workingDir)} && $command"
+    val process = popen(shellCommand, "r") ?: return null
     memScoped {
         val buffer = allocArray<ByteVar>(BUFFER_SIZE)
         while (true) {
@@ -19,6 +20,9 @@ actual fun execute(command: String): List<String>? {
     return stdout
 }
 
+/** Quotes the given string as a single word for `sh`, which expands nothing within single quotes. */
+private fun shellQuote(s: String) = "'" + s.replace("'", "'\\''") + "'"
+
 @OptIn(ExperimentalForeignApi::class)
 actual fun getcwd(): String {
     return getcwd(null, 0u)?.toKString() ?: ""
@@ -42,22 +46,71 @@ actual fun printlnErr(s: String) {
 }
 
 @OptIn(ExperimentalForeignApi::class)
-actual fun stdinLines(): Array<String> {
-    var lines = emptyArray<String>()
+actual fun stdinLines(): List<String> {
+    val lines = mutableListOf<String>()
     memScoped {
         val buffer = allocArray<ByteVar>(BUFFER_SIZE)
+        fun readLine(): String? {
+            val line = StringBuilder()
+            while (true) {
+                // NB: Lines longer than the buffer arrive in several chunks.
+                val chunk = fgets(buffer, BUFFER_SIZE, stdin)?.toKString() ?: break
+                line.append(chunk)
+                if (chunk.endsWith("\n")) break
+            }
+            return if (line.isEmpty()) null else line.toString()
+        }
         // Passing the line count as the first line lets us stop reading from stdin once we have
         // seen those lines, even though the pipe is still technically open. This avoids deadlocks.
-        val numLines = fgets(buffer, BUFFER_SIZE, stdin)?.toKString()?.trim()?.toInt() ?:
+        val numLines = readLine()?.trim()?.toInt() ?:
             fail("Expected input line count as the first line of input")
         for (i in 0..<numLines) {
-            val input = fgets(buffer, BUFFER_SIZE, stdin)?.toKString()?.trim() ?: break
-            lines += input
+            lines += readLine()?.trim() ?: break
         }
     }
     return lines
 }
 
+@OptIn(ExperimentalForeignApi::class)
+actual fun readStdin(buffer: ByteArray): Int {
+    while (true) {
+        val n = buffer.usePinned { read(STDIN_FILENO, it.addressOf(0), buffer.size.convert()) }
+        if (n < 0 && errno == EINTR) continue
+        return if (n < 0) 0 else n.toInt()
+    }
+}
+
+@OptIn(ExperimentalForeignApi::class)
+actual fun writeStdout(bytes: ByteArray, length: Int) {
+    if (length == 0) return
+    var written = 0
+    bytes.usePinned {
+        while (written < length) {
+            val n = write(STDOUT_FILENO, it.addressOf(written), (length - written).convert())
+            if (n < 0 && errno == EINTR) continue
+            if (n <= 0) throw RuntimeException("Failed to write to stdout")
+            written += n.toInt()
+        }
+    }
+}
+
+@OptIn(ExperimentalForeignApi::class, UnsafeNumber::class)
+actual fun monotonicMicros(): Long = memScoped {
+    val ts = alloc<timespec>()
+    clock_gettime(CLOCK_MONOTONIC.convert(), ts.ptr)
+    return ts.tv_sec.toLong() * 1_000_000L + ts.tv_nsec.toLong() / 1000
+}
+
+actual fun processId(): Int = getpid()
+
+/** Gets the modification time in nanoseconds since the epoch from the given stat struct. */
+@OptIn(ExperimentalForeignApi::class)
+expect fun modificationNanos(statResult: stat): Long
+
+/** Gets the access time in seconds since the epoch from the given stat struct. */
+@OptIn(ExperimentalForeignApi::class)
+expect fun accessSeconds(statResult: stat): Long
+
 @OptIn(ExperimentalForeignApi::class)
 actual fun memInfo(): MemoryInfo {
     val memInfo = MemoryInfo()
@@ -6,15 +6,15 @@ actual class File actual constructor(rawPath: String) {
 
     actual val path: String = canonicalize(rawPath)
 
-    actual val exists: Boolean get() = GetFileAttributesA(path) != INVALID_FILE_ATTRIBUTES
+    actual val exists: Boolean get() = StatCache[path].exists
 
     //actual val canRead: Boolean get() = ...
     //actual val canWrite: Boolean get() = ...
     //actual val canExecute: Boolean get() = ...
 
-    actual val isFile: Boolean get() = isMode(FILE_ATTRIBUTE_NORMAL)
+    actual val isFile: Boolean get() = StatCache[path].isFile
 
-    actual val isDirectory: Boolean get() = isMode(FILE_ATTRIBUTE_DIRECTORY)
+    actual val isDirectory: Boolean get() = StatCache[path].isDirectory
 
     actual val isRoot: Boolean =
         // Is it a drive letter plus backslash (e.g. `C:\`)?
@@ -22,16 +22,14 @@ actual class File actual constructor(rawPath: String) {
           (path[0] in 'a'..'z' || path[0] in 'A'..'Z') &&
           path[1] == ':' && path[2] == '\\'
 
-    @OptIn(ExperimentalForeignApi::class)
-    actual val length: Long get() {
-        val fileHandle = openFile(path) ?: return -1
-        try {
-            return fileSize(fileHandle) ?: -1
-        }
-        finally {
-            CloseHandle(fileHandle)
-        }
-    }
+    actual val length: Long get() = StatCache[path].length
+
+    actual val lastModified: Long get() = StatCache[path].lastModified
+    actual val lastModifiedNanos: Long get() = StatCache[path].lastModifiedNanos
+    actual val lastAccessed: Long get() = StatCache[path].lastAccessed
+
+    // Windows has no inodes.
+    actual val inode: Long get() = 0
 
     @OptIn(ExperimentalForeignApi::class)
     actual fun ls(): List<File> {
@@ -101,12 +99,40 @@ actual class File actual constructor(rawPath: String) {
     }
 
     @OptIn(ExperimentalForeignApi::class)
+    actual fun readBytes(): ByteArray {
+        val fileHandle = openFile(path) ?: throw RuntimeException("Failed to open file: $this")
+        try {
+            var bytes = ByteArray(BUFFER_SIZE)
+            var size = 0
+            memScoped {
+                val bytesRead = alloc<DWORDVar>()
+                while (true) {
+                    if (size == bytes.size) bytes = bytes.copyOf(2 * bytes.size)
+                    val ok = bytes.usePinned {
+                        ReadFile(fileHandle, it.addressOf(size), (bytes.size - size).toUInt(), bytesRead.ptr, null)
+                    }
+                    if (ok == 0) throw RuntimeException("Error reading file '$this': ${lastError()}")
+                    if (bytesRead.value == 0U) break
+                    size += bytesRead.value.toInt()
+                }
+            }
+            return bytes.copyOf(size)
+        }
+        finally {
+            CloseHandle(fileHandle)
+        }
+    }
+
     actual fun write(s: String) {
+        writeBytes(s.encodeToByteArray())
+    }
+
+    @OptIn(ExperimentalForeignApi::class)
+    actual fun writeBytes(bytes: ByteArray) {
         val handle = openFile(path, write = true) ?:
             throw RuntimeException("Failed to open file: $this")
         try {
-            memScoped {
-                val bytes = s.encodeToByteArray()
+            if (bytes.isNotEmpty()) memScoped {
                 bytes.usePinned { pinnedBytes ->
                     val bytesWritten = alloc<UIntVar>()
 
@@ -126,6 +152,7 @@ actual class File actual constructor(rawPath: String) {
         }
         finally {
             CloseHandle(handle)
+            StatCache.invalidate(path)
         }
     }
 
@@ -135,21 +162,21 @@ actual class File actual constructor(rawPath: String) {
             val pathW = path.wcstr.ptr
             val destW = dest.path.wcstr.ptr
             val flags = MOVEFILE_REPLACE_EXISTING.toUInt()
-            return MoveFileEx!!(pathW, destW, flags) != 0
+            return (MoveFileEx!!(pathW, destW, flags) != 0).also { StatCache.invalidate(path); StatCache.invalidate(dest.path) }
         }
     }
 
     @OptIn(ExperimentalForeignApi::class)
     actual fun rm(): Boolean {
         memScoped {
-            return DeleteFileW(path) != 0
+            return (DeleteFileW(path) != 0).also { StatCache.invalidate(path) }
         }
     }
 
     @OptIn(ExperimentalForeignApi::class)
     actual fun rmdir(): Boolean {
         memScoped {
-            return RemoveDirectoryW(path) != 0
+            return (RemoveDirectoryW(path) != 0).also { StatCache.invalidate(path) }
         }
     }
 
@@ -157,10 +184,6 @@ actual class File actual constructor(rawPath: String) {
         return path
     }
 
-    private fun isMode(modeBits: Int): Boolean {
-        val attrs = GetFileAttributesA(path)
-        return attrs != INVALID_FILE_ATTRIBUTES && (attrs.toInt() and modeBits) != 0
-    }
 
     @OptIn(ExperimentalForeignApi::class)
     private fun openFile(path: String, write: Boolean = false): HANDLE? {
@@ -180,16 +203,56 @@ actual class File actual constructor(rawPath: String) {
         }
         return fileHandle
     }
+}
 
-    @OptIn(ExperimentalForeignApi::class)
-    private fun fileSize(fileHandle: HANDLE): Long? = memScoped {
-        val fileSize = alloc<LARGE_INTEGER>()
-        if (GetFileSizeEx(fileHandle, fileSize.ptr) == 0) {
-            warn("Error getting size of file '$this': ${lastError()}")
-            return null
+@OptIn(ExperimentalForeignApi::class)
+actual fun statPath(path: String): FileStat = memScoped {
+    val data = alloc<WIN32_FILE_ATTRIBUTE_DATA>()
+    if (GetFileAttributesExW(path, GetFileExInfoStandard, data.ptr) == 0) return FileStat.MISSING
+    val isDirectory = (data.dwFileAttributes.toInt() and FILE_ATTRIBUTE_DIRECTORY) != 0
+    val ticks = (data.ftLastWriteTime.dwHighDateTime.toLong() shl 32) or
+        data.ftLastWriteTime.dwLowDateTime.toLong()
+    val accessTicks = (data.ftLastAccessTime.dwHighDateTime.toLong() shl 32) or
+        data.ftLastAccessTime.dwLowDateTime.toLong()
+    return FileStat(
+        exists = true,
+        isFile = !isDirectory,
+        isDirectory = isDirectory,
+        length = (data.nFileSizeHigh.toLong() shl 32) or data.nFileSizeLow.toLong(),
+        // Convert 100-nanosecond ticks since 1601 into seconds and nanoseconds since 1970.
+        lastModified = (ticks - 116444736000000000L) / 10000000L,
+        lastModifiedNanos = (ticks - 116444736000000000L) * 100L,
+        lastAccessed = (accessTicks - 116444736000000000L) / 10000000L,
+        inode = 0,
+    )
+}
+
+@OptIn(ExperimentalForeignApi::class)
+actual fun listDir(path: String): List<DirEntry>? {
+    val entries = mutableListOf<DirEntry>()
+    memScoped {
+        val findFileData = alloc<WIN32_FIND_DATAW>()
+        val hFindFile = FindFirstFileW("$path\\*", findFileData.ptr)
+        if (hFindFile == INVALID_HANDLE_VALUE) return null
+
+        try {
+            do {
+                val name = findFileData.cFileName.toKString()
+                if (name == "." || name == "..") continue
+                val attributes = findFileData.dwFileAttributes.toInt()
+                // NB: Reparse points (symlinks, junctions) are reported as unknown.
+                val isDirectory =
+                    if ((attributes and FILE_ATTRIBUTE_REPARSE_POINT) != 0) null
+                    else (attributes and FILE_ATTRIBUTE_DIRECTORY) != 0
+                entries += DirEntry(name, isDirectory)
+            }
+            while (FindNextFileW(hFindFile, findFileData.ptr) != 0)
+        }
+        finally {
+            FindClose(hFindFile)
         }
-        return fileSize.QuadPart
     }
+    return entries
 }
 
 @OptIn(ExperimentalForeignApi::class)
@@ -4,10 +4,12 @@ import platform.posix.getenv as pGetEnv
 import platform.windows.*
 
 @OptIn(ExperimentalForeignApi::class)
-actual fun execute(command: String): List<String>? {
+actual fun execute(command: String, workingDir: String?): List<String>? {
     // Source: https://stackoverflow.com/a/69385366/1207769
     val lines = mutableListOf<String>()
-    val fp = _popen(command, "r") ?: fail("Failed to run command: $command")
+    // NB: Starting with `cd` rather than a quote keeps cmd.exe from stripping the command's quotes.
+    val shellCommand = if (workingDir == null) command else "cd /d ${shellQuote(workingDir)} && $command"
+    val fp = _popen(shellCommand, "r") ?: fail("Failed to run command: $shellCommand")
     val buffer = ByteArray(BUFFER_SIZE)
     while (true) {
         val input = fgets(buffer.refTo(0), buffer.size, fp) ?: break
@@ -17,6 +19,12 @@ actual fun execute(command: String): List<String>? {
     return lines
 }
 
+/**
+ * Quotes the given path as a single word for `cmd.exe`. Paths cannot contain double quotes,
+ * but `cmd.exe` expands `%VAR%` even within them; so each `%` is escaped outside the quotes.
+ */
+private fun shellQuote(s: String) = "\"" + s.replace("%", "\"^%\"") + "\""
+
 @OptIn(ExperimentalForeignApi::class)
 actual fun getcwd(): String {
     memScoped {
@@ -45,22 +53,59 @@ actual fun printlnErr(s: String) {
 }
 
 @OptIn(ExperimentalForeignApi::class)
-actual fun stdinLines(): Array<String> {
-    var lines = emptyArray<String>()
+actual fun stdinLines(): List<String> {
+    val lines = mutableListOf<String>()
     memScoped {
         val buffer = allocArray<ByteVar>(BUFFER_SIZE)
+        fun readLine(): String? {
+            val line = StringBuilder()
+            while (true) {
+                // NB: Lines longer than the buffer arrive in several chunks.
+                val chunk = fgets(buffer, BUFFER_SIZE, stdin)?.toKString() ?: break
+                line.append(chunk)
+                if (chunk.endsWith("\n")) break
+            }
+            return if (line.isEmpty()) null else line.toString()
+        }
         // Passing the line count as the first line lets us stop reading from stdin once we have
         // seen those lines, even though the pipe is still technically open. This avoids deadlocks.
-        val numLines = fgets(buffer, BUFFER_SIZE, stdin)?.toKString()?.trim()?.toInt() ?:
+        val numLines = readLine()?.trim()?.toInt() ?:
             fail("Expected input line count as the first line of input")
         for (i in 0..<numLines) {
-            val input = fgets(buffer, BUFFER_SIZE, stdin)?.toKString()?.trim() ?: break
-            lines += input
+            lines += readLine()?.trim() ?: break
         }
     }
     return lines
 }
 
+@OptIn(ExperimentalForeignApi::class)
+actual fun readStdin(buffer: ByteArray): Int {
+    memScoped {
+        val bytesRead = alloc<DWORDVar>()
+        val success = buffer.usePinned {
+            ReadFile(GetStdHandle(STD_INPUT_HANDLE), it.addressOf(0), buffer.size.convert(), bytesRead.ptr, null)
+        }
+        return if (success == 0) 0 else bytesRead.value.toInt()
+    }
+}
+
+@OptIn(ExperimentalForeignApi::class)
+actual fun writeStdout(bytes: ByteArray, length: Int) {
+    if (length == 0) return
+    memScoped {
+        val handle = GetStdHandle(STD_OUTPUT_HANDLE)
+        val bytesWritten = alloc<DWORDVar>()
+        var written = 0
+        bytes.usePinned {
+            while (written < length) {
+                val success = WriteFile(handle, it.addressOf(written), (length - written).convert(), bytesWritten.ptr, null)
+                if (success == 0) throw RuntimeException("Failed to write to stdout: ${GetLastError()}")
+                written += bytesWritten.value.toInt()
+            }
+        }
+    }
+}
+
 @OptIn(ExperimentalForeignApi::class)
 actual fun mkdir(path: String): Boolean {
     memScoped {
@@ -96,7 +141,21 @@ actual fun memInfo(): MemoryInfo {
     return memInfo
 }
 
+@OptIn(ExperimentalForeignApi::class)
+actual fun monotonicMicros(): Long = memScoped {
+    val counter = alloc<LARGE_INTEGER>()
+    val frequency = alloc<LARGE_INTEGER>()
+    QueryPerformanceCounter(counter.ptr)
+    QueryPerformanceFrequency(frequency.ptr)
+    val ticks = counter.QuadPart
+    val hz = frequency.QuadPart
+    return ticks / hz * 1_000_000L + ticks % hz * 1_000_000L / hz
+}
+
+actual fun processId(): Int = GetCurrentProcessId().toInt()
+
 actual val USER_HOME = getenv("USERPROFILE")
+actual val CACHE_DIR: String? = CACHE_DIR_OVERRIDE ?: getenv("LOCALAPPDATA")?.let { "$it\\jaunch" }
 actual val SLASH = "\\"
 actual val COLON = ";"
 actual val NL = "\r\n"
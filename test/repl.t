@@ -32,6 +32,14 @@ Test help text
                       print path to the selected Java
   --print-java-info
                       print information about the selected Java
+  --print-jvm-cache
+                      print the index of known Java installations
+  --clear-jvm-cache
+                      forget the index of known Java installations
+  --print-class-data-cache
+                      print the class data archives of Java applications
+  --clear-class-data-cache
+                      delete the class data archives of Java applications
   --heap, --mem, --memory <amount>
                       set Java's heap size to <amount> (e.g. 512M or 64%)
   --class-path, --classpath, -classpath, --cp, -cp <path>